@@ -0,0 +1,707 @@
+/*
+ * This file main.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1aot: ahead of time compiler
+//
+//  Translates the code segment of an .l1obj object file into C and builds a shared object:
+//  prog/foo.l1obj -> prog/foo.l1aot.c -> prog/foo.l1aot.so
+//
+//  Every label becomes a native function: S8 l1aot_<epos> (struct jit_context *ctx).
+//  The VM loads the .so next to the object file and runs the native code at these labels.
+//  Opcodes which are not translated (intr0, intr1, stack, jsr, jsra, rts) return their epos,
+//  so the VM runs them in the interpreter.
+
+#include "../include/global.h"
+#include "../include/opcodes.h"
+
+S8 code_hash (U1 *code, S8 start, S8 end);
+size_t strlen_safe (const char * str, int maxlen);
+
+U1 *code = NULL;
+S8 code_size ALIGN = 0;
+
+U1 *code_op = NULL;			// 1 = opcode starts at this epos
+U1 *code_entry = NULL;		// 1 = label: native function at this epos
+
+S8 conv_quadword (S8 val ALIGN)
+{
+	S8 ret ALIGN;
+
+	U1 *valptr = (U1 *) &val;
+	U1 *retptr = (U1 *) &ret;
+
+	#if MACHINE_BIG_ENDIAN
+	*retptr = *valptr;
+	retptr++; valptr++;
+	*retptr = *valptr;
+	retptr++; valptr++;
+	*retptr = *valptr;
+	retptr++; valptr++;
+	*retptr = *valptr;
+	retptr++; valptr++;
+	*retptr = *valptr;
+	retptr++; valptr++;
+	*retptr = *valptr;
+	retptr++; valptr++;
+	*retptr = *valptr;
+	retptr++; valptr++;
+	*retptr = *valptr;
+	#else
+	*retptr = valptr[7];
+	retptr++;
+	*retptr = valptr[6];
+	retptr++;
+	*retptr = valptr[5];
+	retptr++;
+	*retptr = valptr[4];
+	retptr++;
+	*retptr = valptr[3];
+	retptr++;
+	*retptr = valptr[2];
+	retptr++;
+	*retptr = valptr[1];
+	retptr++;
+	*retptr = valptr[0];
+	#endif
+
+	return (ret);
+}
+
+S8 get_quadword (S8 pos)
+{
+	S8 num ALIGN;
+
+	memcpy (&num, &code[pos], sizeof (S8));
+	return (num);
+}
+
+S8 opcode_size (U1 op)
+{
+	// size of opcode with arguments, from the opcode table
+	S8 size ALIGN = 1;
+	S2 j;
+
+	for (j = 0; j < opcode[op].args; j++)
+	{
+		switch (opcode[op].type[j])
+		{
+			case DATA:
+			case DATA_OFFS:
+			case LABEL:
+				size = size + 8;
+				break;
+
+			default:
+				size++;
+				break;
+		}
+	}
+	return (size);
+}
+
+S2 native_opcode (U1 op)
+{
+	// opcodes which are translated into C
+
+	#if MATH_LIMITS || MATH_LIMITS_DOUBLE_FULL
+	// overflow checks are done by the interpreter
+	if ((op >= ADDI && op <= DIVD) || op == SHLI)
+	{
+		return (0);
+	}
+	#endif
+
+	switch (op)
+	{
+		case STPUSHB:
+		case STPOPB:
+		case STPUSHI:
+		case STPOPI:
+		case STPUSHD:
+		case STPOPD:
+		case STPUSHIR:
+		case STPOPIR:
+		case STPUSHDR:
+		case STPOPDR:
+		case INTR0:
+		case INTR1:
+		case JSR:
+		case JSRA:
+		case RTS:
+			return (0);
+	}
+	return (1);
+}
+
+S2 load_code (U1 *name)
+{
+	// load the code segment of the object file
+	FILE *fptr;
+	S8 quadword ALIGN;
+	S8 i ALIGN;
+	S8 j ALIGN;
+	U1 op;
+
+	fptr = fopen ((const char *) name, "r");
+	if (fptr == NULL)
+	{
+		printf ("ERROR: can't open object file '%s'!\n", name);
+		return (1);
+	}
+
+	if (fread (&quadword, sizeof (S8), 1, fptr) != 1 || conv_quadword (quadword) != (S8) 0xC0DEBABE00002019)
+	{
+		printf ("ERROR: wrong header!\n");
+		fclose (fptr);
+		return (1);
+	}
+
+	if (fread (&quadword, sizeof (S8), 1, fptr) != 1)
+	{
+		printf ("ERROR: can't load codesize!\n");
+		fclose (fptr);
+		return (1);
+	}
+	code_size = conv_quadword (quadword);
+	if (code_size <= 16)
+	{
+		printf ("ERROR: no code in object file!\n");
+		fclose (fptr);
+		return (1);
+	}
+
+	code = (U1 *) calloc (code_size, sizeof (U1));
+	code_op = (U1 *) calloc (code_size, sizeof (U1));
+	code_entry = (U1 *) calloc (code_size, sizeof (U1));
+	if (code == NULL || code_op == NULL || code_entry == NULL)
+	{
+		printf ("ERROR: can't allocate %lli bytes for code!\n", code_size);
+		fclose (fptr);
+		return (1);
+	}
+
+	i = 16;
+	while (i < code_size)
+	{
+		if (fread (&op, sizeof (U1), 1, fptr) != 1)
+		{
+			printf ("ERROR: can't load opcode!\n");
+			fclose (fptr);
+			return (1);
+		}
+		if (op >= MAXOPCODES || i + opcode_size (op) > code_size)
+		{
+			printf ("ERROR: unknown opcode %i at epos: %lli!\n", op, i);
+			fclose (fptr);
+			return (1);
+		}
+
+		code_op[i] = 1;
+		code[i] = op;
+		i++;
+
+		for (j = 0; j < opcode[op].args; j++)
+		{
+			switch (opcode[op].type[j])
+			{
+				case DATA:
+				case DATA_OFFS:
+				case LABEL:
+					if (fread (&quadword, sizeof (S8), 1, fptr) != 1)
+					{
+						printf ("ERROR: can't load opcode arg!\n");
+						fclose (fptr);
+						return (1);
+					}
+					quadword = conv_quadword (quadword);
+					memcpy (&code[i], &quadword, sizeof (S8));
+					i = i + 8;
+					break;
+
+				default:
+					if (fread (&code[i], sizeof (U1), 1, fptr) != 1)
+					{
+						printf ("ERROR: can't load opcode arg!\n");
+						fclose (fptr);
+						return (1);
+					}
+					i++;
+					break;
+			}
+		}
+	}
+	fclose (fptr);
+	return (0);
+}
+
+void set_entry (S8 epos)
+{
+	if (epos >= 16 && epos < code_size && code_op[epos] == 1)
+	{
+		code_entry[epos] = 1;
+	}
+}
+
+void find_entries (void)
+{
+	// labels: start of code, jump targets, loadl (jsra, jmpa) and the opcode after a not translated one
+	S8 i ALIGN;
+	U1 op;
+
+	set_entry (16);
+
+	for (i = 16; i < code_size; i = i + opcode_size (op))
+	{
+		op = code[i];
+		switch (op)
+		{
+			case JMP:
+			case JSR:
+			case LOADL:
+				set_entry (get_quadword (i + 1));
+				break;
+
+			case JMPI:
+				set_entry (get_quadword (i + 2));
+				break;
+
+			case INCLSIJMPI:
+			case DECGRIJMPI:
+			case JMPT:
+				set_entry (get_quadword (i + 3));
+				break;
+		}
+
+		if (native_opcode (op) == 0)
+		{
+			set_entry (i + opcode_size (op));
+		}
+	}
+}
+
+void write_jump (FILE *fptr, S8 target)
+{
+	if (target >= 16 && target < code_size && code_entry[target] == 1)
+	{
+		fprintf (fptr, "goto L%lli;\n", target);
+	}
+	else
+	{
+		fprintf (fptr, "return (%lliLL);\n", target);
+	}
+}
+
+void write_bounds (FILE *fptr, const char *start, const char *offset, S8 epos)
+{
+	#if BOUNDSCHECK
+	fprintf (fptr, "\tBOUNDS(%s, %s, %lliLL);\n", start, offset, epos);
+	#endif
+}
+
+void write_opcode (FILE *fptr, S8 e)
+{
+	U1 op = code[e];
+	U1 a = code[e + 1];
+	U1 b = code[e + 2];
+	U1 c = code[e + 3];
+	U1 start[64];
+	U1 offset[64];
+	S8 arg1 ALIGN;
+	S8 arg2 ALIGN;
+
+	// data access sizes of push/pull opcodes
+	static const S2 push_size[5] = { 1, 2, 4, 8, 8 };
+
+	if (native_opcode (op) == 0)
+	{
+		fprintf (fptr, "\treturn (%lliLL);\t// %s\n", e, opcode[op].op);
+		return;
+	}
+
+	switch (op)
+	{
+		case PUSHB:
+		case PUSHW:
+		case PUSHDW:
+		case PUSHQW:
+		case PUSHD:
+			snprintf ((char *) start, 64, "regi[%i]", a);
+			snprintf ((char *) offset, 64, "regi[%i]", b);
+			write_bounds (fptr, (const char *) start, (const char *) offset, e);
+			if (op == PUSHB)
+			{
+				fprintf (fptr, "\tregi[%i] = data[regi[%i] + regi[%i]];\n", c, a, b);
+			}
+			else
+			{
+				if (op == PUSHD)
+				{
+					fprintf (fptr, "\tmemcpy (&regd[%i], &data[regi[%i] + regi[%i]], 8);\n", c, a, b);
+				}
+				else
+				{
+					fprintf (fptr, "\tregi[%i] = 0; memcpy (&regi[%i], &data[regi[%i] + regi[%i]], %i);\n", c, c, a, b, push_size[op - PUSHB]);
+				}
+			}
+			break;
+
+		case PULLB:
+		case PULLW:
+		case PULLDW:
+		case PULLQW:
+		case PULLD:
+			snprintf ((char *) start, 64, "regi[%i]", b);
+			snprintf ((char *) offset, 64, "regi[%i]", c);
+			write_bounds (fptr, (const char *) start, (const char *) offset, e);
+			if (op == PULLB)
+			{
+				fprintf (fptr, "\tdata[regi[%i] + regi[%i]] = regi[%i];\n", b, c, a);
+			}
+			else
+			{
+				if (op == PULLD)
+				{
+					fprintf (fptr, "\tmemcpy (&data[regi[%i] + regi[%i]], &regd[%i], 8);\n", b, c, a);
+				}
+				else
+				{
+					fprintf (fptr, "\tmemcpy (&data[regi[%i] + regi[%i]], &regi[%i], %i);\n", b, c, a, push_size[op - PULLB]);
+				}
+			}
+			break;
+
+		case PUSHWS:
+		case PUSHDWS:
+		case PUSHQWS:
+		case PUSHDS:
+			// scaled index: the offset is index * element size
+			snprintf ((char *) start, 64, "regi[%i]", a);
+			snprintf ((char *) offset, 64, "regi[%i] * %i", b, push_size[op - PUSHWS + 1]);
+			write_bounds (fptr, (const char *) start, (const char *) offset, e);
+			if (op == PUSHDS)
+			{
+				fprintf (fptr, "\tmemcpy (&regd[%i], &data[regi[%i] + %s], 8);\n", c, a, offset);
+			}
+			else
+			{
+				fprintf (fptr, "\tregi[%i] = 0; memcpy (&regi[%i], &data[regi[%i] + %s], %i);\n", c, c, a, offset, push_size[op - PUSHWS + 1]);
+			}
+			break;
+
+		case PULLWS:
+		case PULLDWS:
+		case PULLQWS:
+		case PULLDS:
+			snprintf ((char *) start, 64, "regi[%i]", b);
+			snprintf ((char *) offset, 64, "regi[%i] * %i", c, push_size[op - PULLWS + 1]);
+			write_bounds (fptr, (const char *) start, (const char *) offset, e);
+			if (op == PULLDS)
+			{
+				fprintf (fptr, "\tmemcpy (&data[regi[%i] + %s], &regd[%i], 8);\n", b, offset, a);
+			}
+			else
+			{
+				fprintf (fptr, "\tmemcpy (&data[regi[%i] + %s], &regi[%i], %i);\n", b, offset, a, push_size[op - PULLWS + 1]);
+			}
+			break;
+
+		case ADDI: fprintf (fptr, "\tregi[%i] = regi[%i] + regi[%i];\n", c, a, b); break;
+		case SUBI: fprintf (fptr, "\tregi[%i] = regi[%i] - regi[%i];\n", c, a, b); break;
+		case MULI: fprintf (fptr, "\tregi[%i] = regi[%i] * regi[%i];\n", c, a, b); break;
+
+		case DIVI:
+			#if DIVISIONCHECK
+			// division by zero: the interpreter reports it
+			fprintf (fptr, "\tif (regi[%i] == 0) return (%lliLL);\n", b, e);
+			#endif
+			fprintf (fptr, "\tregi[%i] = regi[%i] / regi[%i];\n", c, a, b);
+			break;
+
+		case ADDD: fprintf (fptr, "\tregd[%i] = regd[%i] + regd[%i];\n", c, a, b); break;
+		case SUBD: fprintf (fptr, "\tregd[%i] = regd[%i] - regd[%i];\n", c, a, b); break;
+		case MULD: fprintf (fptr, "\tregd[%i] = regd[%i] * regd[%i];\n", c, a, b); break;
+
+		case DIVD:
+			#if DIVISIONCHECK
+			fprintf (fptr, "\tif (regd[%i] == 0.0) return (%lliLL);\n", b, e);
+			#endif
+			fprintf (fptr, "\tregd[%i] = regd[%i] / regd[%i];\n", c, a, b);
+			break;
+
+		case SMULI: fprintf (fptr, "\tregi[%i] = regi[%i] << regi[%i];\n", c, a, b); break;
+		case SDIVI: fprintf (fptr, "\tregi[%i] = regi[%i] >> regi[%i];\n", c, a, b); break;
+		case SHLI: fprintf (fptr, "\tregi[%i] = regi[%i] << %i;\n", c, a, b & 63); break;
+		case ANDI: fprintf (fptr, "\tregi[%i] = regi[%i] && regi[%i];\n", c, a, b); break;
+		case ORI: fprintf (fptr, "\tregi[%i] = regi[%i] || regi[%i];\n", c, a, b); break;
+		case BANDI: fprintf (fptr, "\tregi[%i] = regi[%i] & regi[%i];\n", c, a, b); break;
+		case BORI: fprintf (fptr, "\tregi[%i] = regi[%i] | regi[%i];\n", c, a, b); break;
+		case BXORI: fprintf (fptr, "\tregi[%i] = regi[%i] ^ regi[%i];\n", c, a, b); break;
+		case MODI: fprintf (fptr, "\tregi[%i] = regi[%i] %% regi[%i];\n", c, a, b); break;
+
+		case EQI: fprintf (fptr, "\tregi[%i] = regi[%i] == regi[%i];\n", c, a, b); break;
+		case NEQI: fprintf (fptr, "\tregi[%i] = regi[%i] != regi[%i];\n", c, a, b); break;
+		case GRI: fprintf (fptr, "\tregi[%i] = regi[%i] > regi[%i];\n", c, a, b); break;
+		case LSI: fprintf (fptr, "\tregi[%i] = regi[%i] < regi[%i];\n", c, a, b); break;
+		case GREQI: fprintf (fptr, "\tregi[%i] = regi[%i] >= regi[%i];\n", c, a, b); break;
+		case LSEQI: fprintf (fptr, "\tregi[%i] = regi[%i] <= regi[%i];\n", c, a, b); break;
+
+		case EQD: fprintf (fptr, "\tregi[%i] = regd[%i] == regd[%i];\n", c, a, b); break;
+		case NEQD: fprintf (fptr, "\tregi[%i] = regd[%i] != regd[%i];\n", c, a, b); break;
+		case GRD: fprintf (fptr, "\tregi[%i] = regd[%i] > regd[%i];\n", c, a, b); break;
+		case LSD: fprintf (fptr, "\tregi[%i] = regd[%i] < regd[%i];\n", c, a, b); break;
+		case GREQD: fprintf (fptr, "\tregi[%i] = regd[%i] >= regd[%i];\n", c, a, b); break;
+		case LSEQD: fprintf (fptr, "\tregi[%i] = regd[%i] <= regd[%i];\n", c, a, b); break;
+
+		case JMP:
+			fprintf (fptr, "\t");
+			write_jump (fptr, get_quadword (e + 1));
+			break;
+
+		case JMPI:
+			fprintf (fptr, "\tif (regi[%i] != 0) ", a);
+			write_jump (fptr, get_quadword (e + 2));
+			break;
+
+		case INCLSIJMPI:
+			fprintf (fptr, "\tregi[%i]++;\n\tif (regi[%i] < regi[%i]) ", a, a, b);
+			write_jump (fptr, get_quadword (e + 3));
+			break;
+
+		case DECGRIJMPI:
+			fprintf (fptr, "\tregi[%i]--;\n\tif (regi[%i] > regi[%i]) ", a, a, b);
+			write_jump (fptr, get_quadword (e + 3));
+			break;
+
+		case JMPT:
+			// the table entries are the jmp opcodes after jmpt: jump to their targets
+			fprintf (fptr, "\tswitch (regi[%i])\n\t{\n", a);
+			for (arg1 = 0; arg1 < b; arg1++)
+			{
+				fprintf (fptr, "\t\tcase %lliLL: ", arg1);
+				write_jump (fptr, get_quadword (e + 11 + (arg1 * 9) + 1));
+			}
+			fprintf (fptr, "\t\tdefault: ");
+			write_jump (fptr, get_quadword (e + 3));
+			fprintf (fptr, "\t}\n");
+			break;
+
+		case LOADA:
+		case LOADD:
+			arg1 = get_quadword (e + 1);
+			arg2 = get_quadword (e + 9);
+			snprintf ((char *) start, 64, "%lliLL", arg1);
+			snprintf ((char *) offset, 64, "%lliLL", arg2);
+			write_bounds (fptr, (const char *) start, (const char *) offset, e);
+			if (op == LOADA)
+			{
+				fprintf (fptr, "\tmemcpy (&regi[%i], &data[%lliLL], 8);\n", code[e + 17], arg1 + arg2);
+			}
+			else
+			{
+				fprintf (fptr, "\tmemcpy (&regd[%i], &data[%lliLL], 8);\n", code[e + 17], arg1 + arg2);
+			}
+			break;
+
+		case LOAD:
+			fprintf (fptr, "\tregi[%i] = %lliLL;\n", code[e + 17], get_quadword (e + 1) + get_quadword (e + 9));
+			break;
+
+		case LOADL:
+			fprintf (fptr, "\tregi[%i] = %lliLL;\n", code[e + 9], get_quadword (e + 1));
+			break;
+
+		case MOVI: fprintf (fptr, "\tregi[%i] = regi[%i];\n", b, a); break;
+		case MOVD: fprintf (fptr, "\tregd[%i] = regd[%i];\n", b, a); break;
+		case NOTI: fprintf (fptr, "\tregi[%i] = ! regi[%i];\n", b, a); break;
+
+		case JMPA:
+			// indirect jump: continue at regi[a]
+			fprintf (fptr, "\treturn (regi[%i]);\n", a);
+			break;
+	}
+}
+
+S2 write_c (U1 *objname, U1 *cname)
+{
+	FILE *fptr;
+	S8 i ALIGN;
+	S8 entries ALIGN = 0;
+
+	fptr = fopen ((const char *) cname, "w");
+	if (fptr == NULL)
+	{
+		printf ("ERROR: can't create file '%s'!\n", cname);
+		return (1);
+	}
+
+	fprintf (fptr, "// generated by l1aot from '%s', don't edit!\n", objname);
+	fprintf (fptr, "#include <string.h>\n\n");
+	fprintf (fptr, "typedef unsigned char U1;\ntypedef short S2;\ntypedef long long S8;\ntypedef double F8;\n\n");
+	fprintf (fptr, "struct jit_context\n{\n\tS8 *regi;\n\tF8 *regd;\n\tU1 *data;\n\tS2 (*memory_bounds) (S8 start, S8 offset_access);\n\tS8 error_ep __attribute__ ((aligned (8)));\n};\n\n");
+	fprintf (fptr, "#define JIT_EXIT_ERROR -2\n");
+	fprintf (fptr, "#define BOUNDS(start, offset, epos) if (ctx->memory_bounds (start, offset) != 0) { ctx->error_ep = epos; return (JIT_EXIT_ERROR); }\n\n");
+
+	// the VM checks if the .so matches the loaded object
+	fprintf (fptr, "const S8 l1aot_code_size = %lliLL;\n", code_size);
+	fprintf (fptr, "const S8 l1aot_code_hash = (S8) 0x%016llxULL;\n", (unsigned long long) code_hash (code, 16, code_size));
+	fprintf (fptr, "const S8 l1aot_checks = %iLL;\n\n", CHECK_FLAGS);
+
+	fprintf (fptr, "static S8 l1aot_run (struct jit_context *ctx, S8 ep)\n{\n");
+	fprintf (fptr, "\tS8 *regi = ctx->regi;\n\tF8 *regd = ctx->regd;\n\tU1 *data = ctx->data;\n\n");
+	fprintf (fptr, "\tswitch (ep)\n\t{\n");
+	for (i = 16; i < code_size; i++)
+	{
+		if (code_entry[i] == 1)
+		{
+			fprintf (fptr, "\t\tcase %lliLL: goto L%lli;\n", i, i);
+		}
+	}
+	fprintf (fptr, "\t\tdefault: return (ep);\n\t}\n\n");
+
+	for (i = 16; i < code_size; i = i + opcode_size (code[i]))
+	{
+		if (code_entry[i] == 1)
+		{
+			fprintf (fptr, "L%lli:\n", i);
+		}
+		write_opcode (fptr, i);
+	}
+	fprintf (fptr, "\treturn (%lliLL);\n}\n\n", code_size);
+
+	// native function for every label, if it doesn't start with a not translated opcode
+	for (i = 16; i < code_size; i++)
+	{
+		if (code_entry[i] == 1 && native_opcode (code[i]) == 1)
+		{
+			fprintf (fptr, "S8 l1aot_%lli (struct jit_context *ctx) { return (l1aot_run (ctx, %lliLL)); }\n", i, i);
+			entries++;
+		}
+	}
+
+	fprintf (fptr, "\nconst S8 l1aot_entries = %lliLL;\n", entries);
+	fprintf (fptr, "const S8 l1aot_entry_epos[] = {");
+	for (i = 16; i < code_size; i++)
+	{
+		if (code_entry[i] == 1 && native_opcode (code[i]) == 1)
+		{
+			fprintf (fptr, " %lliLL,", i);
+		}
+	}
+	fprintf (fptr, " -1 };\n");
+	fprintf (fptr, "S8 (*const l1aot_entry_func[]) (struct jit_context *ctx) = {");
+	for (i = 16; i < code_size; i++)
+	{
+		if (code_entry[i] == 1 && native_opcode (code[i]) == 1)
+		{
+			fprintf (fptr, " l1aot_%lli,", i);
+		}
+	}
+	fprintf (fptr, " 0 };\n");
+
+	fclose (fptr);
+
+	printf ("l1aot: %lli native functions written to '%s'\n", entries, cname);
+	return (0);
+}
+
+void cleanup (void)
+{
+	if (code) free (code);
+	if (code_op) free (code_op);
+	if (code_entry) free (code_entry);
+}
+
+int main (int ac, char *av[])
+{
+	U1 objname[512];
+	U1 cname[512];
+	U1 soname[512];
+	U1 run_shell[2048];
+	char *compiler;
+	U1 c_only = 0;
+	S4 i;
+
+	printf ("l1aot <file> [-c]\n");
+	printf ("translates file.l1obj into file.l1aot.c and builds file.l1aot.so\n");
+	printf ("-c: only write C code\n");
+
+	if (ac < 2)
+	{
+		exit (1);
+	}
+
+	for (i = 2; i < ac; i++)
+	{
+		if (strcmp (av[i], "-c") == 0)
+		{
+			c_only = 1;
+		}
+	}
+
+	if (strlen_safe (av[1], MAXLINELEN) > 490)
+	{
+		printf ("ERROR: filename too long!\n");
+		exit (1);
+	}
+
+	strcpy ((char *) objname, av[1]);
+	strcat ((char *) objname, ".l1obj");
+	strcpy ((char *) cname, av[1]);
+	strcat ((char *) cname, ".l1aot.c");
+	strcpy ((char *) soname, av[1]);
+	strcat ((char *) soname, ".l1aot.so");
+
+	if (load_code (objname) != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+
+	find_entries ();
+
+	if (write_c (objname, cname) != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+	cleanup ();
+
+	if (c_only == 1)
+	{
+		exit (0);
+	}
+
+	compiler = getenv ("CC");
+	if (compiler == NULL)
+	{
+		compiler = "cc";
+	}
+	// -fwrapv: integer overflow wraps around, as in the VM
+	snprintf ((char *) run_shell, 2048, "%s -O2 -fwrapv -fPIC -shared %s -o %s", compiler, cname, soname);
+	printf ("%s\n", run_shell);
+
+	if (system ((const char *) run_shell) != 0)
+	{
+		printf ("ERROR: can't build shared object '%s'!\n", soname);
+		exit (1);
+	}
+
+	printf ("l1aot: '%s' build ok.\n", soname);
+	exit (0);
+}
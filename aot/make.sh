@@ -0,0 +1,6 @@
+#!/bin/sh
+if $CC -Wall main.c ../lib-func/string.c ../lib-func/code_hash.c -o l1aot -g; then
+	exit 0
+	else
+	exit 1
+fi
@@ -594,7 +594,7 @@ S2 write_code_labels (void)
 	{
 		// printf ("code: index %lli: opcode: %i\n", i, code[i]);
 
-		if (code[i] == JMP|| code[i] == JMPI || code[i] == INCLSIJMPI || code[i] == DECGRIJMPI || code[i] == LOADL || code[i] == JSR)
+		if (code[i] == JMP|| code[i] == JMPI || code[i] == INCLSIJMPI || code[i] == DECGRIJMPI || code[i] == LOADL || code[i] == JSR || code[i] == JMPT)
 		{
 			if (code[i] == JMP)
 			{
@@ -631,6 +631,28 @@ S2 write_code_labels (void)
 				write_code_quadword(i + 3, label[label_index].pos);
 			}
 
+			if (code[i] == JMPT)
+			{
+				// default label, the table entries are jmp opcodes
+				label_index = read_code_quadword (&code[i + 3]);
+				if (label[label_index].pos == -1)
+				{
+					printf ("ERROR: write_code_labels: label: %s not defined!\n", label[label_index].name);
+					err = 1;
+				}
+				write_code_quadword(i + 3, label[label_index].pos);
+
+				for (j = 0; j < code[i + 2]; j++)
+				{
+					if (i + 11 + (j * 9) > code_ind - 1 || code[i + 11 + (j * 9)] != JMP)
+					{
+						printf ("ERROR: write_code_labels: jmpt: table entry %lli is not a jmp opcode!\n", j);
+						err = 1;
+						break;
+					}
+				}
+			}
+
 			if (code[i] == LOADL)
 			{
 				label_index = read_code_quadword (&code[i + 1]);
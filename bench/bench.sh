@@ -0,0 +1,197 @@
+#!/bin/bash
+# bench.sh: L1VM benchmark suite
+#
+# bench/bench.sh [-n runs] [-w warmup] [-c counting_vm] [-o result.json] [-p programs] vm [vm2]
+#
+# Assembles the programs in bench/prog (.l1asm) and compiles .l1com programs, then runs every
+# program "warmup" times and "runs" times timed with each VM. The result is written as JSON:
+# median, percentile, min, max and mean wall time per program and VM.
+# With a second VM the runs of both VMs alternate and "ratio" is median vm2 / median vm.
+#
+# -c counting_vm: a VM built with OPCODE_COUNT 1 runs every program once to count the executed
+# opcodes, then the JSON has "instructions" and "ips" (instructions per second).
+# -p programs: comma separated list of program names to run, default: all
+#
+# l1asm, l1com and l1pre are taken from PATH. Every run of a VM gets its own empty HOME,
+# so the JIT compiler cache of one run or VM is never used by an other one.
+
+runs=5
+warmup=1
+countvm=""
+outfile=""
+programs=""
+
+usage ()
+{
+	echo "usage: bench.sh [-n runs] [-w warmup] [-c counting_vm] [-o result.json] [-p programs] vm [vm2]"
+	exit 1
+}
+
+while getopts "n:w:c:o:p:" opt; do
+	case $opt in
+		n) runs=$OPTARG ;;
+		w) warmup=$OPTARG ;;
+		c) countvm=$(realpath "$OPTARG") ;;
+		o) outfile=$OPTARG ;;
+		p) programs=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+[ $# -lt 1 ] || [ $# -gt 2 ] && usage
+vms=()
+for vm in "$@"; do
+	[ -x "$vm" ] || { echo "bench: VM '$vm' not found!"; exit 1; }
+	vms+=("$(realpath "$vm")")
+done
+[ -n "$countvm" ] && [ ! -x "$countvm" ] && { echo "bench: counting VM '$countvm' not found!"; exit 1; }
+
+benchdir=$(dirname "$(realpath "$0")")
+work=$(mktemp -d /tmp/l1vm-bench.XXXXXX)
+trap 'rm -rf "$work"' EXIT
+
+# build the programs and the module for the module calls
+cp "$benchdir"/prog/*.l1asm "$benchdir"/prog/*.l1com "$work" 2>/dev/null
+cd "$work" || exit 1
+gcc -shared -fPIC -O2 "$benchdir/nullmod.c" -o libl1vmbench.so || { echo "bench: can't build libl1vmbench.so!"; exit 1; }
+
+names=()
+for f in *.l1asm *.l1com; do
+	[ -f "$f" ] || continue
+	name=${f%.*}
+	if [ -n "$programs" ] && [[ ",$programs," != *",$name,"* ]]; then
+		continue
+	fi
+	case $f in
+		*.l1com)
+			# "// l1com: flags" sets the compiler flags of the program
+			flags=$(sed -n 's|^// l1com: *||p' "$f" | head -1)
+			# shellcheck disable=SC2086
+			l1pre "$f" out.l1com "$benchdir/../include-lib/" > build.log 2>&1 && cp out.l1com "$f" && l1com "$name" $flags >> build.log 2>&1 && l1asm "$name" >> build.log 2>&1
+			;;
+		*.l1asm)
+			# a .l1asm made by l1com is assembled above
+			[ -f "$name.l1com" ] && continue
+			l1asm "$name" > build.log 2>&1
+			;;
+	esac
+	if [ $? -ne 0 ] || [ ! -f "$name.l1obj" ]; then
+		echo "bench: build of $f failed!"
+		cat build.log
+		exit 1
+	fi
+	names+=("$name")
+done
+
+new_home ()
+{
+	# new_home: empty HOME with the l1vm directory, for one run
+	local home
+	home=$(mktemp -d "$work/home.XXXXXX")
+	mkdir -p "$home/l1vm"
+	echo "$home"
+}
+
+run_vm ()
+{
+	# run_vm vm program: wall time in nanoseconds, or "fail"
+	local start end home
+	home=$(new_home)
+	start=$(date +%s%N)
+	HOME="$home" LD_LIBRARY_PATH="$work" "$1" "$2" -q < /dev/null > /dev/null 2>&1
+	local ret=$?
+	end=$(date +%s%N)
+	rm -rf "$home"
+	if [ $ret -ne 0 ]; then
+		echo "fail"
+	else
+		echo $((end - start))
+	fi
+}
+
+stats ()
+{
+	# stats ns...: JSON fields of the times in ms
+	printf "%s\n" "$@" | sort -n | awk '
+		{ t[NR] = $1 / 1000000.0; sum += t[NR] }
+		function rank (p) { i = int (p * NR / 100.0 + 0.999999); if (i < 1) i = 1; if (i > NR) i = NR; return t[i] }
+		END {
+			if (NR % 2) median = t[(NR + 1) / 2]; else median = (t[NR / 2] + t[NR / 2 + 1]) / 2.0
+			printf ("\"median_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"min_ms\": %.3f, \"max_ms\": %.3f, \"mean_ms\": %.3f", median, rank(90), rank(99), t[1], t[NR], sum / NR)
+		}'
+}
+
+json="{\n  \"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\",\n  \"host\": \"$(uname -n)\",\n  \"cpu\": \"$(grep -m 1 'model name' /proc/cpuinfo 2>/dev/null | sed 's/.*: //')\",\n"
+json+="  \"runs\": $runs,\n  \"warmup\": $warmup,\n  \"vm\": [$(printf '"%s", ' "${vms[@]}" | sed 's/, $//')],\n  \"benchmarks\": ["
+
+first=1
+for name in "${names[@]}"; do
+	class=$(sed -n 's|^// bench: *||p' "$name.l1asm" | head -1)
+	[ -z "$class" ] && class=$(sed -n 's|^// bench: *||p' "$name.l1com" 2>/dev/null | head -1)
+
+	instructions="null"
+	if [ -n "$countvm" ]; then
+		rm -f "$name.l1opcount"
+		home=$(new_home)
+		HOME="$home" LD_LIBRARY_PATH="$work" "$countvm" "$name" -q < /dev/null > /dev/null 2>&1
+		rm -rf "$home"
+		instructions=$(awk '/^all threads/ { getline; print $2 }' "$name.l1opcount" 2>/dev/null)
+		[ -z "$instructions" ] && instructions="null"
+	fi
+
+	# warmup, then the timed runs: the VMs alternate
+	for ((i = 0; i < warmup; i++)); do
+		for vm in "${vms[@]}"; do
+			run_vm "$vm" "$name" > /dev/null
+		done
+	done
+	declare -A times=()
+	fail=0
+	for ((i = 0; i < runs; i++)); do
+		for v in "${!vms[@]}"; do
+			t=$(run_vm "${vms[$v]}" "$name")
+			[ "$t" = "fail" ] && fail=1
+			times[$v]="${times[$v]} $t"
+		done
+	done
+
+	[ $first -eq 0 ] && json+=","
+	first=0
+	json+="\n    {\n      \"name\": \"$name\",\n      \"class\": \"$class\",\n      \"instructions\": $instructions,\n      \"results\": ["
+
+	medians=()
+	for v in "${!vms[@]}"; do
+		[ "$v" -gt 0 ] && json+=","
+		if [ $fail -eq 1 ]; then
+			json+="\n        {\"vm\": \"${vms[$v]}\", \"error\": \"program failed\"}"
+			echo "$name: FAILED" >&2
+			continue
+		fi
+		# shellcheck disable=SC2086
+		s=$(stats ${times[$v]})
+		median=$(echo "$s" | sed 's/.*"median_ms": \([0-9.]*\).*/\1/')
+		medians+=("$median")
+		ips=""
+		if [ "$instructions" != "null" ]; then
+			ips=$(awk -v n="$instructions" -v m="$median" 'BEGIN { printf (", \"ips\": %.0f", n / (m / 1000.0)) }')
+		fi
+		json+="\n        {\"vm\": \"${vms[$v]}\", $s$ips}"
+		printf "%-20s %-10s %10s ms  %s\n" "$name" "$class" "$median" "${vms[$v]}" >&2
+	done
+	json+="\n      ]"
+	if [ ${#medians[@]} -eq 2 ]; then
+		json+=$(awk -v a="${medians[0]}" -v b="${medians[1]}" 'BEGIN { printf (",\\n      \"ratio\": %.4f", b / a) }')
+	fi
+	json+="\n    }"
+	unset times
+done
+json+="\n  ]\n}\n"
+
+if [ -n "$outfile" ]; then
+	cd - > /dev/null || exit 1
+	printf "%b" "$json" > "$outfile"
+	echo "bench: results written to $outfile" >&2
+else
+	printf "%b" "$json"
+fi
@@ -0,0 +1,432 @@
+#!/bin/bash
+# io.sh: L1VM module I/O benchmarks
+#
+# bench/io.sh [-n runs] [-m module_dir] [-o result.json] [-p benchmarks] vm
+#
+# Measures the net, file and string modules with local stand-ins, no external services:
+#
+# net-write-string   socket_write_string of 1000 byte lines to a loopback peer (netpeer sink)
+# net-read-string    socket_read_string of 1000 byte lines from a loopback peer (netpeer source)
+# net-send-file      socket_send_file of a 256 KB file to a loopback peer
+# file-put-int64     file_put_int64 to a file on tmpfs
+# file-get-string    file_get_string of 100 byte lines from a file on tmpfs
+# string-cat         string_cat of a 64 KB string
+# stringmem-search   stringmem_search_string in a 1 MB buffer (search string not found)
+#
+# The programs take the time of the calls only (intr0 24/25), without loading the modules and
+# opening the files and sockets. The result is calls/s and MB/s (MB = 1000000 bytes), median of the runs.
+#
+# The modules are loaded from vm/modules/net, vm/modules/file and vm/modules/string (built by
+# modules/build.sh) or from "module_dir". The files are in $HOME/l1vm/ (SANDBOX) of a temporary
+# HOME in /dev/shm. l1asm is taken from PATH, gcc is needed for netpeer.
+
+runs=5
+moddir=""
+outfile=""
+programs=""
+
+usage ()
+{
+	echo "usage: io.sh [-n runs] [-m module_dir] [-o result.json] [-p benchmarks] vm"
+	exit 1
+}
+
+while getopts "n:m:o:p:" opt; do
+	case $opt in
+		n) runs=$OPTARG ;;
+		m) moddir=$(realpath "$OPTARG") ;;
+		o) outfile=$OPTARG ;;
+		p) programs=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+[ $# -ne 1 ] && usage
+[ -x "$1" ] || { echo "io: VM '$1' not found!"; exit 1; }
+vm=$(realpath "$1")
+
+benchdir=$(dirname "$(realpath "$0")")
+if [ -z "$moddir" ]; then
+	libpath="$benchdir/../vm/modules/net:$benchdir/../vm/modules/file:$benchdir/../vm/modules/string"
+else
+	libpath="$moddir"
+fi
+for lib in libl1vmnet.so libl1vmfile.so libl1vmstring.so; do
+	found=0
+	for dir in ${libpath//:/ }; do
+		[ -f "$dir/$lib" ] && found=1
+	done
+	[ $found -eq 0 ] && { echo "io: module $lib not found in $libpath!"; exit 1; }
+done
+
+# tmpfs for the files, if there is one
+tmpdir=/tmp
+[ -d /dev/shm ] && [ -w /dev/shm ] && tmpdir=/dev/shm
+work=$(mktemp -d "$tmpdir/l1vm-io.XXXXXX")
+trap 'rm -rf "$work"' EXIT
+mkdir -p "$work/home/l1vm"
+cd "$work" || exit 1
+gcc -O2 "$benchdir/netpeer.c" -o netpeer || { echo "io: can't build netpeer!"; exit 1; }
+
+port=$((20000 + $$ % 20000))
+
+# calls, bytes per call of the benchmarks
+declare -A calls=(
+	[net-write-string]=20000 [net-read-string]=2000 [net-send-file]=4 [file-put-int64]=1000000
+	[file-get-string]=100000 [string-cat]=5000 [stringmem-search]=200
+)
+declare -A callbytes=(
+	[net-write-string]=1000 [net-read-string]=1000 [net-send-file]=262144 [file-put-int64]=8
+	[file-get-string]=100 [string-cat]=65536 [stringmem-search]=1048576
+)
+names=(net-write-string net-read-string net-send-file file-put-int64 file-get-string string-cat stringmem-search)
+
+# data section with the offsets counted: data_q name value, data_b name size value
+data_offs=0
+data_q ()
+{
+	printf "\tQ, 1, %s\n\t@, %s, %sQ\n" "$1" $data_offs "$2"
+	data_offs=$((data_offs + 8))
+}
+
+data_b ()
+{
+	printf "\tB, %s, %s\n\t@, %s, %s\n" "$2" "$1" $data_offs "$3"
+	data_offs=$((data_offs + $2))
+}
+
+# header: data of all programs, load module $1 and set the functions $2...
+header ()
+{
+	local module=$1 i=0 f
+	shift
+	echo ".data"
+	data_q zero 0
+	data_q one 1
+	data_q two 2
+	data_q maxind 4
+	data_q max "$calls_n"
+	data_q port "$port"
+	data_b modulestr $((${#module} + 1)) "\"$module\""
+	for f in "$@"; do
+		data_b "func$i" $((${#f} + 1)) "\"$f\""
+		i=$((i + 1))
+	done
+	$extra_data
+	echo ".dend"
+	echo ".code"
+	echo "	loada zero, 0, I0"
+	echo "	loada one, 0, I1"
+	echo "	loada two, 0, I2"
+	echo "	loada max, 0, I3"
+	echo "	load modulestr, 0, I10"
+	echo "	intr0 0, I10, I0, 0"
+	for ((i = 0; i < $#; i++)); do
+		echo "	loada zero, 0, I11"
+		echo "	load func$i, 0, I12"
+		[ $i -gt 0 ] && for ((j = 0; j < i; j++)); do echo "	addi I11, I1, I11"; done
+		echo "	intr0 2, I0, I11, I12"
+	done
+	# function numbers: I20 ... I2x
+	for ((i = 0; i < $#; i++)); do
+		echo "	loada zero, 0, I$((20 + i))"
+		for ((j = 0; j < i; j++)); do echo "	addi I$((20 + i)), I1, I$((20 + i))"; done
+	done
+}
+
+# data of the programs
+data_net ()
+{
+	data_b host 10 '"127.0.0.1"'
+	data_q xchar 120
+	data_q fillsize 999
+	data_q slen 1000
+	data_b buf 1002 0B
+	data_b filename 9 '"send.dat"'
+	data_b mime 11 '"text/plain"'
+}
+
+data_file ()
+{
+	data_b putname 8 '"put.dat"'
+	data_b getname 10 '"lines.txt"'
+	data_q slen 128
+	data_b buf 130 0B
+}
+
+data_string_cat ()
+{
+	data_q xchar 120
+	data_q fillsize 65536
+	data_b src 65537 0B
+	data_b dest 65537 0B
+}
+
+data_stringmem ()
+{
+	data_b search 7 '"needle"'
+	data_q memsize 1048576
+	data_b mem 1048577 0B
+}
+
+# fill byte array at address in I14 with $1 bytes 'x' and a 0 byte
+fill_x ()
+{
+	cat << EOF
+	loada xchar, 0, I15
+	loada fillsize, 0, I16
+	movi I0, I17
+:fill
+	pullb I15, I14, I17
+	inclsijmpi I17, I16, :fill
+	pullb I0, I14, I16
+EOF
+}
+
+footer ()
+{
+	cat << EOF
+:error
+	intr0 255, I1, 0, 0
+.cend
+EOF
+}
+
+write_prog ()
+{
+	local name=$1
+	calls_n=${calls[$name]}
+	data_offs=0
+	extra_data=true
+	{
+	case $name in
+		net-write-string|net-read-string|net-send-file)
+			extra_data=data_net
+			header libl1vmnet.so init_sockets open_client_socket close_client_socket socket_write_string socket_read_string socket_send_file
+			cat << EOF
+	loada maxind, 0, I13
+	stpushi I13
+	intr0 3, I0, I20, 0
+	stpopi I9
+	load host, 0, I13
+	loada port, 0, I14
+	stpushi I13
+	stpushi I14
+	intr0 3, I0, I21, 0
+	stpopi I9
+	stpopi I13
+	neqi I9, I0, I8
+	jmpi I8, :error
+	load buf, 0, I14
+EOF
+			fill_x
+			echo "	loada slen, 0, I18"
+			echo "	load filename, 0, I15"
+			echo "	load mime, 0, I16"
+			echo "	movi I0, I5"
+			echo "	intr0 24, 0, 0, 0"
+			echo ":loop"
+			case $name in
+				net-write-string) echo "	stpushi I13"; echo "	stpushi I14"; echo "	intr0 3, I0, I23, 0" ;;
+				net-read-string) echo "	stpushi I13"; echo "	stpushi I14"; echo "	stpushi I18"; echo "	intr0 3, I0, I24, 0" ;;
+				net-send-file) echo "	stpushi I13"; echo "	stpushi I15"; echo "	stpushi I16"; echo "	intr0 3, I0, I25, 0" ;;
+			esac
+			cat << EOF
+	stpopi I9
+	neqi I9, I0, I8
+	jmpi I8, :error
+	inclsijmpi I5, I3, :loop
+	intr0 25, I9, 0, 0
+	stpushi I13
+	intr0 3, I0, I22, 0
+	stpopi I9
+	intr0 255, 0, 0, 0
+EOF
+			;;
+
+		file-put-int64|file-get-string)
+			extra_data=data_file
+			header libl1vmfile.so file_init_state file_open file_close file_put_int64 file_get_string
+			cat << EOF
+	loada maxind, 0, I13
+	stpushi I13
+	intr0 3, I0, I20, 0
+	stpopi I9
+EOF
+			if [ "$name" = "file-put-int64" ]; then
+				echo "	load putname, 0, I13"
+				echo "	stpushb I2"
+			else
+				echo "	load getname, 0, I13"
+				echo "	stpushb I1"
+			fi
+			cat << EOF
+	stpushi I13
+	intr0 3, I0, I21, 0
+	stpopi I13
+	lsi I13, I0, I8
+	jmpi I8, :error
+	load buf, 0, I14
+	loada slen, 0, I18
+	movi I0, I5
+	intr0 24, 0, 0, 0
+:loop
+	stpushi I13
+EOF
+			if [ "$name" = "file-put-int64" ]; then
+				echo "	stpushi I5"
+				echo "	intr0 3, I0, I23, 0"
+			else
+				echo "	stpushi I14"
+				echo "	stpushi I18"
+				echo "	intr0 3, I0, I24, 0"
+			fi
+			cat << EOF
+	stpopi I9
+	neqi I9, I0, I8
+	jmpi I8, :error
+	inclsijmpi I5, I3, :loop
+	intr0 25, I9, 0, 0
+	stpushi I13
+	intr0 3, I0, I22, 0
+	intr0 255, 0, 0, 0
+EOF
+			;;
+
+		string-cat)
+			extra_data=data_string_cat
+			header libl1vmstring.so string_cat
+			echo "	load src, 0, I14"
+			fill_x
+			cat << EOF
+	load dest, 0, I13
+	movi I0, I5
+	intr0 24, 0, 0, 0
+:loop
+	pullb I0, I13, I0
+	stpushi I13
+	stpushi I14
+	intr0 3, I0, I20, 0
+	inclsijmpi I5, I3, :loop
+	intr0 25, I9, 0, 0
+	intr0 255, 0, 0, 0
+EOF
+			;;
+
+		stringmem-search)
+			extra_data=data_stringmem
+			header libl1vmstring.so stringmem_search_string
+			cat << EOF
+	load mem, 0, I13
+	load search, 0, I14
+	loada memsize, 0, I15
+	movi I0, I5
+	intr0 24, 0, 0, 0
+:loop
+	stpushi I13
+	stpushi I14
+	stpushi I0
+	stpushi I15
+	stpushi I0
+	intr0 3, I0, I20, 0
+	stpopi I9
+	inclsijmpi I5, I3, :loop
+	intr0 25, I9, 0, 0
+	intr0 255, 0, 0, 0
+EOF
+			;;
+	esac
+	footer
+	} > "$name.l1asm"
+}
+
+run_prog ()
+{
+	# run_prog name: call time in ms, or "fail"
+	local name=$1 out
+	rm -f "$work/sink.bytes"
+	case $name in
+		net-write-string|net-send-file)
+			./netpeer sink $port "$work/sink.bytes" || { echo "fail"; return; }
+			;;
+		net-read-string)
+			./netpeer source $port "${calls[$name]}" "${callbytes[$name]}" || { echo "fail"; return; }
+			;;
+	esac
+	out=$(HOME="$work/home" LD_LIBRARY_PATH="$libpath" "$vm" "$name" -q < /dev/null 2>&1)
+	if [ $? -ne 0 ]; then
+		echo "fail"
+		echo "$out" > "$name.log"
+		return
+	fi
+	case $name in
+		net-write-string|net-send-file)
+			# the peer must have got all data
+			for ((w = 0; w < 50; w++)); do
+				[ -s "$work/sink.bytes" ] && break
+				sleep 0.1
+			done
+			if [ "$(cat "$work/sink.bytes" 2>/dev/null || echo 0)" -lt $((calls[$name] * callbytes[$name])) ]; then
+				echo "fail"
+				echo "$name: peer got $(cat "$work/sink.bytes" 2>/dev/null) bytes" > "$name.log"
+				return
+			fi
+			;;
+	esac
+	echo "$out" | sed -n 's/^TIMER ms: *//p' | head -1
+}
+
+# test files
+head -c "${callbytes[net-send-file]}" /dev/zero | tr '\0' 'x' > "$work/home/l1vm/send.dat"
+awk -v n="${calls[file-get-string]}" 'BEGIN { s = sprintf ("%99s", ""); gsub (/ /, "x", s); for (i = 0; i < n; i++) print s }' > "$work/home/l1vm/lines.txt"
+
+printf "%-18s %12s %12s %10s\n" "benchmark" "calls/s" "MB/s" "ms"
+json="{\n  \"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\",\n  \"host\": \"$(uname -n)\",\n  \"runs\": $runs,\n  \"vm\": \"$vm\",\n  \"benchmarks\": ["
+first=1
+for name in "${names[@]}"; do
+	if [ -n "$programs" ] && [[ ",$programs," != *",$name,"* ]]; then
+		continue
+	fi
+	write_prog "$name"
+	if ! l1asm "$name" > build.log 2>&1 || [ ! -f "$name.l1obj" ]; then
+		echo "io: build of $name failed!"
+		cat build.log
+		exit 1
+	fi
+
+	times=""
+	fail=0
+	for ((i = 0; i < runs; i++)); do
+		t=$(run_prog "$name")
+		[ "$t" = "fail" ] || [ -z "$t" ] && { fail=1; break; }
+		times="$times $t"
+	done
+
+	[ $first -eq 0 ] && json+=","
+	first=0
+	if [ $fail -eq 1 ]; then
+		printf "%-18s %12s\n" "$name" "FAILED"
+		[ -f "$name.log" ] && head -5 "$name.log"
+		json+="\n    {\"name\": \"$name\", \"error\": \"program failed\"}"
+		continue
+	fi
+	# shellcheck disable=SC2086
+	res=$(printf "%s\n" $times | sort -n | awk -v c="${calls[$name]}" -v b="${callbytes[$name]}" '
+		{ t[NR] = $1 }
+		END {
+			if (NR % 2) m = t[(NR + 1) / 2]; else m = (t[NR / 2] + t[NR / 2 + 1]) / 2.0
+			if (m <= 0) m = 0.001
+			printf ("%.3f %.0f %.3f", m, c / (m / 1000.0), c * b / 1000000.0 / (m / 1000.0))
+		}')
+	read -r ms cps mbs <<< "$res"
+	printf "%-18s %12s %12s %10s\n" "$name" "$cps" "$mbs" "$ms"
+	json+="\n    {\"name\": \"$name\", \"calls\": ${calls[$name]}, \"bytes_per_call\": ${callbytes[$name]}, \"median_ms\": $ms, \"calls_per_s\": $cps, \"mb_per_s\": $mbs}"
+done
+json+="\n  ]\n}\n"
+
+if [ -n "$outfile" ]; then
+	cd - > /dev/null || exit 1
+	printf "%b" "$json" > "$outfile"
+	echo "io: results written to $outfile"
+fi
@@ -0,0 +1,266 @@
+#!/bin/bash
+# micro.sh: L1VM per opcode microbenchmarks
+#
+# bench/micro.sh [-n runs] [-l loops] [-u unroll] [-o result.json] [-p opcodes] vm [vm...]
+#
+# Generates one .l1asm program per opcode: a loop of "loops" iterations with the opcode "unroll"
+# times in the loop body. The "empty" program has the same loop without opcodes, its time is
+# subtracted, so VM start and loop overhead don't count:
+#
+# ns/op = (median time - median time empty) / (loops * unroll)
+#
+# Stack, jsr and module call benchmarks count a pair (stpushi + stpopi, jsr + rts) or a call as one op,
+# stpushir + stpopir saves and loads 8 registers,
+# jmpt counts with the jmp of its table.
+# The table has one column per VM, so builds can be compared: nojit/JIT, with and without BOUNDSCHECK.
+# -p opcodes: comma separated list of benchmark names to run, default: all
+#
+# l1asm is taken from PATH, gcc is needed for the module of the intr0 3 benchmark.
+
+runs=5
+loops=1000000
+unroll=16
+outfile=""
+programs=""
+
+usage ()
+{
+	echo "usage: micro.sh [-n runs] [-l loops] [-u unroll] [-o result.json] [-p opcodes] vm [vm...]"
+	exit 1
+}
+
+while getopts "n:l:u:o:p:" opt; do
+	case $opt in
+		n) runs=$OPTARG ;;
+		l) loops=$OPTARG ;;
+		u) unroll=$OPTARG ;;
+		o) outfile=$OPTARG ;;
+		p) programs=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+[ $# -lt 1 ] && usage
+vms=()
+for vm in "$@"; do
+	[ -x "$vm" ] || { echo "micro: VM '$vm' not found!"; exit 1; }
+	vms+=("$(realpath "$vm")")
+done
+
+benchdir=$(dirname "$(realpath "$0")")
+work=$(mktemp -d /tmp/l1vm-micro.XXXXXX)
+trap 'rm -rf "$work"' EXIT
+mkdir -p "$work/home"
+cd "$work" || exit 1
+gcc -shared -fPIC -O2 "$benchdir/nullmod.c" -o libl1vmbench.so || { echo "micro: can't build libl1vmbench.so!"; exit 1; }
+
+# name|class|opcode lines separated by ";", "%n" is replaced by the number of the copy
+# registers: I0 = 0, I3 = 1, I4 = 2, I6 = int64 array, I7 = byte array, I9 = double array
+# F1 = 1.5, F2 = 2.5, module 0 function 0 = bench_null_func
+benchmarks=(
+	"empty|loop|"
+	"addi|int|addi I3, I4, I8"
+	"subi|int|subi I4, I3, I8"
+	"muli|int|muli I3, I4, I8"
+	"divi|int|divi I4, I3, I8"
+	"modi|int|modi I4, I3, I8"
+	"bandi|int|bandi I3, I4, I8"
+	"shli|int|shli I3, 3, I8"
+	"addd|double|addd F1, F2, F8"
+	"subd|double|subd F2, F1, F8"
+	"muld|double|muld F1, F2, F8"
+	"divd|double|divd F2, F1, F8"
+	"eqi|compare|eqi I3, I4, I8"
+	"lsi|compare|lsi I3, I4, I8"
+	"eqd|compare|eqd F1, F2, I8"
+	"lsd|compare|lsd F1, F2, I8"
+	"movi|move|movi I3, I8"
+	"loada|move|loada one, 0, I8"
+	"load|move|load iarray, 0, I8"
+	"pushqw|memory|pushqw I6, I0, I8"
+	"pullqw|memory|pullqw I3, I6, I0"
+	"pushb|memory|pushb I7, I0, I8"
+	"pullb|memory|pullb I3, I7, I0"
+	"pushd|memory|pushd I9, I0, F8"
+	"pulld|memory|pulld F1, I9, I0"
+	"pushqws|memory|pushqws I6, I0, I8"
+	"pullqws|memory|pullqws I3, I6, I0"
+	"stpushi+stpopi|stack|stpushi I3;stpopi I8"
+	"stpushd+stpopd|stack|stpushd F1;stpopd F8"
+	"stpushir+stpopir|stack|stpushir I0, I7;stpopir I0, I7"
+	"jmp|jump|jmp :next_%n;:next_%n"
+	"jmpt|jump|jmpt I0, 1, :next_%n;jmp :next_%n;:next_%n"
+	"jsr+rts|call|jsr :func"
+	"intr0-3|module|intr0 3, I0, I0, 0"
+)
+
+write_prog ()
+{
+	# write_prog name ops
+	local i
+	{
+		cat << EOF
+.data
+	Q, 1, zero
+	@, 0, 0Q
+	Q, 1, one
+	@, 8, 1Q
+	Q, 1, two
+	@, 16, 2Q
+	Q, 1, max
+	@, 24, ${loops}Q
+	F, 1, fa
+	@, 32, 1.5
+	F, 1, fb
+	@, 40, 2.5
+	B, 16, modulestr
+	@, 48, "libl1vmbench.so"
+	B, 16, funcstr
+	@, 64, "bench_null_func"
+	Q, 1, moduleaddr
+	@, 80, 48Q
+	Q, 1, funcaddr
+	@, 88, 64Q
+	Q, 4, iarray
+	@, 96, 0Q
+	F, 4, darray
+	@, 128, 0.0
+	B, 8, barray
+	@, 160, 0B
+.dend
+.code
+	loada zero, 0, I0
+	loada one, 0, I3
+	loada two, 0, I4
+	loada max, 0, I2
+	load iarray, 0, I6
+	load barray, 0, I7
+	load darray, 0, I9
+	loadd fa, 0, F1
+	loadd fb, 0, F2
+	loada moduleaddr, 0, I10
+	loada funcaddr, 0, I11
+	intr0 0, I10, I0, 0
+	intr0 2, I0, I0, I11
+	movi I0, I5
+:loop
+EOF
+		if [ -n "$2" ]; then
+			for ((i = 0; i < unroll; i++)); do
+				echo "$2" | tr ';' '\n' | sed "s/%n/$i/g; s/^/\t/; s/^\t:/:/"
+			done
+		fi
+		cat << EOF
+	inclsijmpi I5, I2, :loop
+	intr0 1, I0, 0, 0
+	intr0 255, 0, 0, 0
+:func
+	rts
+.cend
+EOF
+	} > "$1.l1asm"
+}
+
+names=()
+for b in "${benchmarks[@]}"; do
+	IFS='|' read -r name class ops <<< "$b"
+	if [ -n "$programs" ] && [ "$name" != "empty" ] && [[ ",$programs," != *",$name,"* ]]; then
+		continue
+	fi
+	prog="op-${name//+/-}"
+	write_prog "$prog" "$ops"
+	if ! l1asm "$prog" > build.log 2>&1 || [ ! -f "$prog.l1obj" ]; then
+		echo "micro: build of $name failed!"
+		cat build.log
+		exit 1
+	fi
+	names+=("$name|$class|$prog")
+done
+
+run_vm ()
+{
+	# run_vm vm program: wall time in nanoseconds, or "fail"
+	local start end
+	start=$(date +%s%N)
+	HOME="$work/home" LD_LIBRARY_PATH="$work" "$1" "$2" -q < /dev/null > /dev/null 2>&1
+	local ret=$?
+	end=$(date +%s%N)
+	if [ $ret -ne 0 ]; then
+		echo "fail"
+	else
+		echo $((end - start))
+	fi
+}
+
+median ()
+{
+	printf "%s\n" "$@" | sort -n | awk '{ t[NR] = $1 } END { if (NR % 2) print t[(NR + 1) / 2]; else print (t[NR / 2] + t[NR / 2 + 1]) / 2 }'
+}
+
+# median time of every program and VM, the runs of the VMs alternate
+declare -A times=()
+for entry in "${names[@]}"; do
+	IFS='|' read -r name class prog <<< "$entry"
+	for v in "${!vms[@]}"; do
+		run_vm "${vms[$v]}" "$prog" > /dev/null
+	done
+	declare -A t=()
+	for ((i = 0; i < runs; i++)); do
+		for v in "${!vms[@]}"; do
+			t[$v]="${t[$v]} $(run_vm "${vms[$v]}" "$prog")"
+		done
+	done
+	for v in "${!vms[@]}"; do
+		if [[ "${t[$v]}" == *fail* ]]; then
+			times[$name,$v]="fail"
+		else
+			# shellcheck disable=SC2086
+			times[$name,$v]=$(median ${t[$v]})
+		fi
+	done
+	unset t
+done
+
+ops=$((loops * unroll))
+printf "%-16s %-8s" "opcode" "class"
+for v in "${!vms[@]}"; do
+	printf " %10s" "vm$((v + 1)) ns/op"
+done
+printf "\n"
+
+json="{\n  \"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\",\n  \"host\": \"$(uname -n)\",\n  \"runs\": $runs,\n  \"loops\": $loops,\n  \"unroll\": $unroll,\n"
+json+="  \"vm\": [$(printf '"%s", ' "${vms[@]}" | sed 's/, $//')],\n  \"opcodes\": ["
+first=1
+for entry in "${names[@]}"; do
+	IFS='|' read -r name class prog <<< "$entry"
+	[ "$name" = "empty" ] && continue
+	printf "%-16s %-8s" "$name" "$class"
+	[ $first -eq 0 ] && json+=","
+	first=0
+	json+="\n    {\"name\": \"$name\", \"class\": \"$class\", \"ns_op\": ["
+	for v in "${!vms[@]}"; do
+		if [ "${times[$name,$v]}" = "fail" ] || [ "${times[empty,$v]}" = "fail" ]; then
+			ns="null"
+			printf " %10s" "fail"
+		else
+			ns=$(awk -v t="${times[$name,$v]}" -v e="${times[empty,$v]}" -v n=$ops 'BEGIN { printf ("%.3f", (t - e) / n) }')
+			printf " %10s" "$ns"
+		fi
+		[ "$v" -gt 0 ] && json+=", "
+		json+="$ns"
+	done
+	json+="]}"
+	printf "\n"
+done
+json+="\n  ]\n}\n"
+
+for v in "${!vms[@]}"; do
+	echo "vm$((v + 1)): ${vms[$v]}, empty loop: $(awk -v t="${times[empty,$v]}" 'BEGIN { printf ("%.3f", t / 1000000.0) }') ms"
+done
+
+if [ -n "$outfile" ]; then
+	cd - > /dev/null || exit 1
+	printf "%b" "$json" > "$outfile"
+	echo "micro: results written to $outfile"
+fi
@@ -0,0 +1,127 @@
+/*
+ * This file netpeer.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  benchmark peer for the net module benchmarks: a loopback TCP server for one connection
+//
+//  netpeer sink port file            read until the client closes, write the byte count to file
+//  netpeer source port lines len     send "lines" lines of "len" bytes (with LF), then wait for the close
+//
+//  netpeer returns when the server socket is listening, the connection is served by a child process.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define BUFSIZE 65536
+
+int main (int ac, char *av[])
+{
+	struct sockaddr_in addr;
+	char buf[BUFSIZE];
+	long long bytes = 0;
+	long long lines, len, i, n;
+	ssize_t ret;
+	int server, conn;
+	int on = 1;
+	FILE *fptr;
+
+	if (ac < 4 || (strcmp (av[1], "sink") != 0 && strcmp (av[1], "source") != 0) || (strcmp (av[1], "source") == 0 && ac < 5))
+	{
+		printf ("netpeer sink port file\nnetpeer source port lines len\n");
+		exit (1);
+	}
+
+	server = socket (AF_INET, SOCK_STREAM, 0);
+	if (server < 0)
+	{
+		perror ("netpeer: socket");
+		exit (1);
+	}
+	setsockopt (server, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+	addr.sin_port = htons (atoi (av[2]));
+	if (bind (server, (struct sockaddr *) &addr, sizeof (addr)) < 0 || listen (server, 1) < 0)
+	{
+		perror ("netpeer: bind");
+		exit (1);
+	}
+
+	// listening: the caller can start the client now
+	if (fork () != 0)
+	{
+		exit (0);
+	}
+	// don't wait forever, if the client doesn't come
+	alarm (300);
+
+	conn = accept (server, NULL, NULL);
+	if (conn < 0)
+	{
+		perror ("netpeer: accept");
+		exit (1);
+	}
+	close (server);
+
+	if (strcmp (av[1], "sink") == 0)
+	{
+		while ((ret = read (conn, buf, BUFSIZE)) > 0)
+		{
+			bytes += ret;
+		}
+		fptr = fopen (av[3], "w");
+		if (fptr)
+		{
+			fprintf (fptr, "%lli\n", bytes);
+			fclose (fptr);
+		}
+	}
+	else
+	{
+		lines = atoll (av[3]);
+		len = atoll (av[4]);
+		if (len < 1 || len > BUFSIZE)
+		{
+			exit (1);
+		}
+		memset (buf, 'x', len - 1);
+		buf[len - 1] = '\n';
+		for (i = 0; i < lines; i++)
+		{
+			for (n = 0; n < len; n += ret)
+			{
+				ret = write (conn, buf + n, len - n);
+				if (ret <= 0)
+				{
+					exit (1);
+				}
+			}
+		}
+		// wait for the close of the client
+		while (read (conn, buf, BUFSIZE) > 0);
+	}
+	close (conn);
+	exit (0);
+}
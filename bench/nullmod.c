@@ -0,0 +1,27 @@
+/*
+ * This file nullmod.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  benchmark module: functions which do nothing, to measure the cost of a module call (intr0 3)
+
+#include "../include/global.h"
+
+U1 *bench_null_func (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
+{
+	return (sp);
+}
@@ -25,11 +25,13 @@ struct if_comp if_comp[MAXIF];
 struct while_comp while_comp[MAXWHILE];
 struct for_comp for_comp[MAXFOR];
 struct switch_comp switch_comp[MAXSWITCH];
+struct switch_case switch_case[MAXSWITCHCASE];
 
 S8 if_ind ALIGN;
 S8 while_ind ALIGN;
 S8 for_ind ALIGN;
 S8 switch_ind ALIGN;
+S8 switch_case_ind ALIGN;
 S8 jumplist_ind ALIGN;
 
 // string functions ===============================================================================
@@ -37,6 +39,19 @@ size_t strlen_safe (const char * str, int maxlen);
 S2 searchstr (U1 *str, U1 *srchstr, S2 start, S2 end, U1 case_sens);
 void convtabs (U1 *str);
 
+// code list and registers of main.c, for the switch jump table
+extern U1 **code;
+extern S8 code_line ALIGN;
+extern S8 line_len ALIGN;
+extern S8 linenum ALIGN;
+extern S8 regfunc_save_line ALIGN;
+extern U1 regi[MAXREG][MAXLINELEN];
+extern U1 regd[MAXREG][MAXLINELEN];
+
+void shift_live_lines (S8 pos);
+void set_regi (S4 reg, U1 *name);
+void set_regd (S4 reg, U1 *name);
+
 void init_if (void)
 {
     S4 i;
@@ -60,8 +75,11 @@ void init_switch (void)
     {
         switch_comp[i].used = FALSE;
 		switch_comp[i].switch_set = FALSE;
+		switch_comp[i].table = FALSE;
+		switch_comp[i].regs_start = NULL;
 	}
 	switch_ind = -1;
+	switch_case_ind = -1;
 }
 
 S4 get_if_pos (void)
@@ -415,3 +433,334 @@ void set_switch_finished (S8 ind)
 {
     switch_comp[ind].used = SWITCH_FINISHED;
 }
+
+void set_switch_start (S8 ind, S8 line, S4 reg)
+{
+	// reg is reserved for the jump table index until the switch end
+	switch_comp[ind].start_line = line;
+	switch_comp[ind].reg = reg;
+	switch_comp[ind].var_reg = -1;
+	switch_comp[ind].act_if = get_act_if ();
+	strcpy ((char *) switch_comp[ind].var, "");
+
+	if (reg != -1)
+	{
+		switch_comp[ind].table = TRUE;
+	}
+	else
+	{
+		switch_comp[ind].table = FALSE;
+		return;
+	}
+
+	// the registers at jmpt, for the case labels
+	switch_comp[ind].regs_start = (U1 *) malloc (2 * MAXREG * MAXLINELEN);
+	if (switch_comp[ind].regs_start == NULL)
+	{
+		switch_comp[ind].table = FALSE;
+		return;
+	}
+	memcpy (switch_comp[ind].regs_start, regi, MAXREG * MAXLINELEN);
+	memcpy (switch_comp[ind].regs_start + MAXREG * MAXLINELEN, regd, MAXREG * MAXLINELEN);
+}
+
+static void drop_switch_regs (S8 ind)
+{
+	// drop the registers set since the switch start, but the index and the switch variable
+	U1 *regs;
+	S4 i;
+
+	regs = switch_comp[ind].regs_start;
+	for (i = 0; i < MAXREG; i++)
+	{
+		if (i == switch_comp[ind].reg || i == switch_comp[ind].var_reg)
+		{
+			continue;
+		}
+
+		if (strcmp ((const char *) regi[i], (const char *) &regs[i * MAXLINELEN]) != 0)
+		{
+			set_regi (i, (U1 *) "");
+		}
+		if (strcmp ((const char *) regd[i], (const char *) &regs[(MAXREG + i) * MAXLINELEN]) != 0)
+		{
+			set_regd (i, (U1 *) "");
+		}
+	}
+}
+
+void set_switch_case_regs (S8 ind)
+{
+	// jmpt jumps over the compares and loads of the cases before: every case loads what it uses
+	if (switch_comp[ind].table == FALSE || switch_comp[ind].regs_start == NULL)
+	{
+		return;
+	}
+
+	if (get_act_if () != switch_comp[ind].act_if)
+	{
+		// "?" in a case: an if, not a case
+		return;
+	}
+
+	drop_switch_regs (ind);
+}
+
+void set_switch_no_table (S8 ind)
+{
+	switch_comp[ind].table = FALSE;
+}
+
+void set_switch_case (S8 ind, U1 *var, S4 var_reg, U1 *name, S8 value, S8 line)
+{
+	// case "var name ?": name is an int64 constant with value, the compare starts at code line
+	if (switch_comp[ind].table == FALSE)
+	{
+		return;
+	}
+
+	if (get_act_if () != switch_comp[ind].act_if)
+	{
+		// "?" in a case: an if, not a case
+		switch_comp[ind].table = FALSE;
+		return;
+	}
+
+	if (switch_case_ind >= MAXSWITCHCASE - 1 || strlen_safe ((const char *) var, MAXLINELEN) > MAXJUMPNAME || strlen_safe ((const char *) name, MAXLINELEN) > MAXJUMPNAME)
+	{
+		switch_comp[ind].table = FALSE;
+		return;
+	}
+
+	if (switch_comp[ind].var_reg == -1)
+	{
+		strcpy ((char *) switch_comp[ind].var, (const char *) var);
+		switch_comp[ind].var_reg = var_reg;
+	}
+	else
+	{
+		if (strcmp ((const char *) switch_comp[ind].var, (const char *) var) != 0 || switch_comp[ind].var_reg != var_reg)
+		{
+			// not the same switch variable in all cases
+			switch_comp[ind].table = FALSE;
+			return;
+		}
+	}
+
+	switch_case_ind++;
+	switch_case[switch_case_ind].ind = ind;
+	switch_case[switch_case_ind].value = value;
+	switch_case[switch_case_ind].line = line;
+	strcpy ((char *) switch_case[switch_case_ind].name, (const char *) name);
+}
+
+S2 insert_code_line (S8 pos, U1 *line)
+{
+	// insert line at pos, the lines below are moved down
+	U1 *row;
+	S8 i ALIGN;
+
+	if (code_line + 1 >= line_len)
+	{
+		printf ("error: line %lli: code list full!\n", linenum);
+		return (1);
+	}
+
+	code_line++;
+	row = code[code_line];
+	for (i = code_line; i > pos; i--)
+	{
+		code[i] = code[i - 1];
+	}
+	code[pos] = row;
+	strcpy ((char *) code[pos], (const char *) line);
+
+	// the code lines recorded for the cases, the register saves and the functions.
+	// The switch start lines are before pos: the jmpt code goes before the label of the first case
+	for (i = 0; i <= switch_case_ind; i++)
+	{
+		if (switch_case[i].line >= pos)
+		{
+			switch_case[i].line++;
+		}
+	}
+	if (regfunc_save_line >= pos)
+	{
+		regfunc_save_line++;
+	}
+	shift_live_lines (pos);
+	return (0);
+}
+
+static S2 write_switch_jmpt (S8 ind)
+{
+	// dense int64 constant cases: at the switch start jmpt jumps to the compare of the matching case.
+	// The default is the first compare, so without a matching case the compares run as before.
+	S8 table[SWITCH_TABLE_MAX];
+	U1 line[MAXLINELEN];
+	S8 i ALIGN;
+	S8 n ALIGN;
+	S8 pos ALIGN;
+	S8 cases ALIGN = 0;
+	S8 first ALIGN = -1;
+	S8 min_case ALIGN = -1;
+	S8 min ALIGN = 0;
+	S8 max ALIGN = 0;
+	S8 range ALIGN;
+	S4 reg;
+
+	for (i = 0; i <= switch_case_ind; i++)
+	{
+		if (switch_case[i].ind != ind)
+		{
+			continue;
+		}
+
+		if (cases == 0)
+		{
+			first = i;
+			min_case = i;
+			min = switch_case[i].value;
+			max = switch_case[i].value;
+		}
+		else
+		{
+			if (switch_case[i].value < min)
+			{
+				min_case = i;
+				min = switch_case[i].value;
+			}
+			if (switch_case[i].value > max)
+			{
+				max = switch_case[i].value;
+			}
+		}
+		cases++;
+	}
+
+	if (cases < SWITCH_TABLE_MIN || (unsigned long long) max - (unsigned long long) min >= SWITCH_TABLE_MAX)
+	{
+		return (0);
+	}
+
+	range = max - min + 1;
+	if (range > cases * 2)
+	{
+		// not dense enough
+		return (0);
+	}
+
+	for (n = 0; n < range; n++)
+	{
+		table[n] = -1;
+	}
+
+	for (i = first; i <= switch_case_ind; i++)
+	{
+		if (switch_case[i].ind != ind)
+		{
+			continue;
+		}
+
+		n = switch_case[i].value - min;
+		if (table[n] != -1)
+		{
+			// same case value twice: leave it to the compares
+			return (0);
+		}
+		table[n] = i;
+	}
+
+	// no case for the value: default
+	for (n = 0; n < range; n++)
+	{
+		if (table[n] == -1)
+		{
+			table[n] = first;
+		}
+	}
+
+	// labels at the case compares, from the last one: so the lines above don't move
+	for (i = switch_case_ind; i >= first; i--)
+	{
+		if (switch_case[i].ind != ind)
+		{
+			continue;
+		}
+
+		snprintf ((char *) line, MAXLINELEN, ":switch_case_%lli\n", i);
+		if (insert_code_line (switch_case[i].line, line) != 0)
+		{
+			return (1);
+		}
+	}
+
+	pos = switch_comp[ind].start_line;
+
+	snprintf ((char *) line, MAXLINELEN, "loada %s, 0, %i\n", switch_comp[ind].var, switch_comp[ind].var_reg);
+	if (insert_code_line (pos++, line) != 0)
+	{
+		return (1);
+	}
+
+	if (min != 0)
+	{
+		reg = switch_comp[ind].reg;
+
+		snprintf ((char *) line, MAXLINELEN, "loada %s, 0, %i\n", switch_case[min_case].name, reg);
+		if (insert_code_line (pos++, line) != 0)
+		{
+			return (1);
+		}
+
+		snprintf ((char *) line, MAXLINELEN, "subi %i, %i, %i\n", switch_comp[ind].var_reg, reg, reg);
+		if (insert_code_line (pos++, line) != 0)
+		{
+			return (1);
+		}
+	}
+	else
+	{
+		reg = switch_comp[ind].var_reg;
+	}
+
+	snprintf ((char *) line, MAXLINELEN, "jmpt %i, %lli, :switch_case_%lli\n", reg, range, first);
+	if (insert_code_line (pos++, line) != 0)
+	{
+		return (1);
+	}
+
+	for (n = 0; n < range; n++)
+	{
+		snprintf ((char *) line, MAXLINELEN, "jmp :switch_case_%lli\n", table[n]);
+		if (insert_code_line (pos++, line) != 0)
+		{
+			return (1);
+		}
+	}
+
+	// the cases before the matching case are not run: load the registers again after the switch
+	drop_switch_regs (ind);
+	return (0);
+}
+
+S2 write_switch_table (S8 ind)
+{
+	S2 ret;
+
+	// free the index register
+	if (switch_comp[ind].reg != -1)
+	{
+		set_regi (switch_comp[ind].reg, (U1 *) "");
+	}
+
+	ret = 0;
+	if (switch_comp[ind].table == TRUE)
+	{
+		ret = write_switch_jmpt (ind);
+	}
+
+	free (switch_comp[ind].regs_start);
+	switch_comp[ind].regs_start = NULL;
+	return (ret);
+}
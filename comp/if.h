@@ -30,6 +30,9 @@
 #define NOTDEF -1
 #define IF_FINISHED 2
 #define SWITCH_FINISHED 3
+#define MAXSWITCHCASE 4096
+#define SWITCH_TABLE_MIN 4			// min number of cases for a jump table
+#define SWITCH_TABLE_MAX 255		// max entries of a jump table (jmpt)
 
 extern struct opcode opcode[MAXOPCODES];
 
@@ -62,6 +65,21 @@ struct switch_comp
 {
     U1 used;
 	U1 switch_set;
+	U1 table;					// TRUE if a jump table can be used
+	S4 reg;						// register for the jump table index
+	S4 var_reg;					// register of the switch variable
+	S4 act_if;					// open if at the switch start
+	S8 start_line ALIGN;		// first code line of the switch
+	U1 var[MAXJUMPNAME + 1];	// switch variable
+	U1 *regs_start;				// names of regi and regd at the switch start
+};
+
+struct switch_case
+{
+	S8 ind ALIGN;				// switch index
+	S8 value ALIGN;				// case constant
+	S8 line ALIGN;				// first code line of the case compare
+	U1 name[MAXJUMPNAME + 1];	// name of the case constant
 };
 
 struct jumplist
@@ -102,5 +120,10 @@ S4 get_switch_pos (void);
 S4 get_act_switch (void);
 void set_switch_finished (S8 ind);
 void init_switch (void);
+void set_switch_start (S8 ind, S8 line, S4 reg);
+void set_switch_case (S8 ind, U1 *var, S4 var_reg, U1 *name, S8 value, S8 line);
+void set_switch_no_table (S8 ind);
+void set_switch_case_regs (S8 ind);
+S2 write_switch_table (S8 ind);
 
 #endif
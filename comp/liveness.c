@@ -0,0 +1,1715 @@
+/*
+ * This file liveness.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Register liveness of a function: the register save of a call pushes all registers bound to a variable.
+// After the compiling the code of every function is analyzed and the saves and loads are set to the registers
+// which are read after the load, before they are set again.
+// Small functions and functions set by "inline" are inlined at the calls, with renamed registers.
+
+#include "../include/global.h"
+#include "../include/opcodes-types.h"
+#include "liveness.h"
+
+struct save_regs save_regs[MAXSAVEREGS];
+struct load_regs load_regs[MAXLOADREGS];
+struct live_func live_func[MAXLIVEFUNCS];
+
+S8 save_regs_ind ALIGN = -1;
+S8 load_regs_ind ALIGN = -1;
+S8 live_func_ind ALIGN = -1;
+U1 save_regs_skip = 0;			// set to one if the last save was not set: its load is not set too
+
+S8 inline_ind ALIGN = 0;		// number of inlined calls, for the labels
+
+struct live_edit *live_edit = NULL;
+S8 live_edit_ind ALIGN = -1;
+S8 live_edit_max ALIGN = 0;
+
+// code list of main.c
+extern U1 **code;
+extern S8 linenum ALIGN;
+
+#define LIVE_SET(set, reg) ((set)[(reg) / 8] |= (1 << ((reg) % 8)))
+#define LIVE_CLEAR(set, reg) ((set)[(reg) / 8] &= ~(1 << ((reg) % 8)))
+#define LIVE_TEST(set, reg) ((set)[(reg) / 8] & (1 << ((reg) % 8)))
+
+S2 set_save_regs (S8 first, S8 last, U1 *regi, U1 *regd)
+{
+	if (save_regs_ind >= MAXSAVEREGS - 1)
+	{
+		// no liveness for this save: the code is kept as it is
+		save_regs_skip = 1;
+		return (1);
+	}
+	save_regs_ind++;
+	save_regs_skip = 0;
+
+	save_regs[save_regs_ind].first = first;
+	save_regs[save_regs_ind].last = last;
+	memcpy (save_regs[save_regs_ind].regi, regi, MAXREG);
+	memcpy (save_regs[save_regs_ind].regd, regd, MAXREG);
+	save_regs[save_regs_ind].loaded = 0;
+	save_regs[save_regs_ind].removed = 0;
+	return (0);
+}
+
+S2 set_load_regs (S8 first, S8 last)
+{
+	if (save_regs_ind == -1 || save_regs_skip == 1 || load_regs_ind >= MAXLOADREGS - 1)
+	{
+		return (1);
+	}
+	load_regs_ind++;
+
+	load_regs[load_regs_ind].first = first;
+	load_regs[load_regs_ind].last = last;
+	load_regs[load_regs_ind].save = save_regs_ind;
+	save_regs[save_regs_ind].loaded = 1;
+	return (0);
+}
+
+// start of a function: name is the label
+S2 set_live_func (U1 *name, S8 start, U1 regfunc, U1 inline_func)
+{
+	if (live_func_ind >= MAXLIVEFUNCS - 1)
+	{
+		// the function is not optimized
+		return (1);
+	}
+	live_func_ind++;
+
+	live_func[live_func_ind].start = start;
+	live_func[live_func_ind].end = -1;
+	live_func[live_func_ind].save_first = save_regs_ind + 1;
+	live_func[live_func_ind].load_first = load_regs_ind + 1;
+	strcpy ((char *) live_func[live_func_ind].name, (const char *) name);
+	live_func[live_func_ind].regfunc = regfunc;
+	live_func[live_func_ind].inline_func = inline_func;
+	live_func[live_func_ind].inlinable = 0;
+	live_func[live_func_ind].rename = 0;
+	return (0);
+}
+
+// end of a function: the code line of rts
+S2 set_live_func_end (S8 end)
+{
+	if (live_func_ind == -1 || live_func[live_func_ind].end != -1)
+	{
+		return (1);
+	}
+
+	live_func[live_func_ind].end = end;
+	live_func[live_func_ind].save_last = save_regs_ind;
+	live_func[live_func_ind].load_last = load_regs_ind;
+	return (0);
+}
+
+// a code line was inserted at pos: move the recorded lines from pos on down
+void shift_live_lines (S8 pos)
+{
+	S8 i ALIGN;
+
+	for (i = 0; i <= save_regs_ind; i++)
+	{
+		if (save_regs[i].first >= pos)
+		{
+			save_regs[i].first++;
+		}
+		if (save_regs[i].last >= pos)
+		{
+			save_regs[i].last++;
+		}
+	}
+
+	for (i = 0; i <= load_regs_ind; i++)
+	{
+		if (load_regs[i].first >= pos)
+		{
+			load_regs[i].first++;
+		}
+		if (load_regs[i].last >= pos)
+		{
+			load_regs[i].last++;
+		}
+	}
+
+	for (i = 0; i <= live_func_ind; i++)
+	{
+		if (live_func[i].start >= pos)
+		{
+			live_func[i].start++;
+		}
+		if (live_func[i].end >= pos)
+		{
+			live_func[i].end++;
+		}
+	}
+}
+
+static S8 get_reg_num (U1 *arg)
+{
+	// register argument: "I3", "F3" or "3"
+	if (arg[0] == 'I' || arg[0] == 'F')
+	{
+		arg++;
+	}
+	if (arg[0] < '0' || arg[0] > '9')
+	{
+		return (-1);
+	}
+	return (atoll ((const char *) arg));
+}
+
+static S2 get_opcode (U1 *name)
+{
+	S2 i;
+
+	for (i = 0; i < MAXOPCODES; i++)
+	{
+		if (strcmp ((const char *) opcode[i].op, (const char *) name) == 0)
+		{
+			return (i);
+		}
+	}
+	return (-2);
+}
+
+// split the code line into the opcode and its arguments
+static void split_line (U1 *line, U1 args[5][MAXLINELEN])
+{
+	S4 i = 0, j = 0, a = 0;
+	S4 slen;
+
+	slen = strlen ((const char *) line);
+	while (i < slen && (line[i] == ' ' || line[i] == '\t'))
+	{
+		i++;
+	}
+
+	for (a = 0; a < 5; a++)
+	{
+		args[a][0] = '\0';
+	}
+	a = 0;
+
+	for (; i <= slen && a < 5; i++)
+	{
+		if (line[i] == '\0' || line[i] == ',' || (a == 0 && (line[i] == ' ' || line[i] == '\t')))
+		{
+			args[a][j] = '\0';
+			a++;
+			j = 0;
+
+			// skip spaces after the opcode or the comma
+			while (i + 1 < slen && (line[i + 1] == ' ' || line[i + 1] == '\t'))
+			{
+				i++;
+			}
+			continue;
+		}
+		if (line[i] != ' ' && line[i] != '\t' && j < MAXLINELEN - 1)
+		{
+			args[a][j] = line[i];
+			j++;
+		}
+	}
+}
+
+static void parse_live_op (U1 *line, struct live_op *op)
+{
+	U1 args[5][MAXLINELEN];
+	S4 a;
+
+	split_line (line, args);
+
+	op->target = -1;
+	op->save = -1;
+	op->load = -1;
+	op->name[0] = '\0';
+
+	if (args[0][0] == ':')
+	{
+		op->op = -1;
+		strcpy ((char *) op->name, (const char *) args[0]);
+		for (a = 0; a < 4; a++)
+		{
+			op->arg[a] = -1;
+		}
+		return;
+	}
+
+	op->op = get_opcode (args[0]);
+	for (a = 0; a < 4; a++)
+	{
+		op->arg[a] = get_reg_num (args[a + 1]);
+		if (args[a + 1][0] == ':')
+		{
+			// jump target
+			strcpy ((char *) op->name, (const char *) args[a + 1]);
+		}
+	}
+}
+
+// registers read (use) and set (def) by the opcode
+static void get_use_def (struct live_op *op, U1 *use, U1 *def)
+{
+	S8 r ALIGN;
+	S4 a;
+
+	memset (use, 0, LIVE_BYTES);
+	memset (def, 0, LIVE_BYTES);
+
+	if (op->save >= 0)
+	{
+		// the registers which are saved and loaded again
+		memcpy (use, save_regs[op->save].live, LIVE_BYTES);
+		return;
+	}
+	if (op->load >= 0)
+	{
+		for (r = 0; r < MAXREG; r++)
+		{
+			if (save_regs[op->load].regi[r] == 1)
+			{
+				LIVE_SET (def, r);
+			}
+			if (save_regs[op->load].regd[r] == 1)
+			{
+				LIVE_SET (def, MAXREG + r);
+			}
+		}
+		return;
+	}
+
+	switch (op->op)
+	{
+		case -1:
+			// label
+			return;
+
+		case PUSHB:
+		case PUSHW:
+		case PUSHDW:
+		case PUSHQW:
+		case PUSHWS:
+		case PUSHDWS:
+		case PUSHQWS:
+		case ADDI:
+		case SUBI:
+		case MULI:
+		case DIVI:
+		case SMULI:
+		case SDIVI:
+		case ANDI:
+		case ORI:
+		case BANDI:
+		case BORI:
+		case BXORI:
+		case MODI:
+		case EQI:
+		case NEQI:
+		case GRI:
+		case LSI:
+		case GREQI:
+		case LSEQI:
+			if (op->arg[0] >= 0) LIVE_SET (use, op->arg[0]);
+			if (op->arg[1] >= 0) LIVE_SET (use, op->arg[1]);
+			if (op->arg[2] >= 0) LIVE_SET (def, op->arg[2]);
+			return;
+
+		case PUSHD:
+		case PUSHDS:
+			if (op->arg[0] >= 0) LIVE_SET (use, op->arg[0]);
+			if (op->arg[1] >= 0) LIVE_SET (use, op->arg[1]);
+			if (op->arg[2] >= 0) LIVE_SET (def, MAXREG + op->arg[2]);
+			return;
+
+		case PULLB:
+		case PULLW:
+		case PULLDW:
+		case PULLQW:
+		case PULLWS:
+		case PULLDWS:
+		case PULLQWS:
+			for (a = 0; a < 3; a++)
+			{
+				if (op->arg[a] >= 0) LIVE_SET (use, op->arg[a]);
+			}
+			return;
+
+		case PULLD:
+		case PULLDS:
+			if (op->arg[0] >= 0) LIVE_SET (use, MAXREG + op->arg[0]);
+			if (op->arg[1] >= 0) LIVE_SET (use, op->arg[1]);
+			if (op->arg[2] >= 0) LIVE_SET (use, op->arg[2]);
+			return;
+
+		case ADDD:
+		case SUBD:
+		case MULD:
+		case DIVD:
+			if (op->arg[0] >= 0) LIVE_SET (use, MAXREG + op->arg[0]);
+			if (op->arg[1] >= 0) LIVE_SET (use, MAXREG + op->arg[1]);
+			if (op->arg[2] >= 0) LIVE_SET (def, MAXREG + op->arg[2]);
+			return;
+
+		case EQD:
+		case NEQD:
+		case GRD:
+		case LSD:
+		case GREQD:
+		case LSEQD:
+			if (op->arg[0] >= 0) LIVE_SET (use, MAXREG + op->arg[0]);
+			if (op->arg[1] >= 0) LIVE_SET (use, MAXREG + op->arg[1]);
+			if (op->arg[2] >= 0) LIVE_SET (def, op->arg[2]);
+			return;
+
+		case JMPI:
+		case JMPA:
+		case JSRA:
+		case JMPT:
+		case STPUSHB:
+		case STPUSHI:
+			if (op->arg[0] >= 0) LIVE_SET (use, op->arg[0]);
+			return;
+
+		case STPUSHD:
+			if (op->arg[0] >= 0) LIVE_SET (use, MAXREG + op->arg[0]);
+			return;
+
+		case STPOPB:
+		case STPOPI:
+			if (op->arg[0] >= 0) LIVE_SET (def, op->arg[0]);
+			return;
+
+		case STPOPD:
+			if (op->arg[0] >= 0) LIVE_SET (def, MAXREG + op->arg[0]);
+			return;
+
+		case STPUSHIR:
+		case STPUSHDR:
+		case STPOPIR:
+		case STPOPDR:
+			if (op->arg[0] >= 0 && op->arg[1] < MAXREG)
+			{
+				for (r = op->arg[0]; r <= op->arg[1]; r++)
+				{
+					if (op->op == STPUSHIR) LIVE_SET (use, r);
+					if (op->op == STPUSHDR) LIVE_SET (use, MAXREG + r);
+					if (op->op == STPOPIR) LIVE_SET (def, r);
+					if (op->op == STPOPDR) LIVE_SET (def, MAXREG + r);
+				}
+			}
+			return;
+
+		case LOADA:
+		case LOAD:
+			if (op->arg[2] >= 0) LIVE_SET (def, op->arg[2]);
+			return;
+
+		case LOADD:
+			if (op->arg[2] >= 0) LIVE_SET (def, MAXREG + op->arg[2]);
+			return;
+
+		case LOADL:
+			if (op->arg[1] >= 0) LIVE_SET (def, op->arg[1]);
+			return;
+
+		case INCLSIJMPI:
+		case DECGRIJMPI:
+		case NOTI:
+		case MOVI:
+			if (op->arg[0] >= 0) LIVE_SET (use, op->arg[0]);
+			if (op->op != NOTI && op->op != MOVI && op->arg[1] >= 0) LIVE_SET (use, op->arg[1]);
+			if (op->op == NOTI || op->op == MOVI)
+			{
+				if (op->arg[1] >= 0) LIVE_SET (def, op->arg[1]);
+			}
+			return;
+
+		case MOVD:
+			if (op->arg[0] >= 0) LIVE_SET (use, MAXREG + op->arg[0]);
+			if (op->arg[1] >= 0) LIVE_SET (def, MAXREG + op->arg[1]);
+			return;
+
+		case SHLI:
+			// the number of bits is not a register
+			if (op->arg[0] >= 0) LIVE_SET (use, op->arg[0]);
+			if (op->arg[2] >= 0) LIVE_SET (def, op->arg[2]);
+			return;
+
+		case JSR:
+		case RTS:
+			// the register calling convention arguments and return values
+			for (r = REGCALL_REG; r < MAXREG; r++)
+			{
+				LIVE_SET (use, r);
+				LIVE_SET (use, MAXREG + r);
+			}
+			return;
+
+		case JMP:
+			return;
+	}
+
+	// intr0, intr1 and unknown opcodes: every number argument can be a int or double register
+	for (a = 0; a < 4; a++)
+	{
+		if (a == 0 && (op->op == INTR0 || op->op == INTR1))
+		{
+			// interrupt number
+			continue;
+		}
+		if (op->arg[a] >= 0 && op->arg[a] < MAXREG)
+		{
+			LIVE_SET (use, op->arg[a]);
+			LIVE_SET (use, MAXREG + op->arg[a]);
+		}
+	}
+}
+
+static S8 get_label_op (struct live_op *ops, S8 n, U1 *name)
+{
+	S8 i ALIGN;
+
+	for (i = 0; i < n; i++)
+	{
+		if (ops[i].op == -1 && strcmp ((const char *) ops[i].name, (const char *) name) == 0)
+		{
+			return (i);
+		}
+	}
+	return (-2);
+}
+
+// write the push or pop opcodes of the registers set in regs (int or double) to text
+static S2 write_regs_text (U1 *text, U1 *op, U1 *regs, U1 pop)
+{
+	U1 line[MAXLINELEN];
+	S4 first[MAXREG], last[MAXREG];
+	S4 ranges = 0;
+	S4 e, i;
+
+	for (e = 0; e < MAXREG; e++)
+	{
+		if (regs[e] == 1)
+		{
+			// a small gap of not live registers is saved too: one range opcode is faster than two opcodes
+			if (ranges > 0 && e - last[ranges - 1] - 1 <= LIVE_GAP)
+			{
+				last[ranges - 1] = e;
+			}
+			else
+			{
+				first[ranges] = e;
+				last[ranges] = e;
+				ranges++;
+			}
+		}
+	}
+
+	for (e = 0; e < ranges; e++)
+	{
+		i = e;
+		if (pop == 1)
+		{
+			i = ranges - 1 - e;
+		}
+		if (first[i] == last[i])
+		{
+			snprintf ((char *) line, MAXLINELEN, "%s %i\n", op, first[i]);
+		}
+		else
+		{
+			snprintf ((char *) line, MAXLINELEN, "%sr %i, %i\n", op, first[i], last[i]);
+		}
+		if (strlen ((const char *) text) + strlen ((const char *) line) >= MAXLINELEN)
+		{
+			return (1);
+		}
+		strcat ((char *) text, (const char *) line);
+	}
+	return (0);
+}
+
+// set the code lines first to last to text
+static void set_code_lines (S8 first, S8 last, U1 *text)
+{
+	S8 i ALIGN;
+
+	strcpy ((char *) code[first], (const char *) text);
+	for (i = first + 1; i <= last; i++)
+	{
+		strcpy ((char *) code[i], "");
+	}
+}
+
+// opcodes which end a basic block
+static U1 is_branch (struct live_op *op)
+{
+	switch (op->op)
+	{
+		case -2:
+		case -1:
+		case JMP:
+		case JMPI:
+		case JMPA:
+		case JSR:
+		case JSRA:
+		case RTS:
+		case INCLSIJMPI:
+		case DECGRIJMPI:
+		case JMPT:
+			return (1);
+	}
+	return (0);
+}
+
+// registers live after the opcode i
+static void get_live_out (struct live_info *info, S8 i, U1 *out)
+{
+	struct live_op *ops = info->ops;
+	S8 j ALIGN;
+	S4 r;
+
+	memset (out, 0, LIVE_BYTES);
+
+	switch (ops[i].op)
+	{
+		case RTS:
+			return;
+
+		case JMPA:
+			// unknown target
+			memset (out, 0xff, LIVE_BYTES);
+			return;
+
+		case JMP:
+		case JMPI:
+		case INCLSIJMPI:
+		case DECGRIJMPI:
+		case JMPT:
+			if (ops[i].target == -2)
+			{
+				// label not in this function
+				memset (out, 0xff, LIVE_BYTES);
+			}
+			if (ops[i].target >= 0)
+			{
+				memcpy (out, &info->live_in[ops[i].target * LIVE_BYTES], LIVE_BYTES);
+			}
+			if (ops[i].op == JMP)
+			{
+				return;
+			}
+			if (ops[i].op == JMPT)
+			{
+				// the jmp table after jmpt
+				for (j = i + 1; j < info->n && j <= i + ops[i].arg[1]; j++)
+				{
+					for (r = 0; r < LIVE_BYTES; r++)
+					{
+						out[r] |= info->live_in[j * LIVE_BYTES + r];
+					}
+				}
+				return;
+			}
+			break;
+	}
+
+	if (i + 1 < info->n)
+	{
+		for (r = 0; r < LIVE_BYTES; r++)
+		{
+			out[r] |= info->live_in[(i + 1) * LIVE_BYTES + r];
+		}
+	}
+}
+
+static void live_free (struct live_info *info)
+{
+	free (info->ops);
+	free (info->live_in);
+	info->ops = NULL;
+	info->live_in = NULL;
+	info->n = 0;
+}
+
+// get the opcodes of the function and the live registers before every opcode.
+// The registers of the saves live after their loads are set in save_regs[].live
+static S2 live_analyze (struct live_func *f, struct live_info *info)
+{
+	struct live_op *ops = NULL;
+	U1 *live_in = NULL;
+	U1 out[LIVE_BYTES], in[LIVE_BYTES], use[LIVE_BYTES], def[LIVE_BYTES];
+	U1 new_live[LIVE_BYTES];
+	U1 line[MAXLINELEN];
+	S8 *load_last_op = NULL;
+	S8 n = 0, i ALIGN, s ALIGN, l ALIGN, row ALIGN;
+	S4 pos, start, len, r;
+	U1 changed, kept_changed, ok;
+
+	info->ops = NULL;
+	info->live_in = NULL;
+	info->n = 0;
+
+	// count the opcodes of the function: a code line can have more than one opcode
+	for (row = f->start; row <= f->end; row++)
+	{
+		for (pos = 0; code[row][pos] != '\0'; pos++)
+		{
+			if (code[row][pos] == '\n')
+			{
+				n++;
+			}
+		}
+		n++;
+	}
+
+	ops = (struct live_op *) calloc (n, sizeof (struct live_op));
+	live_in = (U1 *) calloc (n, LIVE_BYTES);
+	load_last_op = (S8 *) calloc (f->load_last - f->load_first + 2, sizeof (S8));
+	if (ops == NULL || live_in == NULL || load_last_op == NULL)
+	{
+		printf ("error: liveness: out of memory!\n");
+		free (ops);
+		free (live_in);
+		free (load_last_op);
+		return (1);
+	}
+
+	for (l = f->load_first; l <= f->load_last; l++)
+	{
+		load_last_op[l - f->load_first] = -1;
+	}
+
+	// parse the opcodes
+	n = 0;
+	for (row = f->start; row <= f->end; row++)
+	{
+		pos = 0;
+		while (code[row][pos] != '\0')
+		{
+			start = pos;
+			len = 0;
+			while (code[row][pos + len] != '\0' && code[row][pos + len] != '\n')
+			{
+				len++;
+			}
+			pos += len;
+			if (code[row][pos] == '\n')
+			{
+				pos++;
+			}
+
+			if (len >= MAXLINELEN)
+			{
+				memcpy (line, &code[row][start], MAXLINELEN - 1);
+				line[MAXLINELEN - 1] = '\0';
+			}
+			else
+			{
+				memcpy (line, &code[row][start], len);
+				line[len] = '\0';
+			}
+
+			// remove comment
+			for (r = 0; line[r] != '\0'; r++)
+			{
+				if (line[r] == '/' && line[r + 1] == '/')
+				{
+					line[r] = '\0';
+					break;
+				}
+			}
+
+			parse_live_op (line, &ops[n]);
+			if (ops[n].op == -2)
+			{
+				// empty line
+				ok = 1;
+				for (r = 0; line[r] != '\0'; r++)
+				{
+					if (line[r] != ' ' && line[r] != '\t' && line[r] != '\r')
+					{
+						ok = 0;
+					}
+				}
+				if (ok == 1)
+				{
+					continue;
+				}
+			}
+
+			ops[n].row = row;
+			ops[n].pos = start;
+			ops[n].len = len;
+
+			for (s = f->save_first; s <= f->save_last; s++)
+			{
+				if (row >= save_regs[s].first && row <= save_regs[s].last)
+				{
+					ops[n].save = s;
+				}
+			}
+			for (l = f->load_first; l <= f->load_last; l++)
+			{
+				if (row >= load_regs[l].first && row <= load_regs[l].last)
+				{
+					ops[n].load = load_regs[l].save;
+					load_last_op[l - f->load_first] = n;
+				}
+			}
+			n++;
+		}
+	}
+
+	// jump targets
+	for (i = 0; i < n; i++)
+	{
+		if (ops[i].op >= 0 && ops[i].name[0] == ':')
+		{
+			ops[i].target = get_label_op (ops, n, ops[i].name);
+		}
+	}
+
+	info->ops = ops;
+	info->live_in = live_in;
+	info->n = n;
+
+	for (s = f->save_first; s <= f->save_last; s++)
+	{
+		memset (save_regs[s].live, 0, LIVE_BYTES);
+	}
+
+	// the saved registers live after a load are found by iteration: a saved register is read by the push
+	// of the save, so it can be live after an other load
+	kept_changed = 1;
+	while (kept_changed == 1)
+	{
+		memset (live_in, 0, n * LIVE_BYTES);
+
+		changed = 1;
+		while (changed == 1)
+		{
+			changed = 0;
+			for (i = n - 1; i >= 0; i--)
+			{
+				get_live_out (info, i, out);
+				get_use_def (&ops[i], use, def);
+				for (r = 0; r < LIVE_BYTES; r++)
+				{
+					in[r] = use[r] | (out[r] & ~def[r]);
+				}
+
+				if (memcmp (in, &live_in[i * LIVE_BYTES], LIVE_BYTES) != 0)
+				{
+					memcpy (&live_in[i * LIVE_BYTES], in, LIVE_BYTES);
+					changed = 1;
+				}
+			}
+		}
+
+		// saved registers live after the loads
+		kept_changed = 0;
+		for (s = f->save_first; s <= f->save_last; s++)
+		{
+			memset (new_live, 0, LIVE_BYTES);
+			for (l = f->load_first; l <= f->load_last; l++)
+			{
+				if (load_regs[l].save != s || load_last_op[l - f->load_first] == -1)
+				{
+					continue;
+				}
+				i = load_last_op[l - f->load_first];
+				if (i + 1 < n)
+				{
+					for (r = 0; r < LIVE_BYTES; r++)
+					{
+						new_live[r] |= live_in[(i + 1) * LIVE_BYTES + r];
+					}
+				}
+			}
+			for (r = 0; r < MAXREG; r++)
+			{
+				if (save_regs[s].regi[r] == 0)
+				{
+					LIVE_CLEAR (new_live, r);
+				}
+				if (save_regs[s].regd[r] == 0)
+				{
+					LIVE_CLEAR (new_live, MAXREG + r);
+				}
+			}
+			for (r = 0; r < LIVE_BYTES; r++)
+			{
+				if ((new_live[r] | save_regs[s].live[r]) != save_regs[s].live[r])
+				{
+					save_regs[s].live[r] |= new_live[r];
+					kept_changed = 1;
+				}
+			}
+		}
+	}
+
+	free (load_last_op);
+	return (0);
+}
+
+// set the saves and loads of the function to the live registers
+static void write_live_regs (struct live_func *f)
+{
+	U1 regi[MAXREG], regd[MAXREG];
+	U1 save_text[MAXLINELEN], load_text[MAXLINELEN];
+	S8 s ALIGN, l ALIGN;
+	S4 r;
+
+	for (s = f->save_first; s <= f->save_last; s++)
+	{
+		if (save_regs[s].loaded == 0 || save_regs[s].removed == 1 || save_regs[s].first > save_regs[s].last)
+		{
+			continue;
+		}
+
+		for (r = 0; r < MAXREG; r++)
+		{
+			regi[r] = LIVE_TEST (save_regs[s].live, r) ? 1 : 0;
+			regd[r] = LIVE_TEST (save_regs[s].live, MAXREG + r) ? 1 : 0;
+		}
+
+		strcpy ((char *) save_text, "");
+		strcpy ((char *) load_text, "");
+		if (write_regs_text (save_text, (U1 *) "stpushi", regi, 0) != 0 || write_regs_text (save_text, (U1 *) "stpushd", regd, 0) != 0
+			|| write_regs_text (load_text, (U1 *) "stpopd", regd, 1) != 0 || write_regs_text (load_text, (U1 *) "stpopi", regi, 1) != 0)
+		{
+			// too long for a code line: keep the saves and loads
+			continue;
+		}
+
+		set_code_lines (save_regs[s].first, save_regs[s].last, save_text);
+		for (l = f->load_first; l <= f->load_last; l++)
+		{
+			if (load_regs[l].save == s && load_regs[l].first <= load_regs[l].last)
+			{
+				set_code_lines (load_regs[l].first, load_regs[l].last, load_text);
+			}
+		}
+	}
+}
+
+// check if the function can be inlined: no calls and no jumps out of the function
+static U1 check_inline (struct live_func *f)
+{
+	struct live_info info;
+	S8 i ALIGN, count ALIGN = 0;
+	S4 r;
+	U1 ok = 1;
+
+	if (f->end == -1 || f->regfunc == 1 || strcmp ((const char *) f->name, ":main") == 0)
+	{
+		return (0);
+	}
+	if (f->save_first <= f->save_last || f->load_first <= f->load_last)
+	{
+		// function with calls
+		ok = 0;
+	}
+
+	if (ok == 1)
+	{
+		if (live_analyze (f, &info) != 0)
+		{
+			return (0);
+		}
+
+		if (info.n < 2 || info.ops[0].op != -1 || info.ops[info.n - 1].op != RTS)
+		{
+			ok = 0;
+		}
+
+		for (i = 1; ok == 1 && i < info.n - 1; i++)
+		{
+			switch (info.ops[i].op)
+			{
+				case -2:
+				case JSR:
+				case JSRA:
+				case JMPA:
+				case RTS:
+					ok = 0;
+					break;
+			}
+
+			// jump to the function start or out of the function
+			if (info.ops[i].target == 0 || info.ops[i].target == -2)
+			{
+				ok = 0;
+			}
+			if (info.ops[i].op >= 0)
+			{
+				count++;
+			}
+		}
+
+		if (count > INLINE_MAXOPS && f->inline_func == 0)
+		{
+			ok = 0;
+		}
+
+		// the registers can be renamed, if the function doesn't read registers set by the caller
+		f->rename = 1;
+		for (r = 0; r < REGCALL_REG; r++)
+		{
+			if (LIVE_TEST (info.live_in, r) || LIVE_TEST (info.live_in, MAXREG + r))
+			{
+				f->rename = 0;
+			}
+		}
+
+		live_free (&info);
+	}
+
+	if (ok == 0 && f->inline_func == 1)
+	{
+		printf ("warning: function %s can't be inlined!\n", &f->name[1]);
+	}
+	return (ok);
+}
+
+static S8 get_inline_func (U1 *name)
+{
+	S8 f ALIGN;
+
+	for (f = 0; f <= live_func_ind; f++)
+	{
+		if (live_func[f].inlinable == 1 && strcmp ((const char *) live_func[f].name, (const char *) name) == 0)
+		{
+			return (f);
+		}
+	}
+	return (-1);
+}
+
+static S2 add_live_edit (S8 row, S4 pos, S4 len, U1 *text)
+{
+	struct live_edit *edit;
+
+	if (live_edit_ind >= live_edit_max - 1)
+	{
+		edit = (struct live_edit *) realloc (live_edit, (live_edit_max + 256) * sizeof (struct live_edit));
+		if (edit == NULL)
+		{
+			printf ("error: inline: out of memory!\n");
+			return (1);
+		}
+		live_edit = edit;
+		live_edit_max += 256;
+	}
+
+	live_edit_ind++;
+	live_edit[live_edit_ind].row = row;
+	live_edit[live_edit_ind].pos = pos;
+	live_edit[live_edit_ind].len = len;
+	live_edit[live_edit_ind].text = (U1 *) strdup ((const char *) text);
+	if (live_edit[live_edit_ind].text == NULL)
+	{
+		printf ("error: inline: out of memory!\n");
+		live_edit_ind--;
+		return (1);
+	}
+	return (0);
+}
+
+static int compare_live_edit (const void *a, const void *b)
+{
+	const struct live_edit *ea = (const struct live_edit *) a;
+	const struct live_edit *eb = (const struct live_edit *) b;
+
+	// code lines in order, the opcodes of a code line from the end
+	if (ea->row != eb->row)
+	{
+		return (ea->row < eb->row ? -1 : 1);
+	}
+	if (ea->pos != eb->pos)
+	{
+		return (ea->pos > eb->pos ? -1 : 1);
+	}
+	return (0);
+}
+
+// replace the opcodes in the code lines
+static S2 apply_live_edits (void)
+{
+	U1 *new_line;
+	S8 e ALIGN;
+	S4 end, old_len, text_len, new_len;
+	S2 ret = 0;
+
+	if (live_edit_ind == -1)
+	{
+		return (0);
+	}
+
+	qsort (live_edit, live_edit_ind + 1, sizeof (struct live_edit), compare_live_edit);
+
+	for (e = 0; e <= live_edit_ind; e++)
+	{
+		if (ret == 0)
+		{
+			old_len = strlen ((const char *) code[live_edit[e].row]);
+			end = live_edit[e].pos + live_edit[e].len;
+			if (code[live_edit[e].row][end] == '\n')
+			{
+				end++;
+			}
+			text_len = strlen ((const char *) live_edit[e].text);
+			new_len = live_edit[e].pos + text_len + (old_len - end);
+
+			// the code line gets longer than MAXLINELEN by an inlined function
+			new_line = (U1 *) calloc (new_len + 1 > MAXLINELEN ? new_len + 1 : MAXLINELEN, sizeof (U1));
+			if (new_line == NULL)
+			{
+				printf ("error: inline: out of memory!\n");
+				ret = 1;
+			}
+			else
+			{
+				memcpy (new_line, code[live_edit[e].row], live_edit[e].pos);
+				memcpy (&new_line[live_edit[e].pos], live_edit[e].text, text_len);
+				memcpy (&new_line[live_edit[e].pos + text_len], &code[live_edit[e].row][end], old_len - end);
+				new_line[new_len] = '\0';
+
+				free (code[live_edit[e].row]);
+				code[live_edit[e].row] = new_line;
+			}
+		}
+		free (live_edit[e].text);
+	}
+
+	live_edit_ind = -1;
+	return (ret);
+}
+
+// label of the inlined function with the inline suffix, returns 1 if it is too long
+static S2 inline_label (U1 *dest, U1 *label)
+{
+	U1 suffix[32];
+
+	snprintf ((char *) suffix, 32, "_inline_%lli", inline_ind);
+	if (strlen ((const char *) label) + strlen ((const char *) suffix) >= MAXLINELEN)
+	{
+		return (1);
+	}
+	strcpy ((char *) dest, (const char *) label);
+	strcat ((char *) dest, (const char *) suffix);
+	return (0);
+}
+
+// write the opcode of the inlined function with renamed registers and labels
+static S2 write_inline_op (U1 *text, struct live_op *op, S8 *map_i, S8 *map_d)
+{
+	U1 line[MAXLINELEN];
+	U1 args[5][MAXLINELEN];
+	U1 arg[MAXLINELEN];
+	S8 reg ALIGN;
+	S4 a, len;
+
+	len = op->len;
+	if (len >= MAXLINELEN)
+	{
+		len = MAXLINELEN - 1;
+	}
+	memcpy (line, &code[op->row][op->pos], len);
+	line[len] = '\0';
+
+	for (a = 0; line[a] != '\0'; a++)
+	{
+		if (line[a] == '/' && line[a + 1] == '/')
+		{
+			line[a] = '\0';
+			break;
+		}
+	}
+
+	split_line (line, args);
+
+	if (op->op == -1)
+	{
+		if (inline_label (line, args[0]) != 0)
+		{
+			return (1);
+		}
+		strcat ((char *) text, (const char *) line);
+		strcat ((char *) text, "\n");
+		return (0);
+	}
+
+	strcpy ((char *) line, (const char *) args[0]);
+	for (a = 0; a < opcode[op->op].args && a < 4; a++)
+	{
+		reg = get_reg_num (args[a + 1]);
+		if (opcode[op->op].type[a] == I_REG && reg >= 0 && reg < MAXREG)
+		{
+			snprintf ((char *) arg, MAXLINELEN, "%lli", map_i[reg]);
+		}
+		else if (opcode[op->op].type[a] == D_REG && reg >= 0 && reg < MAXREG)
+		{
+			snprintf ((char *) arg, MAXLINELEN, "%lli", map_d[reg]);
+		}
+		else if (args[a + 1][0] == ':')
+		{
+			if (inline_label (arg, args[a + 1]) != 0)
+			{
+				return (1);
+			}
+		}
+		else
+		{
+			strcpy ((char *) arg, (const char *) args[a + 1]);
+		}
+
+		if (strlen ((const char *) line) + strlen ((const char *) arg) + 3 < MAXLINELEN)
+		{
+			strcat ((char *) line, a == 0 ? " " : ", ");
+			strcat ((char *) line, (const char *) arg);
+		}
+	}
+	strcat ((char *) text, (const char *) line);
+	strcat ((char *) text, "\n");
+	return (0);
+}
+
+// inline the function g at the jsr opcode i of the function f.
+// The registers of g are renamed to registers not live after the call. If the call is between a save and a load,
+// which are only needed for the call, they are removed. Argument and return value pushes and pops are set to moves.
+static S2 inline_call (struct live_func *f, struct live_info *info, S8 i, struct live_func *g)
+{
+	struct live_info body;
+	struct live_op *ops = info->ops;
+	struct live_op *bops = NULL;
+	struct live_op **vops = NULL;
+	U1 *text = NULL;
+	U1 *del = NULL;
+	S8 *mov = NULL;
+	S8 *vind = NULL;
+	S8 *st_vop = NULL, *st_reg = NULL;
+	U1 *st_valid = NULL;
+	S2 *st_type = NULL;
+	U1 avoid[LIVE_BYTES], use[LIVE_BYTES], def[LIVE_BYTES];
+	U1 need_i[MAXREG], need_d[MAXREG];
+	U1 line[MAXLINELEN];
+	S8 map_i[MAXREG], map_d[MAXREG];
+	S8 j ALIGN, k ALIGN, l ALIGN, v ALIGN, nv ALIGN, sp ALIGN, t ALIGN;
+	S8 s ALIGN = -1, save_op ALIGN = -1, load_op ALIGN = -1, loads ALIGN = 0;
+	S8 before ALIGN, after ALIGN;
+	S4 a, r;
+	U1 identity = 0, remove = 0, stop = 0;
+	S2 ret = 1;
+
+	if (live_analyze (g, &body) != 0)
+	{
+		return (1);
+	}
+
+	// the labels get the inline suffix, a truncated label could be the same as an other one
+	for (j = 1; j < body.n - 1; j++)
+	{
+		if (body.ops[j].name[0] == ':' && inline_label (line, body.ops[j].name) != 0)
+		{
+			printf ("warning: function %s not inlined, label %s too long!\n", &g->name[1], body.ops[j].name);
+			ret = 0;
+			goto inline_end;
+		}
+	}
+
+	if (g->rename == 0)
+	{
+		identity = 1;
+	}
+
+	// the registers of interrupts can't be renamed
+	for (j = 1; j < body.n - 1; j++)
+	{
+		if (body.ops[j].op == INTR0 || body.ops[j].op == INTR1)
+		{
+			identity = 1;
+		}
+	}
+
+	// the save before and the load after the call
+	for (j = i - 1; j >= 0; j--)
+	{
+		if (ops[j].save >= 0)
+		{
+			s = ops[j].save;
+			save_op = j;
+			break;
+		}
+		if (is_branch (&ops[j]) || ops[j].load >= 0)
+		{
+			break;
+		}
+	}
+	before = j + 1;
+
+	for (k = i + 1; k < info->n; k++)
+	{
+		if (ops[k].load >= 0)
+		{
+			if (s >= 0 && ops[k].load == s)
+			{
+				load_op = k;
+			}
+			break;
+		}
+		if (is_branch (&ops[k]) || ops[k].save >= 0)
+		{
+			break;
+		}
+	}
+	after = k - 1;
+
+	// registers which can't be used by the function: live after the call, saved, and the arguments
+	memset (avoid, 0, LIVE_BYTES);
+	if (i + 1 < info->n)
+	{
+		memcpy (avoid, &info->live_in[(i + 1) * LIVE_BYTES], LIVE_BYTES);
+	}
+	if (s >= 0)
+	{
+		for (r = 0; r < LIVE_BYTES; r++)
+		{
+			avoid[r] |= save_regs[s].live[r];
+		}
+	}
+	for (j = before; j < i; j++)
+	{
+		get_use_def (&ops[j], use, def);
+		for (r = 0; r < LIVE_BYTES; r++)
+		{
+			avoid[r] |= use[r];
+		}
+	}
+	for (r = REGCALL_REG; r < MAXREG; r++)
+	{
+		LIVE_SET (avoid, r);
+		LIVE_SET (avoid, MAXREG + r);
+	}
+
+	for (r = 0; r < MAXREG; r++)
+	{
+		map_i[r] = r;
+		map_d[r] = r;
+	}
+
+	if (identity == 0)
+	{
+		memset (need_i, 0, MAXREG);
+		memset (need_d, 0, MAXREG);
+		for (j = 1; j < body.n - 1; j++)
+		{
+			if (body.ops[j].op < 0)
+			{
+				continue;
+			}
+			for (a = 0; a < opcode[body.ops[j].op].args && a < 4; a++)
+			{
+				if (body.ops[j].arg[a] < 0 || body.ops[j].arg[a] >= MAXREG)
+				{
+					continue;
+				}
+				if (opcode[body.ops[j].op].type[a] == I_REG)
+				{
+					need_i[body.ops[j].arg[a]] = 1;
+				}
+				if (opcode[body.ops[j].op].type[a] == D_REG)
+				{
+					need_d[body.ops[j].arg[a]] = 1;
+				}
+			}
+		}
+
+		t = 0;
+		for (r = 0; r < MAXREG && identity == 0; r++)
+		{
+			if (need_i[r] == 1)
+			{
+				while (t < REGCALL_REG && LIVE_TEST (avoid, t))
+				{
+					t++;
+				}
+				if (t >= REGCALL_REG)
+				{
+					identity = 1;
+					break;
+				}
+				map_i[r] = t;
+				t++;
+			}
+		}
+		t = 0;
+		for (r = 0; r < MAXREG && identity == 0; r++)
+		{
+			if (need_d[r] == 1)
+			{
+				while (t < REGCALL_REG && LIVE_TEST (avoid, MAXREG + t))
+				{
+					t++;
+				}
+				if (t >= REGCALL_REG)
+				{
+					identity = 1;
+					break;
+				}
+				map_d[r] = t;
+				t++;
+			}
+		}
+
+		if (identity == 1)
+		{
+			// not enough free registers: the function is inlined with its registers
+			for (r = 0; r < MAXREG; r++)
+			{
+				map_i[r] = r;
+				map_d[r] = r;
+			}
+		}
+	}
+
+	// the opcodes of the function with renamed registers
+	bops = (struct live_op *) calloc (body.n, sizeof (struct live_op));
+	nv = (i - before) + (body.n - 2) + (after - i);
+	vops = (struct live_op **) calloc (nv + 1, sizeof (struct live_op *));
+	vind = (S8 *) calloc (nv + 1, sizeof (S8));
+	del = (U1 *) calloc (nv + 1, sizeof (U1));
+	mov = (S8 *) calloc (nv + 1, sizeof (S8));
+	st_vop = (S8 *) calloc (nv + 1, sizeof (S8));
+	st_reg = (S8 *) calloc (nv + 1, sizeof (S8));
+	st_type = (S2 *) calloc (nv + 1, sizeof (S2));
+	st_valid = (U1 *) calloc (nv + 1, sizeof (U1));
+	text = (U1 *) calloc (body.n * (MAXLINELEN + 1) + 1, sizeof (U1));
+	if (bops == NULL || vops == NULL || vind == NULL || del == NULL || mov == NULL || st_vop == NULL || st_reg == NULL || st_type == NULL || st_valid == NULL || text == NULL)
+	{
+		printf ("error: inline: out of memory!\n");
+		goto inline_end;
+	}
+
+	for (j = 0; j < body.n; j++)
+	{
+		bops[j] = body.ops[j];
+		if (bops[j].op < 0)
+		{
+			continue;
+		}
+		for (a = 0; a < opcode[bops[j].op].args && a < 4; a++)
+		{
+			if (bops[j].arg[a] < 0 || bops[j].arg[a] >= MAXREG)
+			{
+				continue;
+			}
+			if (opcode[bops[j].op].type[a] == I_REG)
+			{
+				bops[j].arg[a] = map_i[bops[j].arg[a]];
+			}
+			if (opcode[bops[j].op].type[a] == D_REG)
+			{
+				bops[j].arg[a] = map_d[bops[j].arg[a]];
+			}
+		}
+	}
+
+	// the save and load are not needed, if no saved register is set between them
+	if (s >= 0 && load_op >= 0 && identity == 0 && save_regs[s].removed == 0)
+	{
+		remove = 1;
+		for (l = f->load_first; l <= f->load_last; l++)
+		{
+			if (load_regs[l].save == s)
+			{
+				loads++;
+			}
+		}
+		if (loads != 1)
+		{
+			remove = 0;
+		}
+		for (j = save_op + 1; j < load_op && remove == 1; j++)
+		{
+			if (j == i)
+			{
+				continue;
+			}
+			get_use_def (&ops[j], use, def);
+			for (r = 0; r < LIVE_BYTES; r++)
+			{
+				if (def[r] & save_regs[s].live[r])
+				{
+					remove = 0;
+				}
+			}
+		}
+	}
+
+	// the opcodes from the arguments pushes to the return value pop
+	v = 0;
+	for (j = before; j < i; j++)
+	{
+		vops[v] = &ops[j];
+		vind[v] = -1;
+		v++;
+	}
+	for (j = 1; j < body.n - 1; j++)
+	{
+		vops[v] = &bops[j];
+		vind[v] = j;
+		v++;
+	}
+	for (j = i + 1; j <= after; j++)
+	{
+		vops[v] = &ops[j];
+		vind[v] = -1;
+		v++;
+	}
+
+	// a push and its pop are set to a move, if the pushed register is not set between them
+	for (v = 0; v < nv; v++)
+	{
+		mov[v] = -1;
+	}
+	if (identity == 1)
+	{
+		stop = 1;
+	}
+	sp = -1;
+	for (v = 0; v < nv && stop == 0; v++)
+	{
+		switch (vops[v]->op)
+		{
+			case STPUSHI:
+			case STPUSHD:
+				sp++;
+				st_vop[sp] = v;
+				st_reg[sp] = vops[v]->arg[0];
+				st_type[sp] = vops[v]->op;
+				st_valid[sp] = vops[v]->arg[0] >= 0 && vops[v]->arg[0] < MAXREG ? 1 : 0;
+				break;
+
+			case STPOPI:
+			case STPOPD:
+				if (sp < 0)
+				{
+					// pop of a value pushed before
+					break;
+				}
+				if (st_valid[sp] == 1 && vops[v]->arg[0] >= 0 && ((st_type[sp] == STPUSHI && vops[v]->op == STPOPI) || (st_type[sp] == STPUSHD && vops[v]->op == STPOPD)))
+				{
+					del[st_vop[sp]] = 1;
+					mov[v] = st_reg[sp];
+				}
+				sp--;
+				break;
+
+			case INTR0:
+			case INTR1:
+				// an interrupt can set its register arguments
+				for (j = 0; j <= sp; j++)
+				{
+					for (a = 1; a < 4; a++)
+					{
+						if (vops[v]->arg[a] == st_reg[j])
+						{
+							st_valid[j] = 0;
+						}
+					}
+				}
+				break;
+
+			case STPUSHB:
+			case STPOPB:
+			case STPUSHIR:
+			case STPOPIR:
+			case STPUSHDR:
+			case STPOPDR:
+				stop = 1;
+				break;
+
+			default:
+				if (is_branch (vops[v]) && sp >= 0)
+				{
+					// a jump or label between a push and its pop
+					stop = 1;
+				}
+				break;
+		}
+		if (stop == 1)
+		{
+			break;
+		}
+
+		get_use_def (vops[v], use, def);
+		for (j = 0; j <= sp; j++)
+		{
+			if (st_type[j] == STPUSHI && LIVE_TEST (def, st_reg[j]))
+			{
+				st_valid[j] = 0;
+			}
+			if (st_type[j] == STPUSHD && LIVE_TEST (def, MAXREG + st_reg[j]))
+			{
+				st_valid[j] = 0;
+			}
+		}
+	}
+
+	// the code of the function and the changed opcodes of the call
+	for (v = 0; v < nv; v++)
+	{
+		if (vind[v] >= 0)
+		{
+			if (del[v] == 1)
+			{
+				continue;
+			}
+			if (mov[v] >= 0)
+			{
+				snprintf ((char *) line, MAXLINELEN, "%s %lli, %lli\n", vops[v]->op == STPOPI ? "movi" : "movd", mov[v], vops[v]->arg[0]);
+				strcat ((char *) text, (const char *) line);
+				continue;
+			}
+			if (write_inline_op (text, &body.ops[vind[v]], map_i, map_d) != 0)
+			{
+				printf ("error: inline: label too long!\n");
+				goto inline_end;
+			}
+		}
+		else
+		{
+			if (del[v] == 1)
+			{
+				if (add_live_edit (vops[v]->row, vops[v]->pos, vops[v]->len, (U1 *) "") != 0)
+				{
+					goto inline_end;
+				}
+			}
+			if (mov[v] >= 0)
+			{
+				snprintf ((char *) line, MAXLINELEN, "%s %lli, %lli\n", vops[v]->op == STPOPI ? "movi" : "movd", mov[v], vops[v]->arg[0]);
+				if (add_live_edit (vops[v]->row, vops[v]->pos, vops[v]->len, line) != 0)
+				{
+					goto inline_end;
+				}
+			}
+		}
+	}
+
+	if (add_live_edit (ops[i].row, ops[i].pos, ops[i].len, text) != 0)
+	{
+		goto inline_end;
+	}
+
+	if (remove == 1)
+	{
+		set_code_lines (save_regs[s].first, save_regs[s].last, (U1 *) "");
+		for (l = f->load_first; l <= f->load_last; l++)
+		{
+			if (load_regs[l].save == s && load_regs[l].first <= load_regs[l].last)
+			{
+				set_code_lines (load_regs[l].first, load_regs[l].last, (U1 *) "");
+			}
+		}
+		save_regs[s].removed = 1;
+	}
+
+	inline_ind++;
+	ret = 0;
+
+inline_end:
+	free (bops);
+	free (vops);
+	free (vind);
+	free (del);
+	free (mov);
+	free (st_vop);
+	free (st_reg);
+	free (st_type);
+	free (st_valid);
+	free (text);
+	live_free (&body);
+	return (ret);
+}
+
+// after the compiling: inline the functions and set the register saves of the calls to the live registers
+S2 optimize_functions (U1 inline_calls)
+{
+	struct live_info info;
+	S8 f ALIGN, g ALIGN, i ALIGN;
+
+	if (inline_calls == 1)
+	{
+		for (f = 0; f <= live_func_ind; f++)
+		{
+			live_func[f].inlinable = check_inline (&live_func[f]);
+		}
+	}
+
+	for (f = 0; f <= live_func_ind; f++)
+	{
+		if (live_func[f].end == -1)
+		{
+			continue;
+		}
+
+		if (live_analyze (&live_func[f], &info) != 0)
+		{
+			return (1);
+		}
+
+		for (i = info.n - 1; i >= 0; i--)
+		{
+			if (info.ops[i].op != JSR)
+			{
+				continue;
+			}
+			g = get_inline_func (info.ops[i].name);
+			if (g == -1 || g == f)
+			{
+				continue;
+			}
+			if (inline_call (&live_func[f], &info, i, &live_func[g]) != 0)
+			{
+				live_free (&info);
+				return (1);
+			}
+		}
+
+		if (apply_live_edits () != 0)
+		{
+			live_free (&info);
+			return (1);
+		}
+
+		write_live_regs (&live_func[f]);
+		live_free (&info);
+	}
+
+	free (live_edit);
+	live_edit = NULL;
+	live_edit_max = 0;
+	return (0);
+}
@@ -0,0 +1,107 @@
+/*
+ * This file liveness.h is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _LIVENESS_H_
+#define _LIVENESS_H_
+// register liveness in a function: save only the registers live after a call
+// and inlining of small functions
+
+#define MAXSAVEREGS 16384				// register saves
+#define MAXLOADREGS 16384				// register loads
+#define MAXLIVEFUNCS 4096				// functions
+#define LIVE_BYTES ((MAXREG * 2) / 8)	// bit set: int registers, then double registers
+#define LIVE_GAP 4						// max not live registers between two saved registers in a range
+
+#define INLINE_MAXOPS 32				// functions with up to this number of opcodes are inlined
+
+extern struct opcode opcode[MAXOPCODES];
+
+// registers saved by "call" or "savereg": the code lines first to last
+struct save_regs
+{
+	S8 first ALIGN;
+	S8 last ALIGN;
+	U1 regi[MAXREG];
+	U1 regd[MAXREG];
+	U1 live[LIVE_BYTES];		// the saved registers live after a load
+	U1 loaded;
+	U1 removed;					// save and load removed by inlining
+};
+
+// registers loaded by "loadreg" or "*" call
+struct load_regs
+{
+	S8 first ALIGN;
+	S8 last ALIGN;
+	S8 save ALIGN;				// index of the save
+};
+
+// function: code lines start (label) to end (rts)
+struct live_func
+{
+	S8 start ALIGN;
+	S8 end ALIGN;
+	S8 save_first ALIGN;		// saves and loads in the function
+	S8 save_last ALIGN;
+	S8 load_first ALIGN;
+	S8 load_last ALIGN;
+	U1 name[MAXLINELEN];		// label of the function
+	U1 regfunc;
+	U1 inline_func;				// set by "inline"
+	U1 inlinable;
+	U1 rename;					// the registers can be renamed
+};
+
+// one opcode of the function code
+struct live_op
+{
+	S2 op;						// opcode number, -1 = label, -2 = unknown
+	S8 arg[4] ALIGN;			// register numbers, -1 = no register
+	S8 target ALIGN;			// jump target: index of live_op, -1 = none, -2 = unknown
+	S8 save ALIGN;				// index of the save, if in a save
+	S8 load ALIGN;				// index of the load, if in a load
+	S8 row ALIGN;				// code line
+	S4 pos;						// start and length of the opcode in the code line
+	S4 len;
+	U1 name[MAXLINELEN];		// label name or jump target name
+};
+
+// opcodes and live registers of a function
+struct live_info
+{
+	struct live_op *ops;
+	U1 *live_in;				// LIVE_BYTES for every opcode
+	S8 n ALIGN;
+};
+
+// replace an opcode in a code line
+struct live_edit
+{
+	S8 row ALIGN;
+	S4 pos;
+	S4 len;
+	U1 *text;
+};
+
+S2 set_save_regs (S8 first, S8 last, U1 *regi, U1 *regd);
+S2 set_load_regs (S8 first, S8 last);
+S2 set_live_func (U1 *name, S8 start, U1 regfunc, U1 inline_func);
+S2 set_live_func_end (S8 end);
+void shift_live_lines (S8 pos);
+S2 optimize_functions (U1 inline_calls);
+#endif
@@ -68,6 +68,12 @@ U1 inline_asm = 0;		// set to one, if inline assembly is used
 
 U1 optimize_if = 0;		// set to one to optimize if call
 
+U1 regfunc = 0;				// set to one in a function with register calling convention (regfunc)
+U1 regfunc_save_all = 0;	// set to one if the regfunc has calls or inline assembly: save all registers
+S8 regfunc_save_line ALIGN = 0;	// code line of the callee saved registers push
+
+U1 inline_calls = 1;		// set to zero by "-noinline": no function inlining
+
 
 // protos
 U1 checkdigit (U1 *str);
@@ -103,6 +109,9 @@ S4 get_regd (U1 *name);
 void init_registers (void);
 S4 get_free_regi (void);
 S4 get_free_regd (void);
+void init_reg_max (void);
+S4 get_regi_max (void);
+S4 get_regd_max (void);
 
 // var.c
 S2 checkdef (U1 *name);
@@ -114,6 +123,13 @@ S2 get_var_is_const (U1 *name);
 // parse-cont.c
 S2 parse_continous (void);
 
+// liveness.c
+S2 set_save_regs (S8 first, S8 last, U1 *regi, U1 *regd);
+S2 set_load_regs (S8 first, S8 last);
+S2 set_live_func (U1 *name, S8 start, U1 regfunc, U1 inline_func);
+S2 set_live_func_end (S8 end);
+S2 optimize_functions (U1 inline_calls);
+
 void init_ast (void)
 {
 	S4 i, j;
@@ -127,6 +143,308 @@ void init_ast (void)
 	}
 }
 
+// append a line to the code list
+S2 add_code_line (U1 *line)
+{
+	code_line++;
+	if (code_line >= line_len)
+	{
+		printf ("error: line %lli: code list full!\n", linenum);
+		return (1);
+	}
+
+	strcpy ((char *) code[code_line], (const char *) line);
+	return (0);
+}
+
+// write one code line with the stack opcode for the registers first to last:
+// a single register by op (stpushi...), a range by the range opcode (stpushir...)
+S2 write_stack_regs_range (U1 *op, S4 first, S4 last)
+{
+	U1 line[MAXLINELEN];
+
+	if (first == last)
+	{
+		snprintf ((char *) line, MAXLINELEN, "%s %i\n", op, first);
+	}
+	else
+	{
+		snprintf ((char *) line, MAXLINELEN, "%sr %i, %i\n", op, first, last);
+	}
+
+	return (add_code_line (line));
+}
+
+// push or pop the registers set in save[]: contiguous registers by one range opcode.
+// pop does the ranges in reverse order of push
+S2 write_stack_regs (U1 *op, U1 *save, U1 pop)
+{
+	S4 first[MAXREG], last[MAXREG];
+	S4 ranges = 0;
+	S4 e;
+
+	for (e = 0; e < MAXREG; e++)
+	{
+		if (save[e] == 1)
+		{
+			if (ranges > 0 && last[ranges - 1] == e - 1)
+			{
+				last[ranges - 1] = e;
+			}
+			else
+			{
+				first[ranges] = e;
+				last[ranges] = e;
+				ranges++;
+			}
+		}
+	}
+
+	for (e = 0; e < ranges; e++)
+	{
+		if (pop == 0)
+		{
+			if (write_stack_regs_range (op, first[e], last[e]) != 0)
+			{
+				return (1);
+			}
+		}
+		else
+		{
+			if (write_stack_regs_range (op, first[ranges - 1 - e], last[ranges - 1 - e]) != 0)
+			{
+				return (1);
+			}
+		}
+	}
+	return (0);
+}
+
+// save the bound registers on the stack
+S2 write_save_regs (void)
+{
+	S8 first ALIGN;
+	S4 e;
+
+	for (e = 0; e < MAXREG; e++)
+	{
+		save_regi[e] = strcmp ((const char *) regi[e], "") != 0 ? 1 : 0;
+		save_regd[e] = strcmp ((const char *) regd[e], "") != 0 ? 1 : 0;
+	}
+
+	first = code_line + 1;
+	if (write_stack_regs ((U1 *) "stpushi", save_regi, 0) != 0)
+	{
+		return (1);
+	}
+	if (write_stack_regs ((U1 *) "stpushd", save_regd, 0) != 0)
+	{
+		return (1);
+	}
+
+	// on funcend only the registers live after the load are kept
+	set_save_regs (first, code_line, save_regi, save_regd);
+	return (0);
+}
+
+// load the registers saved by write_save_regs
+S2 write_load_regs (void)
+{
+	S8 first ALIGN;
+
+	first = code_line + 1;
+	if (write_stack_regs ((U1 *) "stpopd", save_regd, 1) != 0)
+	{
+		return (1);
+	}
+	if (write_stack_regs ((U1 *) "stpopi", save_regi, 1) != 0)
+	{
+		return (1);
+	}
+
+	set_load_regs (first, code_line);
+	return (0);
+}
+
+// register calling convention: move the int64 or double variable into the next argument register
+S2 write_regcall_arg (U1 *name, S4 *args_i, S4 *args_d)
+{
+	U1 line[MAXLINELEN];
+	S4 reg;
+
+	if (checkdef (name) != 0)
+	{
+		return (1);
+	}
+
+	if (getvartype (name) == INTEGER && getvartype_real (name) == QUADWORD)
+	{
+		if (*args_i >= REGCALL_ARGS)
+		{
+			printf ("error: line %lli: more than %i int64 register arguments!\n", linenum, REGCALL_ARGS);
+			return (1);
+		}
+
+		reg = get_regi (name);
+		if (reg == -1)
+		{
+			reg = get_free_regi ();
+			set_regi (reg, name);
+
+			snprintf ((char *) line, MAXLINELEN, "loada %s, 0, %i\n", name, reg);
+			if (add_code_line (line) != 0)
+			{
+				return (1);
+			}
+		}
+
+		snprintf ((char *) line, MAXLINELEN, "movi %i, %i\n", reg, REGCALL_REG + *args_i);
+		(*args_i)++;
+		return (add_code_line (line));
+	}
+
+	if (getvartype (name) == DOUBLE)
+	{
+		if (*args_d >= REGCALL_ARGS)
+		{
+			printf ("error: line %lli: more than %i double register arguments!\n", linenum, REGCALL_ARGS);
+			return (1);
+		}
+
+		reg = get_regd (name);
+		if (reg == -1)
+		{
+			reg = get_free_regd ();
+			set_regd (reg, name);
+
+			snprintf ((char *) line, MAXLINELEN, "loadd %s, 0, %i\n", name, reg);
+			if (add_code_line (line) != 0)
+			{
+				return (1);
+			}
+		}
+
+		snprintf ((char *) line, MAXLINELEN, "movd %i, %i\n", reg, REGCALL_REG + *args_d);
+		(*args_d)++;
+		return (add_code_line (line));
+	}
+
+	printf ("error: line %lli: register argument '%s' is not int64 or double!\n", linenum, name);
+	return (1);
+}
+
+// register calling convention: set the int64 or double variable to the next argument register
+S2 write_regcall_get (U1 *name, S4 *args_i, S4 *args_d)
+{
+	U1 line[MAXLINELEN];
+	S4 reg, reg_addr;
+
+	if (checkdef (name) != 0)
+	{
+		return (1);
+	}
+
+	if (getvartype (name) == INTEGER && getvartype_real (name) == QUADWORD)
+	{
+		if (*args_i >= REGCALL_ARGS)
+		{
+			printf ("error: line %lli: more than %i int64 register arguments!\n", linenum, REGCALL_ARGS);
+			return (1);
+		}
+
+		reg = get_regi (name);
+		if (reg == -1)
+		{
+			reg = get_free_regi ();
+			set_regi (reg, name);
+		}
+		reg_addr = get_free_regi ();
+
+		snprintf ((char *) line, MAXLINELEN, "movi %i, %i\nload %s, 0, %i\npullqw %i, %i, 0\n", REGCALL_REG + *args_i, reg, name, reg_addr, reg, reg_addr);
+		(*args_i)++;
+		return (add_code_line (line));
+	}
+
+	if (getvartype (name) == DOUBLE)
+	{
+		if (*args_d >= REGCALL_ARGS)
+		{
+			printf ("error: line %lli: more than %i double register arguments!\n", linenum, REGCALL_ARGS);
+			return (1);
+		}
+
+		reg = get_regd (name);
+		if (reg == -1)
+		{
+			reg = get_free_regd ();
+			set_regd (reg, name);
+		}
+		reg_addr = get_free_regi ();
+
+		snprintf ((char *) line, MAXLINELEN, "movd %i, %i\nload %s, 0, %i\npulld %i, %i, 0\n", REGCALL_REG + *args_d, reg, name, reg_addr, reg, reg_addr);
+		(*args_d)++;
+		return (add_code_line (line));
+	}
+
+	printf ("error: line %lli: register argument '%s' is not int64 or double!\n", linenum, name);
+	return (1);
+}
+
+// end of a regfunc: set the push of the callee saved registers at the function start and pop them
+S2 write_regfunc_end (void)
+{
+	U1 line[MAXLINELEN];
+	S4 first_d = 1;
+	S4 max_i, max_d;
+
+	max_i = get_regi_max ();
+	max_d = get_regd_max ();
+	if (regfunc_save_all == 1)
+	{
+		// registers used by the called functions or inline assembly are not known
+		max_i = REGCALL_REG - 1;
+		max_d = REGCALL_REG - 1;
+		first_d = 0;
+	}
+	if (max_i >= REGCALL_REG)
+	{
+		max_i = REGCALL_REG - 1;
+	}
+	if (max_d >= REGCALL_REG)
+	{
+		max_d = REGCALL_REG - 1;
+	}
+
+	strcpy ((char *) code[regfunc_save_line], "");
+	if (max_i >= 1)
+	{
+		snprintf ((char *) line, MAXLINELEN, "stpushir 1, %i\n", max_i);
+		strcat ((char *) code[regfunc_save_line], (const char *) line);
+	}
+	if (max_d >= first_d)
+	{
+		snprintf ((char *) line, MAXLINELEN, "stpushdr %i, %i\n", first_d, max_d);
+		strcat ((char *) code[regfunc_save_line], (const char *) line);
+
+		snprintf ((char *) line, MAXLINELEN, "stpopdr %i, %i\n", first_d, max_d);
+		if (add_code_line (line) != 0)
+		{
+			return (1);
+		}
+	}
+	if (max_i >= 1)
+	{
+		snprintf ((char *) line, MAXLINELEN, "stpopir 1, %i\n", max_i);
+		if (add_code_line (line) != 0)
+		{
+			return (1);
+		}
+	}
+
+	regfunc = 0;
+	return (0);
+}
+
 S2 check_brackets_match (U1 *line)
 {
 	S4 slen;
@@ -434,6 +752,72 @@ U1 *get_variable_value (S8 maxind, U1 *name)
 	return (NULL);		// variable name not found, return empty string
 }
 
+U1 *get_const_variable (U1 type, S8 value_int, F8 value_double)
+{
+	// constant variable with the value, for the folded constants of { } expressions:
+	// a const variable of the program or a new one
+	S8 i ALIGN;
+	U1 value_str[MAXLINELEN];
+
+	if (type == DOUBLEFLOAT)
+	{
+		snprintf ((char *) value_str, MAXLINELEN, "%.17g", value_double);
+		if (strchr ((const char *) value_str, '.') == NULL && strchr ((const char *) value_str, 'e') == NULL)
+		{
+			strcat ((char *) value_str, ".0");
+		}
+	}
+	else
+	{
+		snprintf ((char *) value_str, MAXLINELEN, "%lli", value_int);
+	}
+
+	for (i = 0; i <= data_ind; i++)
+	{
+		if (data_info[i].constant == 1 && data_info[i].size == 1 && data_info[i].type == type && checkdigit (data_info[i].value_str) == TRUE)
+		{
+			if ((type == QUADWORD && get_temp_int () == value_int) || (type == DOUBLEFLOAT && get_temp_double () == value_double))
+			{
+				return (data_info[i].name);
+			}
+		}
+	}
+
+	if (data_line == 0 || data_ind + 1 >= MAXDATAINFO || data_line + 2 >= line_len)
+	{
+		printf ("error: line %lli: data list full!\n", linenum);
+		return (NULL);
+	}
+
+	data_ind++;
+	snprintf ((char *) data_info[data_ind].name, MAXLINELEN, "const_fold_%lli", data_ind);
+	data_info[data_ind].type = type;
+	if (type == DOUBLEFLOAT)
+	{
+		data_info[data_ind].type_size = sizeof (F8);
+		strcpy ((char *) data_info[data_ind].type_str, "F");
+	}
+	else
+	{
+		data_info[data_ind].type_size = sizeof (S8);
+		strcpy ((char *) data_info[data_ind].type_str, "Q");
+	}
+	data_info[data_ind].constant = 1;
+	data_info[data_ind].size = 1;
+	strcpy ((char *) data_info[data_ind].value_str, (const char *) value_str);
+
+	// use offset from last data end
+	data_info[data_ind].offset = data_info[data_ind - 1].end;
+	data_info[data_ind].end = data_info[data_ind].offset + data_info[data_ind].type_size;
+
+	data_line++;
+	snprintf ((char *) data[data_line], MAXLINELEN, "%s, 1, %s\n", data_info[data_ind].type_str, data_info[data_ind].name);
+	data_line++;
+	snprintf ((char *) data[data_line], MAXLINELEN, "@, %lliQ, %s\n", data_info[data_ind].offset, value_str);
+
+	return (data_info[data_ind].name);
+}
+
 S2 check_for_brackets (U1 *line)
 {
 	S2 i, len;
@@ -488,6 +872,8 @@ S2 parse_line (U1 *line)
 	U1 for_label[MAXLINELEN];
 
 	S8 switch_pos ALIGN;
+	S8 case_line ALIGN;
+	U1 *case_value;
 
 	U1 set_loadreg = 0;
 
@@ -503,6 +889,9 @@ S2 parse_line (U1 *line)
 	// multi line array assign
 	U1 array_multi = 0;
 
+	// array index "[[ i ]]": element index, scaled by the element size in push/pull
+	U1 array_scaled = 0;
+
 	ret = get_ast (line, &parse_cont);
 	if (ret == 1)
 	{
@@ -1047,9 +1436,11 @@ S2 parse_line (U1 *line)
 									// check if variable to array variable assign
 									if (last_arg >= 5)
 									{
-									if (strcmp ((const char *) ast[level].expr[j][last_arg - 1], "]") == 0 && strcmp ((const char *) ast[level].expr[j][last_arg - 3], "[") == 0)
+									if ((strcmp ((const char *) ast[level].expr[j][last_arg - 1], "]") == 0 && strcmp ((const char *) ast[level].expr[j][last_arg - 3], "[") == 0) || (strcmp ((const char *) ast[level].expr[j][last_arg - 1], "]]") == 0 && strcmp ((const char *) ast[level].expr[j][last_arg - 3], "[[") == 0))
 									{
 										// assign to array variable
+										// "[ offset ]" byte offset, "[[ index ]]" element index
+										array_scaled = (strcmp ((const char *) ast[level].expr[j][last_arg - 3], "[[") == 0);
 
 										if (checkdef (ast[level].expr[j][last_arg - 4]) != 0)
 										{
@@ -1133,7 +1524,7 @@ S2 parse_line (U1 *line)
 											strcat ((char *) code_temp, (const char *) ast[level].expr[j][last_arg - 4]);
 											strcat ((char *) code_temp, ", 0, ");
 
-											reg3 = get_free_regd ();
+											reg3 = get_free_regi ();
 
 											sprintf ((char *) str, "%i", reg3);
 											strcat ((char *) code_temp, (const char *) str);
@@ -1152,7 +1543,14 @@ S2 parse_line (U1 *line)
 
 											// pulld
 
-											strcpy ((char *) code_temp, "pulld ");
+											if (array_scaled)
+											{
+												strcpy ((char *) code_temp, "pullds ");
+											}
+											else
+											{
+												strcpy ((char *) code_temp, "pulld ");
+											}
 
 											sprintf ((char *) str, "%i", reg);
 											strcat ((char *) code_temp, (const char *) str);
@@ -1260,17 +1658,38 @@ S2 parse_line (U1 *line)
 
 											if (getvartype_real (ast[level].expr[j][last_arg - 4]) == WORD)
 											{
-												strcpy ((char *) code_temp, "pullw ");
+												if (array_scaled)
+												{
+													strcpy ((char *) code_temp, "pullws ");
+												}
+												else
+												{
+													strcpy ((char *) code_temp, "pullw ");
+												}
 											}
 
 											if (getvartype_real (ast[level].expr[j][last_arg - 4]) == DOUBLEWORD)
 											{
-												strcpy ((char *) code_temp, "pulldw ");
+												if (array_scaled)
+												{
+													strcpy ((char *) code_temp, "pulldws ");
+												}
+												else
+												{
+													strcpy ((char *) code_temp, "pulldw ");
+												}
 											}
 
 											if (getvartype_real (ast[level].expr[j][last_arg - 4]) == QUADWORD)
 											{
-												strcpy ((char *) code_temp, "pullqw ");
+												if (array_scaled)
+												{
+													strcpy ((char *) code_temp, "pullqws ");
+												}
+												else
+												{
+													strcpy ((char *) code_temp, "pullqw ");
+												}
 											}
 
 											sprintf ((char *) str, "%i", reg);
@@ -1298,9 +1717,11 @@ S2 parse_line (U1 *line)
 									// check if array variable to variable assign
 									if (last_arg >= 5)
 									{
-									if (strcmp ((const char *) ast[level].expr[j][last_arg - 2], "]") == 0 && strcmp ((const char *) ast[level].expr[j][last_arg - 4], "[") == 0)
+									if ((strcmp ((const char *) ast[level].expr[j][last_arg - 2], "]") == 0 && strcmp ((const char *) ast[level].expr[j][last_arg - 4], "[") == 0) || (strcmp ((const char *) ast[level].expr[j][last_arg - 2], "]]") == 0 && strcmp ((const char *) ast[level].expr[j][last_arg - 4], "[[") == 0))
 									{
-										// assign to array variable
+										// assign array variable to variable
+										// "[ offset ]" byte offset, "[[ index ]]" element index
+										array_scaled = (strcmp ((const char *) ast[level].expr[j][last_arg - 4], "[[") == 0);
 
 										if (checkdef (ast[level].expr[j][last_arg - 5]) != 0)
 										{
@@ -1384,7 +1805,7 @@ S2 parse_line (U1 *line)
 											strcat ((char *) code_temp, (const char *) ast[level].expr[j][last_arg - 5]);
 											strcat ((char *) code_temp, ", 0, ");
 
-											reg3 = get_free_regd ();
+											reg3 = get_free_regi ();
 											// set_regd (reg, (U1 *) ast[level].expr[j][last_arg - 1]);
 
 											sprintf ((char *) str, "%i", reg3);
@@ -1402,9 +1823,16 @@ S2 parse_line (U1 *line)
 
 											strcpy ((char *) code[code_line], (const char *) code_temp);
 
-											// pulld
+											// pushd
 
-											strcpy ((char *) code_temp, "pushd ");
+											if (array_scaled)
+											{
+												strcpy ((char *) code_temp, "pushds ");
+											}
+											else
+											{
+												strcpy ((char *) code_temp, "pushd ");
+											}
 
 											sprintf ((char *) str, "%i", reg3);
 											strcat ((char *) code_temp, (const char *) str);
@@ -1512,17 +1940,38 @@ S2 parse_line (U1 *line)
 
 											if (getvartype_real (ast[level].expr[j][last_arg - 5]) == WORD)
 											{
-												strcpy ((char *) code_temp, "pushw ");
+												if (array_scaled)
+												{
+													strcpy ((char *) code_temp, "pushws ");
+												}
+												else
+												{
+													strcpy ((char *) code_temp, "pushw ");
+												}
 											}
 
 											if (getvartype_real (ast[level].expr[j][last_arg - 5]) == DOUBLEWORD)
 											{
-												strcpy ((char *) code_temp, "pushdw ");
+												if (array_scaled)
+												{
+													strcpy ((char *) code_temp, "pushdws ");
+												}
+												else
+												{
+													strcpy ((char *) code_temp, "pushdw ");
+												}
 											}
 
 											if (getvartype_real (ast[level].expr[j][last_arg - 5]) == QUADWORD)
 											{
-												strcpy ((char *) code_temp, "pushqw ");
+												if (array_scaled)
+												{
+													strcpy ((char *) code_temp, "pushqws ");
+												}
+												else
+												{
+													strcpy ((char *) code_temp, "pushqw ");
+												}
 											}
 
 											sprintf ((char *) str, "%i", reg3);
@@ -2053,7 +2502,7 @@ S2 parse_line (U1 *line)
 
 									continue;
 								}
-								if (strcmp ((const char *) ast[level].expr[j][last_arg], "func") == 0)
+								if (strcmp ((const char *) ast[level].expr[j][last_arg], "func") == 0 || strcmp ((const char *) ast[level].expr[j][last_arg], "regfunc") == 0 || strcmp ((const char *) ast[level].expr[j][last_arg], "inline") == 0)
 								{
 									if (last_arg < 1)
 									{
@@ -2083,6 +2532,8 @@ S2 parse_line (U1 *line)
 									strcpy ((char *) code[code_line], (const char *) code_temp);
 									strcat ((char *) code[code_line], "\n");
 
+									set_live_func (code_temp, code_line, strcmp ((const char *) ast[level].expr[j][last_arg], "regfunc") == 0 ? 1 : 0, strcmp ((const char *) ast[level].expr[j][last_arg], "inline") == 0 ? 1 : 0);
+
 									code_line++;
 									if (code_line >= line_len)
 									{
@@ -2095,6 +2546,29 @@ S2 parse_line (U1 *line)
 									set_regi (0, (U1 *) "zero");
 									strcpy ((char *) code_temp, "");
 
+									if (strcmp ((const char *) ast[level].expr[j][last_arg], "regfunc") == 0)
+									{
+										// register calling convention: the push of the callee saved registers is set on funcend
+										if (strcmp ((const char *) ast[level].expr[j][last_arg - 1], "main") == 0)
+										{
+											printf ("error: line %lli: main can't be a regfunc!\n", linenum);
+											return (1);
+										}
+
+										code_line++;
+										if (code_line >= line_len)
+										{
+											printf ("error: line %lli: code list full!\n", linenum);
+											return (1);
+										}
+
+										strcpy ((char *) code[code_line], "");
+										regfunc_save_line = code_line;
+										regfunc = 1;
+										regfunc_save_all = 0;
+										init_reg_max ();
+									}
+
 									// add name to labels list
 									if (label_ind < MAXLABELS - 1)
 									{
@@ -2116,6 +2590,14 @@ S2 parse_line (U1 *line)
 								{
 									// end of a function
 
+									if (regfunc == 1)
+									{
+										if (write_regfunc_end () != 0)
+										{
+											return (1);
+										}
+									}
+
 									code_line++;
 									if (code_line >= line_len)
 									{
@@ -2125,6 +2607,8 @@ S2 parse_line (U1 *line)
 
 									strcpy ((char *) code[code_line], (const char *) "rts");
 									strcat ((char *) code[code_line], "\n");
+
+									set_live_func_end (code_line);
 									continue;
 								}
 
@@ -2457,102 +2941,20 @@ S2 parse_line (U1 *line)
 
 								if (strcmp ((const char *) ast[level].expr[j][last_arg], "savereg") == 0)
 								{
-									// save integer registers
-									for (e = 0; e < MAXREG; e++)
-									{
-										if (strcmp ((const char *) regi[e], "") != 0)
-										{
-											strcpy ((char *) code_temp, "stpushi ");
-											sprintf ((char *) str, "%i", e);
-											strcat ((char *) code_temp, (const char*) str);
-											strcat ((char *) code_temp, "\n");
-
-											code_line++;
-											if (code_line >= line_len)
-											{
-												printf ("error: line %lli: code list full!\n", linenum);
-												return (1);
-											}
-
-											strcpy ((char *) code[code_line], (const char *) code_temp);
-											save_regi[e] = 1;
-										}
-										else
-										{
-											save_regi[e] = 0;
-										}
-									}
-
-									// save double registers
-									for (e = 0; e < MAXREG; e++)
+									// save the bound registers
+									if (write_save_regs () != 0)
 									{
-										if (strcmp ((const char *) regd[e], "") != 0)
-										{
-											strcpy ((char *) code_temp, "stpushd ");
-											sprintf ((char *) str, "%i", e);
-											strcat ((char *) code_temp, (const char*) str);
-											strcat ((char *) code_temp, "\n");
-
-											code_line++;
-											if (code_line >= line_len)
-											{
-												printf ("error: line %lli: code list full!\n", linenum);
-												return (1);
-											}
-
-											strcpy ((char *) code[code_line], (const char *) code_temp);
-											save_regd[e] = 1;
-										}
-										else
-										{
-											save_regd[e] = 0;
-										}
+										return (1);
 									}
 									continue;
 								}
 
 								if (strcmp ((const char *) ast[level].expr[j][last_arg], "loadreg") == 0)
 								{
-									// load double registers
-									for (e = MAXREG - 1; e >= 0; e--)
-									{
-										if (save_regd[e] == 1)
-										{
-											strcpy ((char *) code_temp, "stpopd ");
-											sprintf ((char *) str, "%i", e);
-											strcat ((char *) code_temp, (const char*) str);
-											strcat ((char *) code_temp, "\n");
-
-											code_line++;
-											if (code_line >= line_len)
-											{
-												printf ("error: line %lli: code list full!\n", linenum);
-												return (1);
-											}
-
-											strcpy ((char *) code[code_line], (const char *) code_temp);
-										}
-									}
-
-									// load integer registers
-									for (e = MAXREG - 1; e >= 0; e--)
+									// load the saved registers
+									if (write_load_regs () != 0)
 									{
-										if (save_regi[e] == 1)
-										{
-											strcpy ((char *) code_temp, "stpopi ");
-											sprintf ((char *) str, "%i", e);
-											strcat ((char *) code_temp, (const char*) str);
-											strcat ((char *) code_temp, "\n");
-
-											code_line++;
-											if (code_line >= line_len)
-											{
-												printf ("error: line %lli: code list full!\n", linenum);
-												return (1);
-											}
-
-											strcpy ((char *) code[code_line], (const char *) code_temp);
-										}
+										return (1);
 									}
 
 									init_registers ();
@@ -2977,6 +3379,14 @@ S2 parse_line (U1 *line)
 										return (FALSE);
 									}
 
+									// reserve a register for the jump table index
+									reg = get_free_regi ();
+									if (reg != -1)
+									{
+										set_regi (reg, (U1 *) "switch");
+									}
+									set_switch_start (switch_pos, code_line + 1, reg);
+
 									continue;
 								}
 
@@ -2984,6 +3394,14 @@ S2 parse_line (U1 *line)
 								{
 									switch_pos = get_act_switch ();
 
+									if (switch_pos != -1)
+									{
+										if (write_switch_table (switch_pos) != 0)
+										{
+											return (1);
+										}
+									}
+
 									set_switch_finished (switch_pos);
 
 									continue;
@@ -3022,6 +3440,15 @@ S2 parse_line (U1 *line)
 									{
 										return (1);
 									}
+
+									// the case compare starts at the next code line
+									case_line = code_line + 1;
+									switch_pos = get_act_switch ();
+									if (switch_pos != -1)
+									{
+										set_switch_case_regs (switch_pos);
+									}
+
 									if (getvartype (ast[level].expr[j][last_arg - 1]) == INTEGER)
 									{
 										if (getvartype_real (ast[level].expr[j][last_arg - 1]) == QUADWORD)
@@ -3075,13 +3502,32 @@ S2 parse_line (U1 *line)
 												strcat ((char *) code[code_line], (const char *) ast[level].expr[j][last_arg - 2]);
 												strcat ((char *) code[code_line], ", 0, ");
 												sprintf ((char *) str, "%i", reg2);
-												strcpy ((char *) code[code_line], (const char *) str);
+												strcat ((char *) code[code_line], (const char *) str);
 												strcat ((char *) code[code_line], "\n");
 											}
+
+											if (switch_pos != -1)
+											{
+												// jump table: the case must be an int64 constant
+												case_value = get_variable_value (data_ind + 1, ast[level].expr[j][last_arg - 1]);
+												if (get_var_is_const (ast[level].expr[j][last_arg - 1]) == 1 && getvartype_real (ast[level].expr[j][last_arg - 2]) == QUADWORD && case_value != NULL && checkdigit (case_value) == 1)
+												{
+													set_switch_case (switch_pos, ast[level].expr[j][last_arg - 2], reg2, ast[level].expr[j][last_arg - 1], get_temp_int (), case_line);
+												}
+												else
+												{
+													set_switch_no_table (switch_pos);
+												}
+											}
 										}
 										else
 										{
 											// variable is integer, but not qint!!
+											if (switch_pos != -1)
+											{
+												set_switch_no_table (switch_pos);
+											}
+
 											// first variable
 											reg3 = get_regi (ast[level].expr[j][last_arg - 1]);
 											if (reg3 == -1)
@@ -3299,6 +3745,11 @@ S2 parse_line (U1 *line)
 									}
 									else
 									{
+										if (switch_pos != -1)
+										{
+											set_switch_no_table (switch_pos);
+										}
+
 										if (getvartype_real (ast[level].expr[j][last_arg - 1]) == DOUBLEFLOAT)
 										{
 											// variable type double
@@ -3717,64 +4168,110 @@ S2 parse_line (U1 *line)
 									continue;
 								}
 
-								// call =========================================================================
-								if (strcmp ((const char *) ast[level].expr[j][last_arg], "call") == 0 || strcmp ((const char *) ast[level].expr[j][last_arg], "!") == 0)
+								// register calling convention ==================================================
+								if (strcmp ((const char *) ast[level].expr[j][last_arg], "regcall") == 0)
 								{
-									// function call with arguments: "call" or "!" !!!
-
-									// first of all use save register code
+									// function call with arguments and return value in registers:
+									// (x y :func ret regcall) - the function is a "regfunc"
+									S4 label_arg = -1;
+									S4 args_i = 0, args_d = 0;
 
-									// save integer registers
-									for (e = 0; e < MAXREG; e++)
+									for (e = 0; e < last_arg; e++)
 									{
-										if (strcmp ((const char *) regi[e], "") != 0)
+										if (ast[level].expr[j][e][0] == ':')
 										{
-											strcpy ((char *) code_temp, "stpushi ");
-											sprintf ((char *) str, "%i", e);
-											strcat ((char *) code_temp, (const char*) str);
-											strcat ((char *) code_temp, "\n");
-
-											code_line++;
-											if (code_line >= line_len)
-											{
-												printf ("error: line %lli: code list full!\n", linenum);
-												return (1);
-											}
-
-											strcpy ((char *) code[code_line], (const char *) code_temp);
-											save_regi[e] = 1;
+											label_arg = e;
+											break;
 										}
-										else
+									}
+									if (label_arg == -1 || label_arg < last_arg - 2)
+									{
+										printf ("error: line %lli: regcall: no function label or more than one return variable!\n", linenum);
+										return (1);
+									}
+
+									for (e = 0; e < label_arg; e++)
+									{
+										if (write_regcall_arg (ast[level].expr[j][e], &args_i, &args_d) != 0)
 										{
-											save_regi[e] = 0;
+											return (1);
 										}
 									}
 
-									// save double registers
-									for (e = 0; e < MAXREG; e++)
+									snprintf ((char *) code_temp, MAXLINELEN, "jsr %s\n", ast[level].expr[j][label_arg]);
+									if (add_code_line (code_temp) != 0)
 									{
-										if (strcmp ((const char *) regd[e], "") != 0)
-										{
-											strcpy ((char *) code_temp, "stpushd ");
-											sprintf ((char *) str, "%i", e);
-											strcat ((char *) code_temp, (const char*) str);
-											strcat ((char *) code_temp, "\n");
+										return (1);
+									}
 
-											code_line++;
-											if (code_line >= line_len)
-											{
-												printf ("error: line %lli: code list full!\n", linenum);
-												return (1);
-											}
+									if (set_call_label (ast[level].expr[j][label_arg]) != 0)
+									{
+										printf ("error: line %lli: call label list full!\n", linenum);
+										return (1);
+									}
 
-											strcpy ((char *) code[code_line], (const char *) code_temp);
-											save_regd[e] = 1;
+									// the argument registers are changed by the function, the other registers are callee saved
+									for (e = REGCALL_REG; e < MAXREG; e++)
+									{
+										set_regi (e, (U1 *) "");
+										set_regd (e, (U1 *) "");
+									}
+
+									if (label_arg == last_arg - 2)
+									{
+										// get return value
+										args_i = 0;
+										args_d = 0;
+										if (write_regcall_get (ast[level].expr[j][last_arg - 1], &args_i, &args_d) != 0)
+										{
+											return (1);
 										}
-										else
+									}
+									continue;
+								}
+
+								if (strcmp ((const char *) ast[level].expr[j][last_arg], "regargs") == 0)
+								{
+									// set the variables to the argument registers: (x y regargs)
+									S4 args_i = 0, args_d = 0;
+
+									for (e = 0; e < last_arg; e++)
+									{
+										if (write_regcall_get (ast[level].expr[j][e], &args_i, &args_d) != 0)
 										{
-											save_regd[e] = 0;
+											return (1);
 										}
 									}
+									continue;
+								}
+
+								if (strcmp ((const char *) ast[level].expr[j][last_arg], "regreturn") == 0 && last_arg == 1)
+								{
+									// set the return value register: (ret regreturn)
+									S4 args_i = 0, args_d = 0;
+
+									if (write_regcall_arg (ast[level].expr[j][0], &args_i, &args_d) != 0)
+									{
+										return (1);
+									}
+									continue;
+								}
+
+								// call =========================================================================
+								if (strcmp ((const char *) ast[level].expr[j][last_arg], "call") == 0 || strcmp ((const char *) ast[level].expr[j][last_arg], "!") == 0)
+								{
+									// function call with arguments: "call" or "!" !!!
+
+									// the called function can change all registers
+									regfunc_save_all = 1;
+
+									// first of all use save register code
+
+									// save the bound registers
+									if (write_save_regs () != 0)
+									{
+										return (1);
+									}
 
 									// now check for function arguments
 									// and push them
@@ -4109,46 +4606,10 @@ S2 parse_line (U1 *line)
 
 									if (set_loadreg == 1)
 									{
-										// load double registers
-										for (e = MAXREG - 1; e >= 0; e--)
+										// load the saved registers
+										if (write_load_regs () != 0)
 										{
-											if (save_regd[e] == 1)
-											{
-												strcpy ((char *) code_temp, "stpopd ");
-												sprintf ((char *) str, "%i", e);
-												strcat ((char *) code_temp, (const char*) str);
-												strcat ((char *) code_temp, "\n");
-
-												code_line++;
-												if (code_line >= line_len)
-												{
-													printf ("error: line %lli: code list full!\n", linenum);
-													return (1);
-												}
-
-												strcpy ((char *) code[code_line], (const char *) code_temp);
-											}
-										}
-
-										// load integer registers
-										for (e = MAXREG - 1; e >= 0; e--)
-										{
-											if (save_regi[e] == 1)
-											{
-												strcpy ((char *) code_temp, "stpopi ");
-												sprintf ((char *) str, "%i", e);
-												strcat ((char *) code_temp, (const char*) str);
-												strcat ((char *) code_temp, "\n");
-
-												code_line++;
-												if (code_line >= line_len)
-												{
-													printf ("error: line %lli: code list full!\n", linenum);
-													return (1);
-												}
-
-												strcpy ((char *) code[code_line], (const char *) code_temp);
-											}
+											return (1);
 										}
 
 										set_loadreg = 0;
@@ -4177,6 +4638,11 @@ S2 parse_line (U1 *line)
 									case JMP:
 									case JMPI:
 									case JSR:
+										if (translate[t].assemb_op == JSR)
+										{
+											regfunc_save_all = 1;
+										}
+
 										// set call_label if not set already!
 										if (set_call_label (ast[level].expr[j][last_arg - 1]) != 0)
 										{
@@ -4834,6 +5300,7 @@ S2 parse (U1 *name)
 				if (pos != -1)
 				{
 					inline_asm = 1;
+					regfunc_save_all = 1;
 					continue;
 				}
 
@@ -4980,7 +5447,7 @@ void cleanup (void)
 
 void show_info (void)
 {
-	printf ("l1com <file> [-a] [-lines] [max linenumber]\n");
+	printf ("l1com <file> [-a] [-lines] [max linenumber] [-noinline]\n");
 	printf ("\nCompiler for bra(ets, a programming language with brackets ;-)\n");
 	printf ("%s", VM_VERSION_STR);
 	printf ("%s\n", COPYRIGHT_STR);
@@ -5032,6 +5499,13 @@ int main (int ac, char *av[])
 					}
 				}
 			}
+			if (arglen == 9)
+			{
+				if (strcmp (av[i], "-noinline") == 0)
+				{
+					inline_calls = 0;
+				}
+			}
 			if (arglen == 6)
 			{
 				if (strcmp (av[i], "--help") == 0 || strcmp (av[1], "-?") == 0)
@@ -5111,6 +5585,15 @@ int main (int ac, char *av[])
 		exit (1);
 	}
 
+	// inline functions and set the register saves of calls to the live registers
+	if (optimize_functions (inline_calls) != 0)
+	{
+		printf ("\033[31mERRORS! can't optimize functions!\n");
+		printf ("[!] %s\033[0m\n\n", av[1]);
+		cleanup ();
+		exit (1);
+	}
+
 	if (write_asm ((U1 *) av[1]) == 1)
 	{
 		printf ("\033[31mERRORS! can't write assembly file!\n");
@@ -44,6 +44,16 @@ S2 stack_ob_int = -1;
 S2 stack_reg[MAX_STACK];
 int stack_reg_int = -1;
 
+// constant operands on the register stack are not loaded, they are folded at compile time:
+// QUADWORD or DOUBLEFLOAT constant, 0 = register
+U1 stack_reg_const[MAX_STACK];
+S8 stack_reg_value_int[MAX_STACK];
+F8 stack_reg_value_double[MAX_STACK];
+
+// code line after the last { } expression: the expression registers are kept for the next one,
+// if no other code is between them
+S8 expr_code_line ALIGN = -1;
+
 //int stack
 int stack[MAXLINELEN];
 int top_int = -1;
@@ -63,6 +73,16 @@ S2 checkdef (U1 *name);
 S2 getvartype (U1 *name);
 S2 getvartype_real (U1 *name);
 S8 get_variable_is_array (U1 *name);
+S2 get_var_const_value (U1 *name, S8 *value_int, F8 *value_double);
+
+// main.c
+U1 checkdigit (U1 *str);
+S8 get_temp_int (void);
+F8 get_temp_double (void);
+U1 *get_const_variable (U1 type, S8 value_int, F8 value_double);
+
+extern U1 regi[MAXREG][MAXLINELEN];
+extern U1 regd[MAXREG][MAXLINELEN];
 
 // assembly text output
 extern U1 **data;
@@ -271,6 +291,7 @@ S2 push_reg_stack (S2 reg)
 	if (stack_reg_int < MAX_STACK - 1)
 	{
 		stack_reg[++stack_reg_int] = reg;
+		stack_reg_const[stack_reg_int] = 0;
 		return (0);
 	}
 	else
@@ -293,6 +314,443 @@ S2 pop_reg_stack ()
 	}
 }
 
+S2 push_const_stack (U1 type, S8 value_int, F8 value_double)
+{
+	if (stack_reg_int < MAX_STACK - 1)
+	{
+		stack_reg[++stack_reg_int] = -1;
+		stack_reg_const[stack_reg_int] = type;
+		stack_reg_value_int[stack_reg_int] = value_int;
+		stack_reg_value_double[stack_reg_int] = value_double;
+		return (0);
+	}
+	else
+	{
+		printf ("error: line %lli: max stack reg overflow!\n", linenum);
+		return (1);
+	}
+}
+
+S2 get_const_value (U1 *name, S8 *value_int, F8 *value_double)
+{
+	// value of a constant operand: a number or a const int64/double variable
+	// returns QUADWORD, DOUBLEFLOAT or -1 if not constant
+
+	if (getvartype_real (name) != -1)
+	{
+		return (get_var_const_value (name, value_int, value_double));
+	}
+
+	if (checkdigit (name) == TRUE)
+	{
+		if (strchr ((const char *) name, '.') != NULL)
+		{
+			*value_double = get_temp_double ();
+			return (DOUBLEFLOAT);
+		}
+		*value_int = get_temp_int ();
+		return (QUADWORD);
+	}
+	return (-1);
+}
+
+S4 load_const (S2 ind)
+{
+	// load the constant on the register stack at ind into a register
+	U1 *name;
+
+	name = get_const_variable (stack_reg_const[ind], stack_reg_value_int[ind], stack_reg_value_double[ind]);
+	if (name == NULL)
+	{
+		return (-1);
+	}
+
+	if (stack_reg_const[ind] == DOUBLEFLOAT)
+	{
+		return (load_variable_double (name));
+	}
+	return (load_variable_int (name));
+}
+
+S2 fold_const (U1 op, U1 type, S2 left, S2 right)
+{
+	// calculate left op right at compile time and set it as constant at left
+	// returns 1 if it can't be folded: overflow, division by zero - the VM reports them
+	S8 left_int ALIGN = stack_reg_value_int[left];
+	S8 right_int ALIGN = stack_reg_value_int[right];
+	F8 left_double ALIGN = stack_reg_value_double[left];
+	F8 right_double ALIGN = stack_reg_value_double[right];
+	S8 res_int ALIGN = 0;
+	F8 res_double ALIGN = 0.0;
+
+	if (type == QUADWORD)
+	{
+		switch (op)
+		{
+			case '+':
+				if (__builtin_add_overflow (left_int, right_int, &res_int)) return (1);
+				break;
+
+			case '-':
+				if (__builtin_sub_overflow (left_int, right_int, &res_int)) return (1);
+				break;
+
+			case '*':
+				if (__builtin_mul_overflow (left_int, right_int, &res_int)) return (1);
+				break;
+
+			case '/':
+				if (right_int == 0 || (left_int == LLONG_MIN && right_int == -1)) return (1);
+				res_int = left_int / right_int;
+				break;
+
+			default:
+				return (1);
+		}
+	}
+	else
+	{
+		switch (op)
+		{
+			case '+': res_double = left_double + right_double; break;
+			case '-': res_double = left_double - right_double; break;
+			case '*': res_double = left_double * right_double; break;
+
+			case '/':
+				if (right_double == 0.0) return (1);
+				res_double = left_double / right_double;
+				break;
+
+			default:
+				return (1);
+		}
+		if (! isfinite (res_double))
+		{
+			return (1);
+		}
+	}
+
+	stack_reg_value_int[left] = res_int;
+	stack_reg_value_double[left] = res_double;
+	return (0);
+}
+
+S2 simplify_op (U1 op, U1 type, S2 left, S2 right, S4 *shift)
+{
+	// x + 0, x - 0, x * 1, x / 1: returns the stack index of x
+	// x * 0 (int): returns the index of the constant 0
+	// x * power of two (int): returns the index of x and the number of bits to shift left
+	// returns -1 if there is no simplification
+	S2 c, x;
+	S8 value_int ALIGN;
+	F8 value_double ALIGN;
+
+	*shift = 0;
+	if (stack_reg_const[right] == type && stack_reg_const[left] == 0)
+	{
+		c = right; x = left;
+	}
+	else
+	{
+		if (stack_reg_const[left] == type && stack_reg_const[right] == 0 && (op == '+' || op == '*'))
+		{
+			c = left; x = right;
+		}
+		else
+		{
+			return (-1);
+		}
+	}
+
+	value_int = stack_reg_value_int[c];
+	value_double = stack_reg_value_double[c];
+
+	if (type == QUADWORD)
+	{
+		switch (op)
+		{
+			case '+':
+			case '-':
+				if (value_int == 0) return (x);
+				break;
+
+			case '*':
+				if (value_int == 1) return (x);
+				if (value_int == 0) return (c);
+				if (value_int > 1 && (value_int & (value_int - 1)) == 0)
+				{
+					*shift = __builtin_ctzll (value_int);
+					return (x);
+				}
+				break;
+
+			case '/':
+				if (value_int == 1) return (x);
+				break;
+		}
+	}
+	else
+	{
+		// not x + 0.0: -0.0 + 0.0 is 0.0
+		switch (op)
+		{
+			case '-':
+				if (value_double == 0.0) return (x);
+				break;
+
+			case '*':
+			case '/':
+				if (value_double == 1.0) return (x);
+				break;
+		}
+	}
+	return (-1);
+}
+
+void clear_expr_regs (S4 reg, U1 reg_int)
+{
+	// the register got a new value: clear the expression registers which have it as operand
+	S4 i, reg1, reg2;
+	U1 *name;
+
+	for (i = 0; i < MAXREG; i++)
+	{
+		if (reg_int)
+		{
+			name = regi[i];
+		}
+		else
+		{
+			name = regd[i];
+		}
+		if (name[0] != '=')
+		{
+			continue;
+		}
+
+		reg1 = -1; reg2 = -1;
+		sscanf ((const char *) name, "=%*s %i %i", &reg1, &reg2);
+		if (reg1 == reg || reg2 == reg)
+		{
+			if (reg_int)
+			{
+				set_regi (i, (U1 *) "");
+			}
+			else
+			{
+				set_regd (i, (U1 *) "");
+			}
+			clear_expr_regs (i, reg_int);
+		}
+	}
+}
+
+void forget_expr_regs (void)
+{
+	// free all expression registers
+	S4 i;
+
+	for (i = 0; i < MAXREG; i++)
+	{
+		if (regi[i][0] == '=')
+		{
+			set_regi (i, (U1 *) "");
+		}
+		if (regd[i][0] == '=')
+		{
+			set_regd (i, (U1 *) "");
+		}
+	}
+}
+
+S4 get_expr_reg (U1 *expr, U1 reg_int, S2 *found)
+{
+	// register with the result of expr: the expression was calculated before (common subexpression),
+	// or a new register for it
+	S4 reg;
+
+	if (reg_int)
+	{
+		reg = get_regi (expr);
+	}
+	else
+	{
+		reg = get_regd (expr);
+	}
+	if (reg != -1)
+	{
+		*found = 1;
+		return (reg);
+	}
+
+	*found = 0;
+	if (reg_int)
+	{
+		reg = get_free_regi ();
+		if (reg != -1) set_regi (reg, expr);
+	}
+	else
+	{
+		reg = get_free_regd ();
+		if (reg != -1) set_regd (reg, expr);
+	}
+	if (reg == -1)
+	{
+		printf ("error: line %lli: no free register!\n", linenum);
+	}
+	return (reg);
+}
+
+S2 write_operator (U1 op, S2 reg_int)
+{
+	// the two operands on top of the register stack: left op right
+	// the result is pushed on the register stack
+	S2 left, right, simple, found;
+	S4 reg1, reg2, target_reg, shift;
+	U1 type;
+	U1 opname[MAXLINELEN];
+	U1 expr[MAXLINELEN];
+
+	if (stack_reg_int < 1)
+	{
+		printf ("error: line %lli: no reg on stack, stack empty!\n", linenum);
+		return (1);
+	}
+	right = stack_reg_int;
+	left = stack_reg_int - 1;
+
+	if (reg_int == 1)
+	{
+		type = QUADWORD;
+	}
+	else
+	{
+		type = DOUBLEFLOAT;
+	}
+
+	switch (op)
+	{
+		case '+':
+			if (reg_int == 1) strcpy ((char *) opname, (const char *) opcode[ADDI].op);
+			else strcpy ((char *) opname, (const char *) opcode[ADDD].op);
+			break;
+
+		case '-':
+			if (reg_int == 1) strcpy ((char *) opname, (const char *) opcode[SUBI].op);
+			else strcpy ((char *) opname, (const char *) opcode[SUBD].op);
+			break;
+
+		case '*':
+			if (reg_int == 1) strcpy ((char *) opname, (const char *) opcode[MULI].op);
+			else strcpy ((char *) opname, (const char *) opcode[MULD].op);
+			break;
+
+		case '/':
+			if (reg_int == 1) strcpy ((char *) opname, (const char *) opcode[DIVI].op);
+			else strcpy ((char *) opname, (const char *) opcode[DIVD].op);
+			break;
+
+		default:
+			printf ("error: line %lli: unknown operator '%c'!\n", linenum, op);
+			return (1);
+	}
+
+	// constant folding
+	if (stack_reg_const[left] == type && stack_reg_const[right] == type)
+	{
+		if (fold_const (op, type, left, right) == 0)
+		{
+			stack_reg_int--;
+			return (0);
+		}
+	}
+
+	simple = simplify_op (op, type, left, right, &shift);
+	if (simple != -1 && shift == 0)
+	{
+		// the result is one of the operands
+		stack_reg[left] = stack_reg[simple];
+		stack_reg_const[left] = stack_reg_const[simple];
+		stack_reg_value_int[left] = stack_reg_value_int[simple];
+		stack_reg_value_double[left] = stack_reg_value_double[simple];
+		stack_reg_int--;
+		return (0);
+	}
+
+	if (simple != -1)
+	{
+		// multiply by power of two: shift left
+		reg1 = stack_reg[simple];
+		snprintf ((char *) expr, MAXLINELEN, "=%s %i:%i", opcode[SHLI].op, reg1, shift);
+		target_reg = get_expr_reg (expr, 1, &found);
+		if (target_reg == -1)
+		{
+			return (1);
+		}
+		if (found == 0)
+		{
+			code_line++;
+			if (code_line >= line_len)
+			{
+				printf ("error: line %lli: code list full!\n", linenum);
+				return (1);
+			}
+			sprintf ((char *) code[code_line], "%s %i, %i, %i\n", opcode[SHLI].op, reg1, shift, target_reg);
+		}
+
+		stack_reg_int -= 2;
+		return (push_reg_stack (target_reg));
+	}
+
+	// load constant operands
+	if (stack_reg_const[left] != 0)
+	{
+		stack_reg[left] = load_const (left);
+		if (stack_reg[left] == -1)
+		{
+			return (1);
+		}
+	}
+	if (stack_reg_const[right] != 0)
+	{
+		stack_reg[right] = load_const (right);
+		if (stack_reg[right] == -1)
+		{
+			return (1);
+		}
+	}
+	reg1 = stack_reg[left];
+	reg2 = stack_reg[right];
+
+	// the register of the expression is named by the opcode and the operand registers
+	if ((op == '+' || op == '*') && reg2 < reg1)
+	{
+		snprintf ((char *) expr, MAXLINELEN, "=%s %i %i", opname, reg2, reg1);
+	}
+	else
+	{
+		snprintf ((char *) expr, MAXLINELEN, "=%s %i %i", opname, reg1, reg2);
+	}
+
+	target_reg = get_expr_reg (expr, reg_int, &found);
+	if (target_reg == -1)
+	{
+		return (1);
+	}
+	if (found == 0)
+	{
+		code_line++;
+		if (code_line >= line_len)
+		{
+			printf ("error: line %lli: code list full!\n", linenum);
+			return (1);
+		}
+		sprintf ((char *) code[code_line], "%s %i, %i, %i\n", opname, reg1, reg2, target_reg);
+	}
+
+	stack_reg_int -= 2;
+	return (push_reg_stack (target_reg));
+}
 
 //check whether the symbol is operator?
 S2 isOperator (char symbol)
@@ -553,7 +1011,10 @@ S2 parse_rpolish (U1 *postfix)
 	S2 reg_int = 0;
 
 	S2 target, target_reg;
-	S2 reg1, reg2;
+	S2 reg2;
+	S2 const_type;
+	S8 value_int ALIGN;
+	F8 value_double ALIGN;
 	U1 str[MAXLINELEN];
 	U1 code_temp[MAXLINELEN];
 
@@ -574,6 +1035,13 @@ S2 parse_rpolish (U1 *postfix)
 
 	i = math_exp_begin;
 
+	if (code_line != expr_code_line)
+	{
+		// other code since the last { } expression: its expression registers are not valid here
+		forget_expr_regs ();
+	}
+	stack_reg_int = -1;
+
 	while (parse == 1)
 	{
        ch = postfix[i];
@@ -600,6 +1068,13 @@ S2 parse_rpolish (U1 *postfix)
            get_var = 0;
            while (get_var == 0)
            {
+               if (ch == '}' || ch == '\0')
+               {
+                   // end of expression: "{a = x}"
+                   buf[pos] = '\0';
+                   get_var = 1;
+                   continue;
+               }
                if (ch == ' ')
                {
                    buf[pos] = '\0';
@@ -627,7 +1102,17 @@ S2 parse_rpolish (U1 *postfix)
 			   return (1);
 		   }
 
-		   if (getvartype_real (buf) != DOUBLE)
+		   const_type = get_const_value (buf, &value_int, &value_double);
+		   if (const_type != -1)
+		   {
+			   // constant: loaded if not folded
+			   if (push_const_stack (const_type, value_int, value_double) != 0)
+			   {
+				   return (1);
+			   }
+			   reg_int = (const_type == QUADWORD);
+		   }
+		   else if (getvartype_real (buf) != DOUBLE)
 		   {
 			   target = load_variable_int (buf);
 			   if (target == -1)
@@ -646,7 +1131,7 @@ S2 parse_rpolish (U1 *postfix)
 			   reg_int = 0;
 		   }
 
-		   if (push_reg_stack (target) != 0)
+		   if (const_type == -1 && push_reg_stack (target) != 0)
 		   {
 			   return (1);
 		   }
@@ -657,134 +1142,11 @@ S2 parse_rpolish (U1 *postfix)
        {
            if (isOperator (ch) == 1)
            {
-			   // printf ("got operator: %c\n", ch);
-               // got operator
-			   /*
-			   strptr = (U1 *) pop_stack ();
-			   if (strptr == NULL)
-			   {
-				   return (1);
-			   }
-			   strcpy ((char *) operand1, (const char *) strptr);
-			   */
-
-			   reg1 = pop_reg_stack ();
-			   if (reg1 == -1)
-			   {
-				   return (1);
-			   }
-
-			   /*
-			   strptr = (U1 *) pop_stack ();
-			   if (strptr == NULL)
-			   {
-				   return (1);
-			   }
-			   strcpy ((char *) operand2, (const char *) strptr);
-			   */
-
-			   reg2 = pop_reg_stack ();
-			   if (reg2 == -1)
+			   // got operator
+			   if (write_operator (ch, reg_int) != 0)
 			   {
 				   return (1);
 			   }
-
-			   // printf ("reg stack popped!\n");
-
-               switch (ch)
-			   {
-				   case '+':
-				   		if (reg_int == 1)
-						{
-							// write opcode name to code_temp
-							strcpy ((char *) code_temp, (const char *) opcode[ADDI].op);
-						}
-						else
-						{
-							// write opcode name to code_temp
-							strcpy ((char *) code_temp, (const char *) opcode[ADDD].op);
-						}
-						break;
-
-					case '-':
-	 				   	if (reg_int == 1)
-	 					{
-	 						// write opcode name to code_temp
-	 						strcpy ((char *) code_temp, (const char *) opcode[SUBI].op);
-	 					}
-	 					else
-	 					{
-	 						// write opcode name to code_temp
-	 						strcpy ((char *) code_temp, (const char *) opcode[SUBD].op);
-	 					}
-	 					break;
-
-					case '*':
-	 				   	if (reg_int == 1)
-	 					{
-	 						// write opcode name to code_temp
-	 						strcpy ((char *) code_temp, (const char *) opcode[MULI].op);
-	 					}
-	 					else
-	 					{
-	 						// write opcode name to code_temp
-	 						strcpy ((char *) code_temp, (const char *) opcode[MULD].op);
-	 					}
-	 					break;
-
-					case '/':
-	 				   	if (reg_int == 1)
-	 					{
-	 						// write opcode name to code_temp
-	 						strcpy ((char *) code_temp, (const char *) opcode[DIVI].op);
-	 					}
-	 					else
-	 					{
-	 						// write opcode name to code_temp
-	 						strcpy ((char *) code_temp, (const char *) opcode[DIVD].op);
-	 					}
-	 					break;
-				}
-
-				strcat ((char *) code_temp, " ");
-
-				sprintf ((char *) str, "%i", reg1);
-				strcat ((char *) code_temp, (const char *) str);
-				strcat ((char *) code_temp, ", ");
-				sprintf ((char *) str, "%i", reg2);
-				strcat ((char *) code_temp, (const char *) str);
-				strcat ((char *) code_temp, ", ");
-
-				// set temp variable as target for opcode
-
-				if (reg_int)
-				{
-					target_reg = get_free_regi ();
-					set_regi (target_reg, (U1 *) "cont_temp");
-				}
-				else
-				{
-					target_reg = get_free_regd ();
-					set_regd (target_reg, (U1 *) "cont_temp");
-				}
-
-				sprintf ((char *) str, "%i", target_reg);
-				strcat ((char *) code_temp, (const char *) str);
-				strcat ((char *) code_temp, "\n");
-
-				// write code
-				code_line++;
-				if (code_line >= line_len)
-				{
-					printf ("error: line %lli: code list full!\n", linenum);
-					return (1);
-				}
-				strcpy ((char *) code[code_line], (const char *) code_temp);
-
-				if (push_reg_stack (target_reg) != 0)
-	 		   	{
-	 				return (1);
-	 		   	}
            }
        }
        i++;
@@ -792,6 +1154,22 @@ S2 parse_rpolish (U1 *postfix)
 
 	// assign target reg to target variable
 
+	if (stack_reg_int < 0)
+	{
+		printf ("error: line %lli: no reg on stack, stack empty!\n", linenum);
+		return (1);
+	}
+	if (stack_reg_const[stack_reg_int] != 0)
+	{
+		// the expression is constant
+		stack_reg[stack_reg_int] = load_const (stack_reg_int);
+		if (stack_reg[stack_reg_int] == -1)
+		{
+			return (1);
+		}
+	}
+	target_reg = pop_reg_stack ();
+
 	// assign to normal variable ==============
 
 	if (checkdef (target_var) != 0)
@@ -858,6 +1236,7 @@ S2 parse_rpolish (U1 *postfix)
 				{
 					// set old value of reg2 as empty
 					set_regd (reg2, (U1 *) "");
+					clear_expr_regs (reg2, 0);
 				}
 				else
 				{
@@ -952,6 +1331,7 @@ S2 parse_rpolish (U1 *postfix)
 				{
 					// set old value of reg2 as empty
 					set_regi (reg2, (U1 *) "");
+					clear_expr_regs (reg2, 1);
 				}
 				else
 				{
@@ -961,5 +1341,6 @@ S2 parse_rpolish (U1 *postfix)
 		}
 	}
 
+	expr_code_line = code_line;
    return (0);
 }
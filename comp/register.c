@@ -22,16 +22,27 @@
 extern U1 regi[MAXREG][MAXLINELEN];
 extern U1 regd[MAXREG][MAXLINELEN];
 
+// highest registers used since init_reg_max: the callee saved range of a regfunc
+S4 regi_max = 0;
+S4 regd_max = 0;
 
 // register tracking functions
 void set_regi (S4 reg, U1 *name)
 {
 	strcpy ((char *) regi[reg], (const char *) name);
+	if (name[0] != '\0' && reg > regi_max)
+	{
+		regi_max = reg;
+	}
 }
 
 void set_regd (S4 reg, U1 *name)
 {
 	strcpy ((char *) regd[reg], (const char *) name);
+	if (name[0] != '\0' && reg > regd_max)
+	{
+		regd_max = reg;
+	}
 }
 
 S4 get_regi (U1 *name)
@@ -81,6 +92,10 @@ S4 get_free_regi (void)
 	{
 		if (strcmp ((const char *) regi[i], "") == 0)
 		{
+			if (i > regi_max)
+			{
+				regi_max = i;
+			}
 			return (i);
 		}
 	}
@@ -96,9 +111,29 @@ S4 get_free_regd (void)
 	{
 		if (strcmp ((const char *) regd[i], "") == 0)
 		{
+			if (i > regd_max)
+			{
+				regd_max = i;
+			}
 			return (i);
 		}
 	}
 	
 	return (-1);
 }
+
+void init_reg_max (void)
+{
+	regi_max = 0;
+	regd_max = 0;
+}
+
+S4 get_regi_max (void)
+{
+	return (regi_max);
+}
+
+S4 get_regd_max (void)
+{
+	return (regd_max);
+}
@@ -25,6 +25,8 @@ extern S8 data_ind;
 extern S8 linenum;
 
 U1 checkdigit (U1 *str);
+S8 get_temp_int (void);
+F8 get_temp_double (void);
 
 S2 checkdef (U1 *name)
 {
@@ -184,3 +186,33 @@ S2 get_var_is_const (U1 *name)
 	}
 	return (-1);	// ERROR #
 }
+
+S2 get_var_const_value (U1 *name, S8 *value_int, F8 *value_double)
+{
+	// value of a const int64 or double variable, returns its type or -1 if not a constant number
+	S4 i;
+
+	for (i = 0; i <= data_ind; i++)
+	{
+		if (strcmp ((const char *) name, (const char *) data_info[i].name) == 0)
+		{
+			if (data_info[i].constant == 0 || data_info[i].size != 1 || checkdigit (data_info[i].value_str) != TRUE)
+			{
+				return (-1);
+			}
+
+			if (data_info[i].type == QUADWORD)
+			{
+				*value_int = get_temp_int ();
+				return (QUADWORD);
+			}
+			if (data_info[i].type == DOUBLEFLOAT)
+			{
+				*value_double = get_temp_double ();
+				return (DOUBLEFLOAT);
+			}
+			return (-1);
+		}
+	}
+	return (-1);
+}
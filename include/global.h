@@ -100,6 +100,36 @@
 
 #define DO_ALIGNMENT			1 				// set 64 bit var alignment
 
+// VM: allocate data segment by anonymous mmap (Linux): memory pages are zeroed and mapped on first access
+#define DATA_MMAP				1
+
+// VM: data segments of this size or bigger get transparent huge pages (Linux), 0 = OFF
+#define DATA_HUGEPAGE_MIN_SIZE	33554432L		// 32 MB
+
+// VM: load native code made by l1aot (prog.l1aot.so next to prog.l1obj, Linux)
+#define AOT_LOAD				1
+
+// VM: sampling profiler "-P" (Linux): run() stores the epos of every opcode for the SIGPROF handler
+#define PROFILE					1
+#define PROFILE_INTERVAL		1000			// sample interval in microseconds of CPU time
+
+// VM: Linux perf support, needs PROFILE: "-m" writes /tmp/perf-PID.map for the JIT code
+// and /tmp/perf-PID.l1ep, the epos of the VM threads for vm/perf-l1vm.sh
+// "-j" writes /tmp/jit-PID.dump for "perf inject --jit"
+#define PERF_MAP				1
+
+// VM: module call statistics "-s" (Linux): calls, wall time and bytes of every module function
+// the report is written to prog.l1modstat at exit and on SIGUSR2, intr0 30 prints it
+#define MODULE_STATS			1
+
+// VM: thread trace "-t" (Linux): thread start/exit, spawn, join, data_mutex wait/hold and module calls
+// written to prog.trace.json in Chrome trace event format at exit
+#define TRACE					1
+
+// VM: count executed opcodes, intr0/intr1 functions and opcode pairs per thread (slows down the VM)
+// the report is written to prog.l1opcount at exit and on SIGUSR1
+#define OPCODE_COUNT			0
+
 #define LOW_RAM					0				// set to 1 on a machine with LOW RAM, like I do on the Psion 5MX Linux build! :)
 // user settings end ==========================================================
 
@@ -158,6 +188,9 @@
 	#endif
 #endif
 
+// check settings of native code: l1aot writes them into the .so, the VM only loads a .so with the same settings
+#define CHECK_FLAGS		((BOUNDSCHECK ? 1 : 0) | (DIVISIONCHECK ? 2 : 0) | (MATH_LIMITS ? 4 : 0) | (MATH_LIMITS_DOUBLE_FULL ? 8 : 0))
+
 
 typedef unsigned char           U1;		/* UBYTE   */
 typedef int16_t                 S2;     /* INT     */
@@ -182,6 +215,10 @@ typedef double                  F8;     /* DOUBLE */
 // machine
 #define MAXREG			256			// registers (integer and double float)
 
+// compiler register calling convention (regfunc, regcall)
+#define REGCALL_ARGS	8						// int and double arguments in registers
+#define REGCALL_REG		(MAXREG - REGCALL_ARGS)	// first argument register, also the return value
+
 #define MAXLINELEN      512
 #define MAXARGS         64
 #define MAXBRACKETLEVEL	64
@@ -246,6 +283,16 @@ struct threaddata
 	U1 status;				// thread status
 };
 
+// profiler: state of a VM thread, read by the SIGPROF handler
+struct profile_thread
+{
+	volatile S8 ep ALIGN;			// epos of the running opcode
+	S8 startpos ALIGN;				// thread start epos
+	S8 *jumpstack;					// jsr return addresses
+	volatile S8 *jumpstack_ind;
+	volatile S8 tid ALIGN;			// Linux thread id, for perf
+};
+
 struct t_var
 {
     U1 type;
@@ -271,7 +318,7 @@ struct data_info
 	U1 constant;				// set to one if variable is constant
 };
 
-#define MAXOPCODES              61
+#define MAXOPCODES              75
 
 
 #if ! JIT_COMPILER
@@ -283,6 +330,15 @@ struct opcode
 };
 #endif
 
+// opcode counters of a VM thread
+struct opcode_count
+{
+	S8 op[MAXOPCODES];
+	S8 pair[MAXOPCODES + 1][MAXOPCODES];	// [previous opcode][opcode], MAXOPCODES = thread start
+	S8 intr0[256];
+	S8 intr1[256];
+};
+
 // compiler:
 struct translate
 {
@@ -309,17 +365,31 @@ struct call_label
 #define MAXSHELLARGLEN			256
 
 
+// JIT-compiler: data the native code works on
+struct jit_context
+{
+	S8 *regi;
+	F8 *regd;
+	U1 *data;
+	S2 (*memory_bounds) (S8 start, S8 offset_access);
+	S8 error_ep ALIGN;			// epos of failed bounds check
+};
+
 // This is type of function we will generate
 // for JIT-compiler
-typedef void (*Func)(void);
+typedef S8 (*Func)(struct jit_context *ctx);
 
 struct JIT_code
 {
 	Func fn;
+	U1 *mem;					// executable memory
+	S8 mem_size ALIGN;
+	S8 start ALIGN;				// compiled code range
+	S8 end ALIGN;
 };
 
 
-// 61 opcodes
+// 75 opcodes
 #define PUSHB   0
 #define PUSHW   1
 #define PUSHDW  2
@@ -401,3 +471,25 @@ struct JIT_code
 #define LOAD    59
 
 #define NOTI	60
+
+// jump table: jmpt index, count, default - followed by count jmp opcodes
+#define JMPT	61
+
+// push/pull with scaled index: index register * element size
+#define PUSHWS	62
+#define PUSHDWS	63
+#define PUSHQWS	64
+#define PUSHDS	65
+#define PULLWS	66
+#define PULLDWS	67
+#define PULLQWS	68
+#define PULLDS	69
+
+// stack push/pop of a register range: first, last register
+#define STPUSHIR	70
+#define STPOPIR		71
+#define STPUSHDR	72
+#define STPOPDR		73
+
+// shift left by a number of bits: shli reg, bits, target
+#define SHLI		74
@@ -97,5 +97,24 @@ struct opcode opcode[] =
 
 	{ "load", 3, { DATA, DATA_OFFS, I_REG, EMPTY }, },
 
-    { "noti", 2, { I_REG, I_REG, EMPTY, EMPTY }, }
+    { "noti", 2, { I_REG, I_REG, EMPTY, EMPTY }, },
+
+	{ "jmpt", 3, { I_REG, ALL, LABEL, EMPTY }, },
+
+	{ "pushws", 3, { I_REG, I_REG, I_REG, EMPTY } },	// 62
+	{ "pushdws", 3, { I_REG, I_REG, I_REG, EMPTY } },
+	{ "pushqws", 3, { I_REG, I_REG, I_REG, EMPTY } },
+	{ "pushds", 3, { I_REG, I_REG, D_REG, EMPTY } },
+
+	{ "pullws", 3, { I_REG, I_REG, I_REG, EMPTY } },
+	{ "pulldws", 3, { I_REG, I_REG, I_REG, EMPTY } },
+	{ "pullqws", 3, { I_REG, I_REG, I_REG, EMPTY } },
+	{ "pullds", 3, { D_REG, I_REG, I_REG, EMPTY } },
+
+	{ "stpushir", 2, { I_REG, I_REG, EMPTY, EMPTY } },	// 70
+	{ "stpopir", 2, { I_REG, I_REG, EMPTY, EMPTY } },
+	{ "stpushdr", 2, { D_REG, D_REG, EMPTY, EMPTY } },
+	{ "stpopdr", 2, { D_REG, D_REG, EMPTY, EMPTY } },
+
+	{ "shli", 3, { I_REG, ALL, I_REG, EMPTY } }		// 74
 };
@@ -0,0 +1,36 @@
+/*
+ * This file code_hash.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../include/global.h"
+
+// FNV-1a 64 bit hash of code[start] to code[end - 1]
+// used to check if native code made from an object still matches it
+
+S8 code_hash (U1 *code, S8 start, S8 end)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	S8 i ALIGN;
+
+	for (i = start; i < end; i++)
+	{
+		hash = hash ^ code[i];
+		hash = hash * 1099511628211ULL;
+	}
+	return ((S8) hash);
+}
@@ -0,0 +1,228 @@
+/*
+ * This file debug-info.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1vm RISC VM
+//
+//  debug info: maps an epos to the line and the label of the .l1asm file
+//  by the .l1dbg file of the program. Used by the profiler and the perf support.
+
+#include "../include/global.h"
+
+// debug info: epos -> line, line -> label
+struct debug_line
+{
+	S8 epos ALIGN;
+	S8 line ALIGN;
+};
+
+static struct debug_line *debug_lines = NULL;
+static S8 debug_lines_ind ALIGN = -1;
+static U1 **asm_line = NULL;				// lines of the .l1asm file
+static S8 asm_lines ALIGN = 0;
+static S8 *asm_label = NULL;				// line number of the label before the line, -1 = none
+static U1 debug_loaded = 0;
+
+void debug_info_free (void)
+{
+	S8 i ALIGN;
+
+	if (asm_line)
+	{
+		for (i = 0; i < asm_lines; i++)
+		{
+			if (asm_line[i]) free (asm_line[i]);
+		}
+		free (asm_line);
+	}
+	if (asm_label) free (asm_label);
+	if (debug_lines) free (debug_lines);
+	asm_line = NULL;
+	asm_label = NULL;
+	debug_lines = NULL;
+	debug_lines_ind = -1;
+	asm_lines = 0;
+	debug_loaded = 0;
+}
+
+static S2 load_debug_info (U1 *name)
+{
+	// .l1dbg: "epos: 16, 31 line num", line numbers of the .l1asm file, counted from 1
+	FILE *fptr;
+	U1 file_name[512];
+	U1 buf[MAXLINELEN];
+	S8 epos ALIGN;
+	S8 line ALIGN;
+	S8 size ALIGN = 1024;
+	S8 i ALIGN;
+	S8 label ALIGN = -1;
+	U1 *ptr;
+
+	snprintf ((char *) file_name, 512, "%s.l1dbg", name);
+	fptr = fopen ((const char *) file_name, "r");
+	if (fptr == NULL)
+	{
+		printf ("debug info: can't open '%s', no labels and lines!\n", file_name);
+		return (1);
+	}
+
+	debug_lines = (struct debug_line *) malloc (size * sizeof (struct debug_line));
+	while (debug_lines != NULL && fgets ((char *) buf, MAXLINELEN, fptr) != NULL)
+	{
+		if (sscanf ((const char *) buf, "epos: %lli, %lli", &epos, &line) != 2)
+		{
+			continue;
+		}
+		if (debug_lines_ind >= size - 1)
+		{
+			size = size * 2;
+			debug_lines = (struct debug_line *) realloc (debug_lines, size * sizeof (struct debug_line));
+			if (debug_lines == NULL) break;
+		}
+		debug_lines_ind++;
+		debug_lines[debug_lines_ind].epos = epos;
+		debug_lines[debug_lines_ind].line = line;
+	}
+	fclose (fptr);
+	if (debug_lines == NULL)
+	{
+		printf ("debug info: ERROR: can't allocate debug info!\n");
+		return (1);
+	}
+
+	snprintf ((char *) file_name, 512, "%s.l1asm", name);
+	fptr = fopen ((const char *) file_name, "r");
+	if (fptr == NULL)
+	{
+		printf ("debug info: can't open '%s', no labels!\n", file_name);
+		return (1);
+	}
+
+	size = 1024;
+	asm_line = (U1 **) calloc (size, sizeof (U1 *));
+	asm_label = (S8 *) malloc (size * sizeof (S8));
+	while (asm_line != NULL && asm_label != NULL && fgets ((char *) buf, MAXLINELEN, fptr) != NULL)
+	{
+		if (asm_lines >= size)
+		{
+			size = size * 2;
+			asm_line = (U1 **) realloc (asm_line, size * sizeof (U1 *));
+			asm_label = (S8 *) realloc (asm_label, size * sizeof (S8));
+			if (asm_line == NULL || asm_label == NULL) break;
+		}
+
+		// remove newline and leading spaces
+		buf[strcspn ((const char *) buf, "\r\n")] = '\0';
+		for (ptr = buf; *ptr == ' ' || *ptr == '\t'; ptr++);
+
+		asm_line[asm_lines] = (U1 *) strdup ((const char *) ptr);
+		if (ptr[0] == ':')
+		{
+			label = asm_lines;
+		}
+		asm_label[asm_lines] = label;
+		asm_lines++;
+	}
+	fclose (fptr);
+	if (asm_line == NULL || asm_label == NULL)
+	{
+		printf ("debug info: ERROR: can't allocate debug info!\n");
+		return (1);
+	}
+
+	for (i = 0; i < asm_lines; i++)
+	{
+		if (asm_line[i] == NULL)
+		{
+			printf ("debug info: ERROR: can't allocate debug info!\n");
+			return (1);
+		}
+	}
+	return (0);
+}
+
+// load the .l1dbg and .l1asm file of the program, only once
+S2 debug_info_load (U1 *name)
+{
+	if (debug_loaded)
+	{
+		return (debug_lines == NULL);
+	}
+	debug_loaded = 1;
+
+	if (load_debug_info (name) != 0)
+	{
+		debug_info_free ();
+		debug_loaded = 1;
+		return (1);
+	}
+	return (0);
+}
+
+// .l1asm line number (from 1) of the opcode at epos, 0 = unknown
+S8 debug_info_line (S8 epos)
+{
+	S8 low ALIGN = 0;
+	S8 high ALIGN = debug_lines_ind;
+	S8 mid ALIGN;
+	S8 line ALIGN = 0;
+
+	if (debug_lines == NULL)
+	{
+		return (0);
+	}
+
+	while (low <= high)
+	{
+		mid = (low + high) / 2;
+		if (debug_lines[mid].epos <= epos)
+		{
+			line = debug_lines[mid].line;
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+	return (line);
+}
+
+// text of .l1asm line number (from 1), "" if unknown
+U1 *debug_info_asm_line (S8 line)
+{
+	if (asm_line == NULL || line < 1 || line > asm_lines)
+	{
+		return ((U1 *) "");
+	}
+	return (asm_line[line - 1]);
+}
+
+// name of the label before epos, without ':'
+void debug_info_label (S8 epos, U1 *name, S8 len)
+{
+	S8 line ALIGN;
+
+	line = debug_info_line (epos);
+	if (asm_label == NULL || line < 1 || line > asm_lines || asm_label[line - 1] < 0)
+	{
+		snprintf ((char *) name, len, "epos_%lli", epos);
+		return;
+	}
+	snprintf ((char *) name, len, "%s", asm_line[asm_label[line - 1]] + 1);
+}
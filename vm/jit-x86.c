@@ -0,0 +1,1590 @@
+/*
+ * This file jit-x86.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1vm RISC VM
+//
+//  baseline JIT compiler for x86-64
+//
+//  Translates a code range opcode by opcode into native code. The native code
+//  works directly on the VM registers regi[] and regd[] and on the data memory.
+//  It is called as: S8 fn (struct jit_context *ctx)
+//
+//  host registers inside of the generated code:
+//  rbx = regi, rbp = regd, r13 = data, r14 = jit_context
+//  r8 - r12, r15 and xmm2 - xmm15 hold the most used VM registers of the code range (JIT_REG_ALLOC)
+//
+//  The return value is the epos where the interpreter has to continue,
+//  or JIT_EXIT_END if the end of the code range was reached.
+//  Opcodes which are not compiled (intr0, intr1, stack, jsr, rts...) and jumps to
+//  targets outside of the code range leave the native code to the interpreter.
+
+#include "../include/global.h"
+#include "jit.h"
+
+#if __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <link.h>
+#include <elf.h>
+#endif
+
+#include <stddef.h>
+
+// host registers
+#define RAX		0
+#define RCX		1
+#define RDX		2
+#define RBX		3
+#define RSP		4
+#define RBP		5
+#define RSI		6
+#define RDI		7
+#define R8		8
+#define R9		9
+#define R10		10
+#define R11		11
+#define R12		12
+#define R13		13
+#define R14		14
+#define R15		15
+
+#define XMM0	0
+#define XMM1	1
+
+// condition codes for setcc and jcc
+#define CC_A	0x7
+#define CC_AE	0x3
+#define CC_E	0x4
+#define CC_NE	0x5
+#define CC_P	0xA
+#define CC_NP	0xB
+#define CC_L	0xC
+#define CC_GE	0xD
+#define CC_LE	0xE
+#define CC_G	0xF
+
+// fixup types
+#define FIX_BRANCH		0		// jump to epos
+#define FIX_EXIT		1		// jump to exit code
+#define FIX_STUB		2		// jump to exit code, return epos to interpreter
+
+struct jit_fixup
+{
+	S8 pos ALIGN;		// position of rel32 in native code
+	S8 target ALIGN;	// epos
+	U1 type;
+};
+
+struct jit_buf
+{
+	U1 *buf;
+	S8 size ALIGN;
+	S8 pos ALIGN;
+	struct jit_fixup *fixup;
+	S8 fixup_size ALIGN;
+	S8 fixup_ind ALIGN;
+	U1 error;
+	U1 regi_host[MAXREG];		// host register of VM register, 0 = in memory
+	U1 regd_host[MAXREG];
+};
+
+// host registers for VM registers, callee saved first
+static const U1 jit_regi_alloc[] = { R12, R15, R8, R9, R10, R11 };
+static const U1 jit_regd_alloc[] = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+S2 memory_bounds (S8 start, S8 offset_access);
+S2 memory_bounds_check (S8 start, S8 offset_access);
+S8 code_hash (U1 *code, S8 start, S8 end);
+char *get_home (void);
+
+extern struct data_info data_info[MAXDATAINFO];
+extern S8 data_info_ind ALIGN;
+
+#if PERF_MAP && PROFILE
+void perf_jit_code (U1 *fn, S8 size, S8 start, S8 end);
+#endif
+
+// JIT cache file header, followed by the native code
+struct jit_cache_header
+{
+	S8 magic ALIGN;
+	S8 build ALIGN;			// hash of the VM build-id, the check settings and JIT_CACHE_VERSION
+	S8 hash ALIGN;			// hash of the code range
+	S8 start ALIGN;
+	S8 end ALIGN;
+	S8 exit_ep ALIGN;
+	S8 size ALIGN;			// native code size
+	S8 data ALIGN;			// hash of the data layout, constant addresses are checked at compile time
+};
+
+static void emit_byte (struct jit_buf *jit, U1 byte)
+{
+	U1 *new_buf;
+
+	if (jit->error) return;
+
+	if (jit->pos >= jit->size)
+	{
+		new_buf = (U1 *) realloc (jit->buf, jit->size * 2);
+		if (new_buf == NULL)
+		{
+			printf ("jit_compiler: ERROR: can't allocate code buffer!\n");
+			jit->error = 1;
+			return;
+		}
+		jit->buf = new_buf;
+		jit->size = jit->size * 2;
+	}
+	jit->buf[jit->pos++] = byte;
+}
+
+static void emit_s4 (struct jit_buf *jit, S4 num)
+{
+	emit_byte (jit, num & 0xFF);
+	emit_byte (jit, (num >> 8) & 0xFF);
+	emit_byte (jit, (num >> 16) & 0xFF);
+	emit_byte (jit, (num >> 24) & 0xFF);
+}
+
+static void emit_s8 (struct jit_buf *jit, S8 num)
+{
+	emit_s4 (jit, (S4) (num & 0xFFFFFFFF));
+	emit_s4 (jit, (S4) ((num >> 32) & 0xFFFFFFFF));
+}
+
+static void emit_opcode (struct jit_buf *jit, S4 op)
+{
+	// two byte opcodes are given as 0x0Fxx
+	if (op > 0xFF)
+	{
+		emit_byte (jit, (op >> 8) & 0xFF);
+	}
+	emit_byte (jit, op & 0xFF);
+}
+
+static void emit_prefix_rex (struct jit_buf *jit, U1 prefix, U1 rexw, U1 reg, U1 rm)
+{
+	U1 rex = 0x40;
+
+	if (prefix) emit_byte (jit, prefix);
+
+	if (rexw) rex = rex | 0x08;
+	if (reg & 8) rex = rex | 0x04;
+	if (rm & 8) rex = rex | 0x01;
+	if (rex != 0x40) emit_byte (jit, rex);
+}
+
+// op reg, [base + disp]
+static void emit_op_mem (struct jit_buf *jit, U1 prefix, U1 rexw, S4 op, U1 reg, U1 base, S4 disp)
+{
+	U1 mod;
+
+	emit_prefix_rex (jit, prefix, rexw, reg, base);
+	emit_opcode (jit, op);
+
+	if (disp == 0 && (base & 7) != RBP)
+	{
+		mod = 0;
+	}
+	else
+	{
+		if (disp >= -128 && disp <= 127)
+		{
+			mod = 1;
+		}
+		else
+		{
+			mod = 2;
+		}
+	}
+
+	emit_byte (jit, (mod << 6) | ((reg & 7) << 3) | (base & 7));
+	if ((base & 7) == RSP)
+	{
+		// SIB byte: base only
+		emit_byte (jit, 0x24);
+	}
+	if (mod == 1) emit_byte (jit, (U1) (disp & 0xFF));
+	if (mod == 2) emit_s4 (jit, disp);
+}
+
+// op reg, rm
+static void emit_op_reg (struct jit_buf *jit, U1 prefix, U1 rexw, S4 op, U1 reg, U1 rm)
+{
+	emit_prefix_rex (jit, prefix, rexw, reg, rm);
+	emit_opcode (jit, op);
+	emit_byte (jit, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+// op host, regi[vmreg]
+static void emit_op_regi (struct jit_buf *jit, S4 op, U1 host, U1 vmreg)
+{
+	if (jit->regi_host[vmreg])
+	{
+		emit_op_reg (jit, 0, 1, op, host, jit->regi_host[vmreg]);
+		return;
+	}
+	emit_op_mem (jit, 0, 1, op, host, RBX, (S4) vmreg * sizeof (S8));
+}
+
+// op xmm, regd[vmreg]
+static void emit_op_regd (struct jit_buf *jit, U1 prefix, S4 op, U1 xmm, U1 vmreg)
+{
+	if (jit->regd_host[vmreg])
+	{
+		emit_op_reg (jit, prefix, 0, op, xmm, jit->regd_host[vmreg]);
+		return;
+	}
+	emit_op_mem (jit, prefix, 0, op, xmm, RBP, (S4) vmreg * sizeof (F8));
+}
+
+static void emit_load_regi (struct jit_buf *jit, U1 host, U1 vmreg)
+{
+	emit_op_regi (jit, 0x8B, host, vmreg);
+}
+
+static void emit_store_regi (struct jit_buf *jit, U1 vmreg, U1 host)
+{
+	emit_op_regi (jit, 0x89, host, vmreg);
+}
+
+static void emit_load_regd (struct jit_buf *jit, U1 xmm, U1 vmreg)
+{
+	// movsd xmm, [m64]
+	emit_op_regd (jit, 0xF2, 0x0F10, xmm, vmreg);
+}
+
+static void emit_store_regd (struct jit_buf *jit, U1 vmreg, U1 xmm)
+{
+	// movsd [m64], xmm
+	emit_op_regd (jit, 0xF2, 0x0F11, xmm, vmreg);
+}
+
+static void emit_mov_imm (struct jit_buf *jit, U1 host, S8 num)
+{
+	// mov r64, imm64
+	emit_prefix_rex (jit, 0, 1, 0, host);
+	emit_byte (jit, 0xB8 + (host & 7));
+	emit_s8 (jit, num);
+}
+
+// setcc al; movzx eax, al
+static void emit_setcc_rax (struct jit_buf *jit, U1 cc)
+{
+	emit_byte (jit, 0x0F); emit_byte (jit, 0x90 + cc); emit_byte (jit, 0xC0);
+	emit_byte (jit, 0x0F); emit_byte (jit, 0xB6); emit_byte (jit, 0xC0);
+}
+
+static void add_fixup (struct jit_buf *jit, S8 target, U1 type)
+{
+	struct jit_fixup *new_fixup;
+
+	if (jit->error) return;
+
+	if (jit->fixup_ind >= jit->fixup_size - 1)
+	{
+		new_fixup = (struct jit_fixup *) realloc (jit->fixup, jit->fixup_size * 2 * sizeof (struct jit_fixup));
+		if (new_fixup == NULL)
+		{
+			printf ("jit_compiler: ERROR: can't allocate fixup list!\n");
+			jit->error = 1;
+			return;
+		}
+		jit->fixup = new_fixup;
+		jit->fixup_size = jit->fixup_size * 2;
+	}
+
+	jit->fixup_ind++;
+	jit->fixup[jit->fixup_ind].pos = jit->pos;
+	jit->fixup[jit->fixup_ind].target = target;
+	jit->fixup[jit->fixup_ind].type = type;
+}
+
+static void emit_jmp (struct jit_buf *jit, S8 target, U1 type)
+{
+	emit_byte (jit, 0xE9);
+	add_fixup (jit, target, type);
+	emit_s4 (jit, 0);
+}
+
+static void emit_jcc (struct jit_buf *jit, U1 cc, S8 target, U1 type)
+{
+	emit_byte (jit, 0x0F);
+	emit_byte (jit, 0x80 + cc);
+	add_fixup (jit, target, type);
+	emit_s4 (jit, 0);
+}
+
+// leave native code: return epos to interpreter
+static void emit_exit (struct jit_buf *jit, S8 epos)
+{
+	emit_mov_imm (jit, RAX, epos);
+	emit_jmp (jit, 0, FIX_EXIT);
+}
+
+// store VM registers in host registers to regi[] and regd[]
+// caller_saved = 1: only the ones which a C function call may overwrite
+static void emit_spill_regs (struct jit_buf *jit, U1 caller_saved)
+{
+	S2 i;
+
+	for (i = 0; i < MAXREG; i++)
+	{
+		if (jit->regi_host[i] && ! (caller_saved && (jit->regi_host[i] == R12 || jit->regi_host[i] == R15)))
+		{
+			emit_op_mem (jit, 0, 1, 0x89, jit->regi_host[i], RBX, (S4) i * sizeof (S8));
+		}
+		if (jit->regd_host[i])
+		{
+			emit_op_mem (jit, 0xF2, 0, 0x0F11, jit->regd_host[i], RBP, (S4) i * sizeof (F8));
+		}
+	}
+}
+
+static void emit_reload_regs (struct jit_buf *jit, U1 caller_saved)
+{
+	S2 i;
+
+	for (i = 0; i < MAXREG; i++)
+	{
+		if (jit->regi_host[i] && ! (caller_saved && (jit->regi_host[i] == R12 || jit->regi_host[i] == R15)))
+		{
+			emit_op_mem (jit, 0, 1, 0x8B, jit->regi_host[i], RBX, (S4) i * sizeof (S8));
+		}
+		if (jit->regd_host[i])
+		{
+			emit_op_mem (jit, 0xF2, 0, 0x0F10, jit->regd_host[i], RBP, (S4) i * sizeof (F8));
+		}
+	}
+}
+
+// index shift of the push/pull opcodes with scaled index
+static U1 jit_index_shift (U1 op)
+{
+	switch (op)
+	{
+		case PUSHWS:
+		case PULLWS:
+			return (1);
+
+		case PUSHDWS:
+		case PULLDWS:
+			return (2);
+
+		case PUSHQWS:
+		case PUSHDS:
+		case PULLQWS:
+		case PULLDS:
+			return (3);
+	}
+	return (0);
+}
+
+#if BOUNDSCHECK
+// call memory_bounds (regi[base], regi[offset] << shift), on error exit with JIT_EXIT_ERROR
+static void emit_bounds_check (struct jit_buf *jit, U1 base, U1 offset, U1 shift, S8 epos)
+{
+	S8 skip_pos ALIGN;
+
+	emit_load_regi (jit, RDI, base);
+	emit_load_regi (jit, RSI, offset);
+	if (shift)
+	{
+		emit_op_reg (jit, 0, 1, 0xC1, 4, RSI); emit_byte (jit, shift);	// shl rsi, shift
+	}
+	emit_spill_regs (jit, 1);
+	// call [r14 + memory_bounds]
+	emit_op_mem (jit, 0, 0, 0xFF, 2, R14, offsetof (struct jit_context, memory_bounds));
+	emit_reload_regs (jit, 1);
+	// test ax, ax
+	emit_byte (jit, 0x66); emit_byte (jit, 0x85); emit_byte (jit, 0xC0);
+	// jz ok
+	emit_byte (jit, 0x74);
+	skip_pos = jit->pos;
+	emit_byte (jit, 0);
+
+	emit_mov_imm (jit, RAX, epos);
+	emit_op_mem (jit, 0, 1, 0x89, RAX, R14, offsetof (struct jit_context, error_ep));
+	emit_exit (jit, JIT_EXIT_ERROR);
+
+	if (! jit->error) jit->buf[skip_pos] = (U1) (jit->pos - skip_pos - 1);
+}
+#endif
+
+// rax = data + regi[base] + (regi[offset] << shift)
+static void emit_data_address (struct jit_buf *jit, U1 base, U1 offset, U1 shift)
+{
+	if (shift)
+	{
+		emit_load_regi (jit, RAX, offset);
+		emit_op_reg (jit, 0, 1, 0xC1, 4, RAX); emit_byte (jit, shift);	// shl rax, shift
+		emit_op_regi (jit, 0x03, RAX, base);		// add rax, regi[base]
+	}
+	else
+	{
+		emit_load_regi (jit, RAX, base);
+		emit_op_regi (jit, 0x03, RAX, offset);		// add rax, regi[offset]
+	}
+	emit_op_reg (jit, 0, 1, 0x01, R13, RAX);	// add rax, r13
+}
+
+static S8 get_label (U1 *code, S8 pos)
+{
+	S8 label ALIGN;
+
+	memcpy (&label, &code[pos], sizeof (S8));
+	return (label);
+}
+
+S8 jit_opcode_size (U1 op)
+{
+	if (op <= LSEQD || (op >= PUSHWS && op <= PULLDS)) return (4);
+
+	switch (op)
+	{
+		case JMP:
+		case JSR:
+			return (9);
+
+		case JMPI:
+		case LOADL:
+			return (10);
+
+		case INCLSIJMPI:
+		case DECGRIJMPI:
+		case JMPT:
+			return (11);
+
+		case STPUSHB:
+		case STPOPB:
+		case STPUSHI:
+		case STPOPI:
+		case STPUSHD:
+		case STPOPD:
+		case JMPA:
+		case JSRA:
+			return (2);
+
+		case LOADA:
+		case LOADD:
+		case LOAD:
+			return (18);
+
+		case INTR0:
+		case INTR1:
+			return (5);
+
+		case SHLI:
+			return (4);
+
+		case MOVI:
+		case MOVD:
+		case NOTI:
+		case STPUSHIR:
+		case STPOPIR:
+		case STPUSHDR:
+		case STPOPDR:
+			return (3);
+
+		case RTS:
+			return (1);
+	}
+	return (0);
+}
+
+static void emit_prologue (struct jit_buf *jit)
+{
+	emit_byte (jit, 0x53);						// push rbx
+	emit_byte (jit, 0x55);						// push rbp
+	emit_byte (jit, 0x41); emit_byte (jit, 0x54);	// push r12
+	emit_byte (jit, 0x41); emit_byte (jit, 0x55);	// push r13
+	emit_byte (jit, 0x41); emit_byte (jit, 0x56);	// push r14
+	emit_byte (jit, 0x41); emit_byte (jit, 0x57);	// push r15
+	// sub rsp, 8: keep stack 16 byte aligned for calls
+	emit_byte (jit, 0x48); emit_byte (jit, 0x83); emit_byte (jit, 0xEC); emit_byte (jit, 0x08);
+
+	emit_op_reg (jit, 0, 1, 0x89, RDI, R14);	// mov r14, rdi
+	emit_op_mem (jit, 0, 1, 0x8B, RBX, R14, offsetof (struct jit_context, regi));
+	emit_op_mem (jit, 0, 1, 0x8B, RBP, R14, offsetof (struct jit_context, regd));
+	emit_op_mem (jit, 0, 1, 0x8B, R13, R14, offsetof (struct jit_context, data));
+}
+
+static void emit_epilogue (struct jit_buf *jit)
+{
+	emit_byte (jit, 0x48); emit_byte (jit, 0x83); emit_byte (jit, 0xC4); emit_byte (jit, 0x08);	// add rsp, 8
+	emit_byte (jit, 0x41); emit_byte (jit, 0x5F);	// pop r15
+	emit_byte (jit, 0x41); emit_byte (jit, 0x5E);	// pop r14
+	emit_byte (jit, 0x41); emit_byte (jit, 0x5D);	// pop r13
+	emit_byte (jit, 0x41); emit_byte (jit, 0x5C);	// pop r12
+	emit_byte (jit, 0x5D);						// pop rbp
+	emit_byte (jit, 0x5B);						// pop rbx
+	emit_byte (jit, 0xC3);						// ret
+}
+
+// integer compare: regi[r3] = regi[r1] cc regi[r2]
+static void emit_compare_i (struct jit_buf *jit, U1 cc, U1 r1, U1 r2, U1 r3)
+{
+	emit_load_regi (jit, RAX, r1);
+	emit_op_regi (jit, 0x3B, RAX, r2);			// cmp rax, regi[r2]
+	emit_setcc_rax (jit, cc);
+	emit_store_regi (jit, r3, RAX);
+}
+
+// double compare: regi[r3] = regd[r1] op regd[r2]
+static void emit_compare_d (struct jit_buf *jit, U1 op, U1 r1, U1 r2, U1 r3)
+{
+	U1 swap = 0;
+	U1 cc = CC_E;
+
+	// ucomisd sets the parity flag on NaN, which must compare as false, except for !=
+	switch (op)
+	{
+		case GRD: cc = CC_A; break;
+		case LSD: cc = CC_A; swap = 1; break;
+		case GREQD: cc = CC_AE; break;
+		case LSEQD: cc = CC_AE; swap = 1; break;
+	}
+
+	if (swap)
+	{
+		emit_load_regd (jit, XMM0, r2);
+		emit_op_regd (jit, 0x66, 0x0F2E, XMM0, r1);	// ucomisd xmm0, regd[r1]
+	}
+	else
+	{
+		emit_load_regd (jit, XMM0, r1);
+		emit_op_regd (jit, 0x66, 0x0F2E, XMM0, r2);	// ucomisd xmm0, regd[r2]
+	}
+
+	switch (op)
+	{
+		case EQD:
+			// sete al; setnp cl; and al, cl
+			emit_byte (jit, 0x0F); emit_byte (jit, 0x90 + CC_E); emit_byte (jit, 0xC0);
+			emit_byte (jit, 0x0F); emit_byte (jit, 0x90 + CC_NP); emit_byte (jit, 0xC1);
+			emit_byte (jit, 0x20); emit_byte (jit, 0xC8);
+			emit_byte (jit, 0x0F); emit_byte (jit, 0xB6); emit_byte (jit, 0xC0);
+			break;
+
+		case NEQD:
+			// setne al; setp cl; or al, cl
+			emit_byte (jit, 0x0F); emit_byte (jit, 0x90 + CC_NE); emit_byte (jit, 0xC0);
+			emit_byte (jit, 0x0F); emit_byte (jit, 0x90 + CC_P); emit_byte (jit, 0xC1);
+			emit_byte (jit, 0x08); emit_byte (jit, 0xC8);
+			emit_byte (jit, 0x0F); emit_byte (jit, 0xB6); emit_byte (jit, 0xC0);
+			break;
+
+		default:
+			emit_setcc_rax (jit, cc);
+			break;
+	}
+	emit_store_regi (jit, r3, RAX);
+}
+
+// host = host op regi[r2]
+static void emit_math_i (struct jit_buf *jit, U1 op, U1 host, U1 r2)
+{
+	switch (op)
+	{
+		case ADDI: emit_op_regi (jit, 0x03, host, r2); break;
+		case SUBI: emit_op_regi (jit, 0x2B, host, r2); break;
+		case MULI: emit_op_regi (jit, 0x0FAF, host, r2); break;
+		case BANDI: emit_op_regi (jit, 0x23, host, r2); break;
+		case BORI: emit_op_regi (jit, 0x0B, host, r2); break;
+		case BXORI: emit_op_regi (jit, 0x33, host, r2); break;
+	}
+}
+
+// xmm = xmm op regd[r2]
+static void emit_math_d (struct jit_buf *jit, U1 op, U1 xmm, U1 r2)
+{
+	switch (op)
+	{
+		case ADDD: emit_op_regd (jit, 0xF2, 0x0F58, xmm, r2); break;
+		case SUBD: emit_op_regd (jit, 0xF2, 0x0F5C, xmm, r2); break;
+		case MULD: emit_op_regd (jit, 0xF2, 0x0F59, xmm, r2); break;
+		case DIVD: emit_op_regd (jit, 0xF2, 0x0F5E, xmm, r2); break;
+	}
+}
+
+// logical and/or: regi[r3] = regi[r1] && regi[r2]
+static void emit_logical_i (struct jit_buf *jit, U1 op, U1 r1, U1 r2, U1 r3)
+{
+	emit_load_regi (jit, RAX, r1);
+	emit_load_regi (jit, RCX, r2);
+	emit_byte (jit, 0x48); emit_byte (jit, 0x85); emit_byte (jit, 0xC0);	// test rax, rax
+	emit_byte (jit, 0x0F); emit_byte (jit, 0x90 + CC_NE); emit_byte (jit, 0xC0);	// setne al
+	emit_byte (jit, 0x48); emit_byte (jit, 0x85); emit_byte (jit, 0xC9);	// test rcx, rcx
+	emit_byte (jit, 0x0F); emit_byte (jit, 0x90 + CC_NE); emit_byte (jit, 0xC1);	// setne cl
+	if (op == ANDI)
+	{
+		emit_byte (jit, 0x20); emit_byte (jit, 0xC8);	// and al, cl
+	}
+	else
+	{
+		emit_byte (jit, 0x08); emit_byte (jit, 0xC8);	// or al, cl
+	}
+	emit_byte (jit, 0x0F); emit_byte (jit, 0xB6); emit_byte (jit, 0xC0);	// movzx eax, al
+	emit_store_regi (jit, r3, RAX);
+}
+
+// opcodes which are translated into native code
+S2 jit_native_opcode (U1 op)
+{
+	#if MATH_LIMITS || MATH_LIMITS_DOUBLE_FULL
+	if ((op >= ADDI && op <= DIVD) || op == SHLI)
+	{
+		return (0);
+	}
+	#endif
+
+	switch (op)
+	{
+		case STPUSHB:
+		case STPOPB:
+		case STPUSHI:
+		case STPOPI:
+		case STPUSHD:
+		case STPOPD:
+		case STPUSHIR:
+		case STPOPIR:
+		case STPUSHDR:
+		case STPOPDR:
+		case INTR0:
+		case INTR1:
+		case JSR:
+		case JSRA:
+		case RTS:
+		case JMPT:
+			return (0);
+	}
+	return (1);
+}
+
+// compile one opcode at epos, returns 1 if the opcode is not compiled
+static S2 emit_opcode_vm (struct jit_buf *jit, U1 *code, S8 epos)
+{
+	U1 op = code[epos];
+	U1 r1 = code[epos + 1];
+	U1 r2 = code[epos + 2];
+	U1 r3 = code[epos + 3];
+	S8 arg1 ALIGN;
+	S8 arg2 ALIGN;
+
+	if (jit_native_opcode (op) == 0)
+	{
+		// with MATH_LIMITS the overflow checks are done by the interpreter
+		return (1);
+	}
+
+	switch (op)
+	{
+		case PUSHB:
+		case PUSHW:
+		case PUSHDW:
+		case PUSHQW:
+		case PUSHD:
+		case PUSHWS:
+		case PUSHDWS:
+		case PUSHQWS:
+		case PUSHDS:
+			#if BOUNDSCHECK
+			emit_bounds_check (jit, r1, r2, jit_index_shift (op), epos);
+			#endif
+			emit_data_address (jit, r1, r2, jit_index_shift (op));
+			switch (op)
+			{
+				case PUSHB:
+					emit_op_mem (jit, 0, 0, 0x0FB6, RCX, RAX, 0);	// movzx ecx, byte [rax]
+					emit_store_regi (jit, r3, RCX);
+					break;
+
+				case PUSHW:
+				case PUSHWS:
+					emit_op_mem (jit, 0, 0, 0x0FB7, RCX, RAX, 0);	// movzx ecx, word [rax]
+					emit_store_regi (jit, r3, RCX);
+					break;
+
+				case PUSHDW:
+				case PUSHDWS:
+					emit_op_mem (jit, 0, 0, 0x8B, RCX, RAX, 0);		// mov ecx, [rax]
+					emit_store_regi (jit, r3, RCX);
+					break;
+
+				case PUSHQW:
+				case PUSHQWS:
+					emit_op_mem (jit, 0, 1, 0x8B, RCX, RAX, 0);		// mov rcx, [rax]
+					emit_store_regi (jit, r3, RCX);
+					break;
+
+				case PUSHD:
+				case PUSHDS:
+					emit_op_mem (jit, 0xF2, 0, 0x0F10, XMM0, RAX, 0);	// movsd xmm0, [rax]
+					emit_store_regd (jit, r3, XMM0);
+					break;
+			}
+			break;
+
+		case PULLB:
+		case PULLW:
+		case PULLDW:
+		case PULLQW:
+		case PULLD:
+		case PULLWS:
+		case PULLDWS:
+		case PULLQWS:
+		case PULLDS:
+			#if BOUNDSCHECK
+			emit_bounds_check (jit, r2, r3, jit_index_shift (op), epos);
+			#endif
+			emit_data_address (jit, r2, r3, jit_index_shift (op));
+			if (op == PULLD || op == PULLDS)
+			{
+				emit_load_regd (jit, XMM0, r1);
+				emit_op_mem (jit, 0xF2, 0, 0x0F11, XMM0, RAX, 0);	// movsd [rax], xmm0
+				break;
+			}
+			emit_load_regi (jit, RCX, r1);
+			switch (op)
+			{
+				case PULLB:
+					emit_op_mem (jit, 0, 0, 0x88, RCX, RAX, 0);		// mov [rax], cl
+					break;
+
+				case PULLW:
+				case PULLWS:
+					emit_op_mem (jit, 0x66, 0, 0x89, RCX, RAX, 0);	// mov [rax], cx
+					break;
+
+				case PULLDW:
+				case PULLDWS:
+					emit_op_mem (jit, 0, 0, 0x89, RCX, RAX, 0);		// mov [rax], ecx
+					break;
+
+				case PULLQW:
+				case PULLQWS:
+					emit_op_mem (jit, 0, 1, 0x89, RCX, RAX, 0);		// mov [rax], rcx
+					break;
+			}
+			break;
+
+		case ADDI:
+		case SUBI:
+		case MULI:
+		case BANDI:
+		case BORI:
+		case BXORI:
+			if (jit->regi_host[r3] && r3 != r2)
+			{
+				// calculate in the host register of r3
+				if (r1 != r3)
+				{
+					emit_load_regi (jit, jit->regi_host[r3], r1);
+				}
+				emit_math_i (jit, op, jit->regi_host[r3], r2);
+				break;
+			}
+			emit_load_regi (jit, RAX, r1);
+			emit_math_i (jit, op, RAX, r2);
+			emit_store_regi (jit, r3, RAX);
+			break;
+
+		case DIVI:
+		case MODI:
+			emit_load_regi (jit, RCX, r2);
+			#if DIVISIONCHECK
+			if (op == DIVI)
+			{
+				// division by zero: let the interpreter report it
+				emit_byte (jit, 0x48); emit_byte (jit, 0x85); emit_byte (jit, 0xC9);	// test rcx, rcx
+				emit_jcc (jit, CC_E, epos, FIX_STUB);
+			}
+			#endif
+			emit_load_regi (jit, RAX, r1);
+			emit_byte (jit, 0x48); emit_byte (jit, 0x99);						// cqo
+			emit_byte (jit, 0x48); emit_byte (jit, 0xF7); emit_byte (jit, 0xF9);	// idiv rcx
+			if (op == DIVI)
+			{
+				emit_store_regi (jit, r3, RAX);
+			}
+			else
+			{
+				emit_store_regi (jit, r3, RDX);
+			}
+			break;
+
+		case SMULI:
+		case SDIVI:
+			emit_load_regi (jit, RAX, r1);
+			emit_load_regi (jit, RCX, r2);
+			emit_byte (jit, 0x48); emit_byte (jit, 0xD3);
+			if (op == SMULI)
+			{
+				emit_byte (jit, 0xE0);		// shl rax, cl
+			}
+			else
+			{
+				emit_byte (jit, 0xF8);		// sar rax, cl
+			}
+			emit_store_regi (jit, r3, RAX);
+			break;
+
+		case ANDI:
+		case ORI:
+			emit_logical_i (jit, op, r1, r2, r3);
+			break;
+
+		case SHLI:
+			emit_load_regi (jit, RAX, r1);
+			emit_byte (jit, 0x48); emit_byte (jit, 0xC1); emit_byte (jit, 0xE0); emit_byte (jit, r2 & 63);	// shl rax, r2
+			emit_store_regi (jit, r3, RAX);
+			break;
+
+		case ADDD:
+		case SUBD:
+		case MULD:
+		case DIVD:
+			#if DIVISIONCHECK
+			if (op == DIVD)
+			{
+				// division by zero: let the interpreter report it
+				emit_byte (jit, 0x66); emit_byte (jit, 0x0F); emit_byte (jit, 0x57); emit_byte (jit, 0xC9);	// xorpd xmm1, xmm1
+				emit_op_regd (jit, 0x66, 0x0F2E, XMM1, r2);		// ucomisd xmm1, regd[r2]
+				emit_byte (jit, 0x7A); emit_byte (jit, 0x06);	// jp over jcc (NaN is not zero)
+				emit_jcc (jit, CC_E, epos, FIX_STUB);
+			}
+			#endif
+			if (jit->regd_host[r3] && r3 != r2)
+			{
+				// calculate in the host register of r3
+				if (r1 != r3)
+				{
+					emit_load_regd (jit, jit->regd_host[r3], r1);
+				}
+				emit_math_d (jit, op, jit->regd_host[r3], r2);
+				break;
+			}
+			emit_load_regd (jit, XMM0, r1);
+			emit_math_d (jit, op, XMM0, r2);
+			emit_store_regd (jit, r3, XMM0);
+			break;
+
+		case EQI: emit_compare_i (jit, CC_E, r1, r2, r3); break;
+		case NEQI: emit_compare_i (jit, CC_NE, r1, r2, r3); break;
+		case GRI: emit_compare_i (jit, CC_G, r1, r2, r3); break;
+		case LSI: emit_compare_i (jit, CC_L, r1, r2, r3); break;
+		case GREQI: emit_compare_i (jit, CC_GE, r1, r2, r3); break;
+		case LSEQI: emit_compare_i (jit, CC_LE, r1, r2, r3); break;
+
+		case EQD:
+		case NEQD:
+		case GRD:
+		case LSD:
+		case GREQD:
+		case LSEQD:
+			emit_compare_d (jit, op, r1, r2, r3);
+			break;
+
+		case JMP:
+			emit_jmp (jit, get_label (code, epos + 1), FIX_BRANCH);
+			break;
+
+		case JMPI:
+			emit_load_regi (jit, RAX, r1);
+			emit_byte (jit, 0x48); emit_byte (jit, 0x85); emit_byte (jit, 0xC0);	// test rax, rax
+			emit_jcc (jit, CC_NE, get_label (code, epos + 2), FIX_BRANCH);
+			break;
+
+		case INCLSIJMPI:
+		case DECGRIJMPI:
+			emit_load_regi (jit, RAX, r1);
+			emit_byte (jit, 0x48); emit_byte (jit, 0x83);
+			if (op == INCLSIJMPI)
+			{
+				emit_byte (jit, 0xC0);		// add rax, 1
+			}
+			else
+			{
+				emit_byte (jit, 0xE8);		// sub rax, 1
+			}
+			emit_byte (jit, 0x01);
+			emit_store_regi (jit, r1, RAX);
+			emit_op_regi (jit, 0x3B, RAX, r2);		// cmp rax, regi[r2]
+			if (op == INCLSIJMPI)
+			{
+				emit_jcc (jit, CC_L, get_label (code, epos + 3), FIX_BRANCH);
+			}
+			else
+			{
+				emit_jcc (jit, CC_G, get_label (code, epos + 3), FIX_BRANCH);
+			}
+			break;
+
+		case LOADA:
+		case LOADD:
+			arg1 = get_label (code, epos + 1);
+			arg2 = get_label (code, epos + 9);
+			#if BOUNDSCHECK
+			// constant address: check it silently now, leave the opcode to the interpreter,
+			// it reports the error if the opcode really runs
+			if (memory_bounds_check (arg1, arg2) != 0)
+			{
+				return (1);
+			}
+			#endif
+			r3 = code[epos + 17];
+			if (arg1 + arg2 >= -2147483647LL && arg1 + arg2 <= 2147483647LL)
+			{
+				if (op == LOADA)
+				{
+					emit_op_mem (jit, 0, 1, 0x8B, RAX, R13, (S4) (arg1 + arg2));
+					emit_store_regi (jit, r3, RAX);
+				}
+				else
+				{
+					emit_op_mem (jit, 0xF2, 0, 0x0F10, XMM0, R13, (S4) (arg1 + arg2));
+					emit_store_regd (jit, r3, XMM0);
+				}
+			}
+			else
+			{
+				return (1);
+			}
+			break;
+
+		case LOAD:
+			arg1 = get_label (code, epos + 1);
+			arg2 = get_label (code, epos + 9);
+			emit_mov_imm (jit, RAX, arg1 + arg2);
+			emit_store_regi (jit, code[epos + 17], RAX);
+			break;
+
+		case LOADL:
+			emit_mov_imm (jit, RAX, get_label (code, epos + 1));
+			emit_store_regi (jit, code[epos + 9], RAX);
+			break;
+
+		case MOVI:
+			emit_load_regi (jit, RAX, r1);
+			emit_store_regi (jit, r2, RAX);
+			break;
+
+		case MOVD:
+			emit_load_regd (jit, XMM0, r1);
+			emit_store_regd (jit, r2, XMM0);
+			break;
+
+		case NOTI:
+			emit_load_regi (jit, RAX, r1);
+			emit_byte (jit, 0x48); emit_byte (jit, 0x85); emit_byte (jit, 0xC0);	// test rax, rax
+			emit_setcc_rax (jit, CC_E);
+			emit_store_regi (jit, r2, RAX);
+			break;
+
+		case JMPA:
+			// indirect jump: continue in interpreter at regi[r1]
+			emit_load_regi (jit, RAX, r1);
+			emit_jmp (jit, 0, FIX_EXIT);
+			break;
+
+		default:
+			return (1);
+	}
+	return (0);
+}
+
+#if JIT_REG_ALLOC
+// count the VM register uses of the opcode at epos
+static void jit_count_regs (U1 *code, S8 epos, S8 *count_i, S8 *count_d)
+{
+	U1 op = code[epos];
+	U1 r1 = code[epos + 1];
+	U1 r2 = code[epos + 2];
+	U1 r3 = code[epos + 3];
+
+	if (jit_native_opcode (op) == 0)
+	{
+		return;
+	}
+
+	switch (op)
+	{
+		case PUSHB:
+		case PUSHW:
+		case PUSHDW:
+		case PUSHQW:
+		case PUSHWS:
+		case PUSHDWS:
+		case PUSHQWS:
+			count_i[r1]++; count_i[r2]++; count_i[r3]++;
+			break;
+
+		case PUSHD:
+		case PUSHDS:
+			count_i[r1]++; count_i[r2]++; count_d[r3]++;
+			break;
+
+		case PULLB:
+		case PULLW:
+		case PULLDW:
+		case PULLQW:
+		case PULLWS:
+		case PULLDWS:
+		case PULLQWS:
+			count_i[r1]++; count_i[r2]++; count_i[r3]++;
+			break;
+
+		case PULLD:
+		case PULLDS:
+			count_d[r1]++; count_i[r2]++; count_i[r3]++;
+			break;
+
+		case ADDD:
+		case SUBD:
+		case MULD:
+		case DIVD:
+			count_d[r1]++; count_d[r2]++; count_d[r3]++;
+			break;
+
+		case EQD:
+		case NEQD:
+		case GRD:
+		case LSD:
+		case GREQD:
+		case LSEQD:
+			count_d[r1]++; count_d[r2]++; count_i[r3]++;
+			break;
+
+		case JMPI:
+		case JMPA:
+			count_i[r1]++;
+			break;
+
+		case INCLSIJMPI:
+		case DECGRIJMPI:
+		case MOVI:
+		case NOTI:
+			count_i[r1]++; count_i[r2]++;
+			break;
+
+		case SHLI:
+			count_i[r1]++; count_i[r3]++;
+			break;
+
+		case MOVD:
+			count_d[r1]++; count_d[r2]++;
+			break;
+
+		case LOADA:
+		case LOAD:
+			count_i[code[epos + 17]]++;
+			break;
+
+		case LOADD:
+			count_d[code[epos + 17]]++;
+			break;
+
+		case LOADL:
+			count_i[code[epos + 9]]++;
+			break;
+
+		case JMP:
+			break;
+
+		default:
+			// integer math, logical and compare opcodes
+			if (op >= ADDI && op <= LSEQI)
+			{
+				count_i[r1]++; count_i[r2]++; count_i[r3]++;
+			}
+			break;
+	}
+}
+
+// select the most used VM registers of the code range for the host registers
+static void jit_select_regs (U1 *regs_host, S8 *count, const U1 *host, S2 host_regs)
+{
+	S2 i, j, max;
+
+	for (j = 0; j < host_regs; j++)
+	{
+		max = -1;
+		for (i = 0; i < MAXREG; i++)
+		{
+			if (regs_host[i] == 0 && count[i] >= JIT_REG_ALLOC_MIN && (max == -1 || count[i] > count[max]))
+			{
+				max = i;
+			}
+		}
+		if (max == -1)
+		{
+			break;
+		}
+		regs_host[max] = host[j];
+	}
+}
+
+static void jit_alloc_regs (struct jit_buf *jit, U1 *code, S8 code_size, S8 start, S8 end)
+{
+	S8 count_i[MAXREG];
+	S8 count_d[MAXREG];
+	S8 epos ALIGN;
+	S8 size ALIGN;
+
+	memset (count_i, 0, sizeof (count_i));
+	memset (count_d, 0, sizeof (count_d));
+
+	for (epos = start; epos <= end; epos = epos + size)
+	{
+		size = jit_opcode_size (code[epos]);
+		if (size == 0 || epos + size > code_size)
+		{
+			// jit_compiler reports the error
+			return;
+		}
+		jit_count_regs (code, epos, count_i, count_d);
+	}
+
+	jit_select_regs (jit->regi_host, count_i, jit_regi_alloc, sizeof (jit_regi_alloc));
+	jit_select_regs (jit->regd_host, count_d, jit_regd_alloc, sizeof (jit_regd_alloc));
+}
+#endif
+
+#if JIT_CACHE && __linux__ && defined(__x86_64__)
+// the native code only uses relative jumps and gets all addresses by the jit_context,
+// so it can be saved and mapped in again at any address
+
+static int jit_find_build_id (struct dl_phdr_info *info, size_t size, void *arg)
+{
+	// the first object is the VM executable: hash of its NT_GNU_BUILD_ID note
+	S8 *build_id = (S8 *) arg;
+	ElfW(Nhdr) *note;
+	U1 *pos;
+	U1 *end;
+	S4 i;
+
+	for (i = 0; i < info->dlpi_phnum; i++)
+	{
+		if (info->dlpi_phdr[i].p_type != PT_NOTE)
+		{
+			continue;
+		}
+
+		pos = (U1 *) (info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+		end = pos + info->dlpi_phdr[i].p_memsz;
+		while (pos + sizeof (ElfW(Nhdr)) <= end)
+		{
+			note = (ElfW(Nhdr) *) pos;
+			pos += sizeof (ElfW(Nhdr));
+			if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && memcmp (pos, "GNU", 4) == 0)
+			{
+				*build_id = code_hash (pos + 4, 0, note->n_descsz);
+				return (1);
+			}
+			pos += ((note->n_namesz + 3) & ~3) + ((note->n_descsz + 3) & ~3);
+		}
+	}
+	return (1);
+}
+
+static S8 jit_cache_build (void)
+{
+	// cache files of an other VM build or other check settings are not used, 0 = no build-id
+	S8 build[9] ALIGN;
+
+	build[0] = 0;
+	dl_iterate_phdr (jit_find_build_id, &build[0]);
+	if (build[0] == 0)
+	{
+		return (0);
+	}
+
+	build[1] = JIT_CACHE_VERSION;
+	build[2] = (S8) sizeof (struct jit_context);
+	build[3] = BOUNDSCHECK;
+	build[4] = DIVISIONCHECK;
+	build[5] = MATH_LIMITS;
+	build[6] = MATH_LIMITS_DOUBLE_FULL;
+	build[7] = JIT_REG_ALLOC;
+	build[8] = JIT_REG_ALLOC_MIN;
+	return (code_hash ((U1 *) build, 0, sizeof (build)));
+}
+
+static S8 jit_cache_data (void)
+{
+	// hash of the data_info table: offset, size and type of every variable
+	unsigned long long hash = 14695981039346656037ULL;
+	S8 layout[4] ALIGN;
+	S8 i ALIGN;
+
+	for (i = 0; i <= data_info_ind; i++)
+	{
+		layout[0] = data_info[i].offset;
+		layout[1] = data_info[i].size;
+		layout[2] = data_info[i].type_size;
+		layout[3] = data_info[i].type;
+		hash = (hash * 1099511628211ULL) ^ (unsigned long long) code_hash ((U1 *) layout, 0, sizeof (layout));
+	}
+	return ((S8) hash);
+}
+
+static S2 jit_cache_name (U1 *name, S8 hash)
+{
+	char *home;
+
+	home = get_home ();
+	if (home == NULL || strlen (home) + 64 > 511)
+	{
+		return (1);
+	}
+	snprintf ((char *) name, 512, "%s%s%s%016llx.l1jit", home, SANDBOX_ROOT, JIT_CACHE_DIR, (unsigned long long) hash);
+	return (0);
+}
+
+static S2 jit_cache_fill_header (struct jit_cache_header *header, U1 *code, S8 code_size, S8 start, S8 end, S8 exit_ep)
+{
+	S8 hash_end ALIGN;
+
+	// the opcode at end is included
+	hash_end = end + jit_opcode_size (code[end]);
+	if (hash_end > code_size)
+	{
+		hash_end = code_size;
+	}
+
+	memset (header, 0, sizeof (struct jit_cache_header));
+	header->magic = JIT_CACHE_MAGIC;
+	header->build = jit_cache_build ();
+	header->data = jit_cache_data ();
+	header->hash = code_hash (code, start, hash_end);
+	header->start = start;
+	header->end = end;
+	header->exit_ep = exit_ep;
+
+	if (header->build == 0)
+	{
+		// unknown VM build: no cache
+		return (1);
+	}
+	return (0);
+}
+
+static S8 jit_cache_key (struct jit_cache_header *header)
+{
+	return (code_hash ((U1 *) header, 0, sizeof (struct jit_cache_header)));
+}
+
+static S2 jit_cache_load (U1 *code, S8 code_size, S8 start, S8 end, S8 exit_ep, struct JIT_code *JIT_code)
+{
+	// map the native code of the cache file in, if there is one for this code range
+	struct jit_cache_header header;
+	struct jit_cache_header file_header;
+	struct stat st;
+	U1 name[512];
+	U1 *mem;
+	int fd;
+
+	if (jit_cache_fill_header (&header, code, code_size, start, end, exit_ep) != 0 || jit_cache_name (name, jit_cache_key (&header)) != 0)
+	{
+		return (1);
+	}
+
+	fd = open ((const char *) name, O_RDONLY);
+	if (fd < 0)
+	{
+		return (1);
+	}
+
+	if (fstat (fd, &st) != 0 || read (fd, &file_header, sizeof (struct jit_cache_header)) != sizeof (struct jit_cache_header))
+	{
+		close (fd);
+		return (1);
+	}
+
+	header.size = file_header.size;
+	if (memcmp (&header, &file_header, sizeof (struct jit_cache_header)) != 0 || st.st_size != JIT_CACHE_HEADER + file_header.size)
+	{
+		close (fd);
+		return (1);
+	}
+
+	mem = mmap (NULL, st.st_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (mem == MAP_FAILED)
+	{
+		// maybe a noexec file system
+		return (1);
+	}
+
+	JIT_code->mem = mem;
+	JIT_code->mem_size = st.st_size;
+	JIT_code->start = start;
+	JIT_code->end = end;
+	JIT_code->fn = (Func) (mem + JIT_CACHE_HEADER);
+	return (0);
+}
+
+static void jit_cache_save (U1 *code, S8 code_size, S8 start, S8 end, S8 exit_ep, U1 *native, S8 size)
+{
+	// write to a temporary file first, so other VMs never see a half written file
+	struct jit_cache_header header;
+	U1 dir[512];
+	U1 name[512];
+	U1 tmp_name[600];
+	FILE *fptr;
+	char *home;
+	S2 ok;
+
+	home = get_home ();
+	if (home == NULL || strlen (home) + 64 > 511)
+	{
+		return;
+	}
+	snprintf ((char *) dir, 512, "%s%s%s", home, SANDBOX_ROOT, JIT_CACHE_DIR);
+	mkdir ((const char *) dir, 0700);
+
+	if (jit_cache_fill_header (&header, code, code_size, start, end, exit_ep) != 0 || jit_cache_name (name, jit_cache_key (&header)) != 0)
+	{
+		return;
+	}
+	header.size = size;
+
+	snprintf ((char *) tmp_name, 600, "%s.%i", name, (int) getpid ());
+	fptr = fopen ((const char *) tmp_name, "w");
+	if (fptr == NULL)
+	{
+		return;
+	}
+
+	ok = fwrite (&header, sizeof (struct jit_cache_header), 1, fptr) == 1 && fwrite (native, size, 1, fptr) == 1;
+	if (fclose (fptr) != 0 || ! ok || rename ((const char *) tmp_name, (const char *) name) != 0)
+	{
+		unlink ((const char *) tmp_name);
+	}
+}
+#endif
+
+// compile code range start to end, the opcode at end is included
+// exit_ep is returned if the end of the code range is reached
+S2 jit_compiler (U1 *code, S8 code_size, S8 start, S8 end, S8 exit_ep, struct JIT_code *JIT_code)
+{
+#if __linux__ && defined(__x86_64__)
+	struct jit_buf jit;
+	S8 *native_offs = NULL;
+	S8 range ALIGN;
+	S8 epos ALIGN;
+	S8 size ALIGN;
+	S8 exit_pos ALIGN;
+	S8 stub_pos ALIGN;
+	S8 rel ALIGN;
+	S8 i ALIGN;
+	S4 rel32;
+	U1 *mem;
+
+	if (start < 16 || end < start || end >= code_size)
+	{
+		printf ("jit_compiler: ERROR: code range %lli - %lli out of code!\n", start, end);
+		return (1);
+	}
+
+	#if JIT_CACHE
+	if (jit_cache_load (code, code_size, start, end, exit_ep, JIT_code) == 0)
+	{
+		#if PERF_MAP && PROFILE
+		perf_jit_code ((U1 *) JIT_code->fn, JIT_code->mem_size - JIT_CACHE_HEADER, start, end);
+		#endif
+		return (0);
+	}
+	#endif
+
+	range = end - start + 1;
+	native_offs = (S8 *) calloc (range, sizeof (S8));
+	if (native_offs == NULL)
+	{
+		printf ("jit_compiler: ERROR: can't allocate offset table!\n");
+		return (1);
+	}
+	for (i = 0; i < range; i++)
+	{
+		native_offs[i] = -1;
+	}
+
+	jit.size = range * 16 + 256;
+	jit.pos = 0;
+	jit.error = 0;
+	jit.buf = (U1 *) malloc (jit.size);
+	jit.fixup_size = 256;
+	jit.fixup_ind = -1;
+	jit.fixup = (struct jit_fixup *) malloc (jit.fixup_size * sizeof (struct jit_fixup));
+	if (jit.buf == NULL || jit.fixup == NULL)
+	{
+		printf ("jit_compiler: ERROR: can't allocate code buffer!\n");
+		if (jit.buf) free (jit.buf);
+		if (jit.fixup) free (jit.fixup);
+		free (native_offs);
+		return (1);
+	}
+
+	memset (jit.regi_host, 0, sizeof (jit.regi_host));
+	memset (jit.regd_host, 0, sizeof (jit.regd_host));
+	#if JIT_REG_ALLOC
+	jit_alloc_regs (&jit, code, code_size, start, end);
+	#endif
+
+	emit_prologue (&jit);
+	emit_reload_regs (&jit, 0);
+
+	for (epos = start; epos <= end; epos = epos + size)
+	{
+		size = jit_opcode_size (code[epos]);
+		if (size == 0 || epos + size > code_size)
+		{
+			printf ("jit_compiler: ERROR: unknown opcode %i at epos: %lli!\n", code[epos], epos);
+			jit.error = 1;
+			break;
+		}
+
+		native_offs[epos - start] = jit.pos;
+		if (emit_opcode_vm (&jit, code, epos) != 0)
+		{
+			// not compiled: run this opcode in the interpreter
+			emit_exit (&jit, epos);
+		}
+	}
+
+	// end of code range reached
+	emit_exit (&jit, exit_ep);
+
+	exit_pos = jit.pos;
+	emit_spill_regs (&jit, 0);
+	emit_epilogue (&jit);
+
+	// resolve jumps
+	for (i = 0; i <= jit.fixup_ind && ! jit.error; i++)
+	{
+		if (jit.fixup[i].type == FIX_EXIT)
+		{
+			rel = exit_pos;
+		}
+		else
+		{
+			if (jit.fixup[i].type == FIX_BRANCH && jit.fixup[i].target >= start && jit.fixup[i].target <= end && native_offs[jit.fixup[i].target - start] != -1)
+			{
+				rel = native_offs[jit.fixup[i].target - start];
+			}
+			else
+			{
+				// jump target outside of code range or FIX_STUB: exit to interpreter
+				stub_pos = jit.pos;
+				emit_mov_imm (&jit, RAX, jit.fixup[i].target);
+				emit_byte (&jit, 0xE9);
+				emit_s4 (&jit, (S4) (exit_pos - (jit.pos + 4)));
+				rel = stub_pos;
+			}
+		}
+
+		if (jit.error) break;
+
+		rel32 = (S4) (rel - (jit.fixup[i].pos + 4));
+		memcpy (&jit.buf[jit.fixup[i].pos], &rel32, sizeof (S4));
+	}
+
+	free (native_offs);
+	free (jit.fixup);
+
+	if (jit.error)
+	{
+		free (jit.buf);
+		return (1);
+	}
+
+	#if JIT_CACHE
+	jit_cache_save (code, code_size, start, end, exit_ep, jit.buf, jit.pos);
+	#endif
+
+	// copy to executable memory
+	mem = mmap (NULL, jit.pos, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+	{
+		printf ("jit_compiler: ERROR: can't allocate executable memory!\n");
+		free (jit.buf);
+		return (1);
+	}
+	memcpy (mem, jit.buf, jit.pos);
+	free (jit.buf);
+
+	if (mprotect (mem, jit.pos, PROT_READ | PROT_EXEC) != 0)
+	{
+		printf ("jit_compiler: ERROR: can't set executable memory!\n");
+		munmap (mem, jit.pos);
+		return (1);
+	}
+
+	JIT_code->mem = mem;
+	JIT_code->mem_size = jit.pos;
+	JIT_code->start = start;
+	JIT_code->end = end;
+	JIT_code->fn = (Func) mem;
+
+	#if PERF_MAP && PROFILE
+	perf_jit_code (mem, jit.pos, start, end);
+	#endif
+	return (0);
+#else
+	printf ("jit_compiler: ERROR: JIT compiler only on x86-64 Linux!\n");
+	return (1);
+#endif
+}
+
+S8 run_jit (S8 code, struct JIT_code *JIT_code, S8 JIT_code_ind, struct jit_context *ctx)
+{
+	if (code < 0 || code > JIT_code_ind || JIT_code[code].fn == NULL)
+	{
+		printf ("run_jit: ERROR: JIT code %lli not compiled!\n", code);
+		ctx->error_ep = -1;
+		return (JIT_EXIT_ERROR);
+	}
+
+	return ((*JIT_code[code].fn)(ctx));
+}
+
+void free_jit_code (struct JIT_code *JIT_code, S8 JIT_code_ind)
+{
+	S8 i ALIGN;
+
+	for (i = 0; i <= JIT_code_ind; i++)
+	{
+		#if __linux__
+		if (JIT_code[i].mem)
+		{
+			munmap (JIT_code[i].mem, JIT_code[i].mem_size);
+		}
+		#endif
+		JIT_code[i].mem = NULL;
+		JIT_code[i].mem_size = 0;
+		JIT_code[i].fn = NULL;
+	}
+}
+
+void get_jit_compiler_type (void)
+{
+	printf ("JIT-compiler inside: x86-64 baseline.\n");
+}
@@ -26,3 +26,31 @@
 
 #define MAXJITCODE 40960
 #define MAXJUMPLEN 40960
+
+// return values of the JIT code, a value >= 0 is the epos to continue in the interpreter
+#define JIT_EXIT_END		-1		// end of code range reached
+#define JIT_EXIT_ERROR		-2		// memory bounds error at jit_context.error_ep
+
+// compile loops automatically when they get hot:
+// the interpreter counts the backward jumps (jmp, jmpi, inclsijmpi, decgrijmpi) to every target
+// and compiles the code from the target to the jump if JIT_HOT_THRESHOLD is reached
+#define JIT_HOT_LOOPS		1
+#define JIT_HOT_THRESHOLD	1000
+
+#define JIT_HOT_NONE		-1		// loop not compiled yet
+#define JIT_HOT_FAILED		-2		// loop can't be compiled
+#define JIT_HOT_INTERPRET	-3		// jit_hot_loop: do the jump in the interpreter
+
+// keep the most used VM registers of a code range in host registers
+// they are loaded on entry and stored back on exit and around memory_bounds calls
+#define JIT_REG_ALLOC		1
+#define JIT_REG_ALLOC_MIN	2		// minimal number of uses in the code range
+
+// save compiled code ranges in $HOME/l1vm/jitcache/ and map them in on the next run
+// the cache file name is a hash of the code range, the range positions, the data layout,
+// the check settings and the ELF build-id of the VM: without a build-id the cache is not used
+#define JIT_CACHE			1
+#define JIT_CACHE_VERSION	2				// cache file format
+#define JIT_CACHE_DIR		"jitcache/"		// in SANDBOX_ROOT
+#define JIT_CACHE_MAGIC		0x4C314A4954430001LL
+#define JIT_CACHE_HEADER	64				// bytes before the native code in the cache file
@@ -21,6 +21,10 @@
 #include "../include/opcodes.h"
 #include "../include/home.h"
 
+#if __linux__
+#include <sys/mman.h>
+#endif
+
 extern U1 *code;
 extern U1 *data;
 extern struct data_info data_info[MAXDATAINFO];
@@ -29,6 +33,11 @@ extern S8 data_info_ind ALIGN;
 extern S8 data_size ALIGN;
 extern S8 code_size ALIGN;
 extern S8 data_mem_size ALIGN;
+extern S8 data_mem_reserved ALIGN;
+extern S8 code_mem_reserved ALIGN;
+
+// "-H" flag: huge pages for code and data
+extern U1 huge_pages;
 extern S8 stack_size ALIGN;
 
 // see global.h user settings on top
@@ -41,8 +50,323 @@ extern S8 max_cpu;
 
 extern U1 silent_run;
 
+#if AOT_LOAD && __linux__
+extern Func *aot_entry;
+extern void *aot_lib;
+
+S8 code_hash (U1 *code, S8 start, S8 end);
+#endif
+
+// block size for reading byte data from object file
+#define DATA_LOAD_BLOCK			4096
+
+// huge pages
+#define HUGE_PAGE_SIZE			2097152LL		// 2 MB
+#define HUGE_NONE				0
+#define HUGE_TRANSPARENT		1
+#define HUGE_EXPLICIT			2
+
+U1 code_huge_type = HUGE_NONE;
+U1 data_huge_type = HUGE_NONE;
+
+// data layout as loaded from the object file, without the grow_data_mem entries
+S8 data_info_ind_loaded ALIGN = -1;
+S8 data_mem_size_loaded ALIGN = 0;
+
 size_t strlen_safe (const char * str, int maxlen);
 
+#if __linux__
+U1 *alloc_hugetlb_mem (S8 size ALIGN, S8 *reserved)
+{
+	// explicit huge pages from the hugetlbfs pool, see /proc/sys/vm/nr_hugepages
+	U1 *ptr;
+
+	*reserved = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+	ptr = mmap (NULL, *reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (ptr == MAP_FAILED)
+	{
+		return (NULL);
+	}
+	return (ptr);
+}
+
+S8 get_huge_pages_kb (U1 *ptr)
+{
+	// get size of transparent huge pages of the mapping at ptr from /proc/self/smaps
+	FILE *fptr;
+	U1 rbuf[MAXLINELEN + 1];
+	unsigned long long start, end;
+	S8 kb ALIGN = 0;
+	U1 found = 0;
+
+	fptr = fopen ("/proc/self/smaps", "r");
+	if (fptr == NULL)
+	{
+		return (-1);
+	}
+
+	while (fgets ((char *) rbuf, MAXLINELEN, fptr) != NULL)
+	{
+		if (sscanf ((const char *) rbuf, "%llx-%llx", &start, &end) == 2 && strchr ((const char *) rbuf, ':') != NULL && rbuf[0] != ' ')
+		{
+			if (found == 1)
+			{
+				break;
+			}
+			if ((unsigned long long) ptr >= start && (unsigned long long) ptr < end)
+			{
+				found = 1;
+			}
+			continue;
+		}
+
+		if (found == 1 && strncmp ((const char *) rbuf, "AnonHugePages:", 14) == 0)
+		{
+			sscanf ((const char *) &rbuf[14], "%lli", &kb);
+		}
+	}
+	fclose (fptr);
+	return (kb);
+}
+#endif
+
+void show_huge_pages (void)
+{
+	// "-H" flag: report if the code and data segments got huge pages
+#if __linux__ && DATA_MMAP
+	if (code_huge_type == HUGE_EXPLICIT)
+	{
+		printf ("huge pages: code: explicit huge pages\n");
+	}
+	else
+	{
+		printf ("huge pages: code: transparent huge pages: %lli KB\n", get_huge_pages_kb (code));
+	}
+
+	if (data_huge_type == HUGE_EXPLICIT)
+	{
+		printf ("huge pages: data: explicit huge pages\n");
+	}
+	else
+	{
+		printf ("huge pages: data: transparent huge pages: %lli KB\n", get_huge_pages_kb (data));
+	}
+#else
+	printf ("huge pages: not supported on this system!\n");
+#endif
+}
+
+U1 *alloc_code_mem (S8 size ALIGN, S8 *reserved)
+{
+	// code segment: normal heap memory, with "-H" flag huge pages if possible
+	// reserved = 0: memory from calloc
+	U1 *ptr;
+
+	*reserved = 0;
+#if __linux__ && DATA_MMAP
+	if (huge_pages == 1)
+	{
+		ptr = alloc_hugetlb_mem (size, reserved);
+		if (ptr != NULL)
+		{
+			code_huge_type = HUGE_EXPLICIT;
+			return (ptr);
+		}
+
+		*reserved = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+		ptr = mmap (NULL, *reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+		{
+			return (NULL);
+		}
+		madvise (ptr, *reserved, MADV_HUGEPAGE);
+		code_huge_type = HUGE_TRANSPARENT;
+		return (ptr);
+	}
+#endif
+	ptr = (U1 *) calloc (size, sizeof (U1));
+	return (ptr);
+}
+
+void free_code_mem (U1 *ptr, S8 reserved ALIGN)
+{
+#if __linux__ && DATA_MMAP
+	if (reserved != 0)
+	{
+		munmap (ptr, reserved);
+		return;
+	}
+#endif
+	free (ptr);
+}
+
+U1 *alloc_data_mem (S8 size ALIGN, S8 *reserved)
+{
+	// data segment: on Linux anonymous mmap, the zero pages are only mapped in on first access
+	// The address space up to max_data_size is reserved, so the segment can grow without moving (grow_data_mem).
+	U1 *ptr;
+
+#if __linux__ && DATA_MMAP
+	if (huge_pages == 1)
+	{
+		// explicit huge pages can't be reserved for growing, the data segment has fixed size then
+		ptr = alloc_hugetlb_mem (size, reserved);
+		if (ptr != NULL)
+		{
+			data_huge_type = HUGE_EXPLICIT;
+			return (ptr);
+		}
+	}
+
+	*reserved = max_data_size;
+	if (*reserved < size)
+	{
+		*reserved = size;
+	}
+
+	ptr = mmap (NULL, *reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (ptr == MAP_FAILED)
+	{
+		// not enough address space, map data segment without room to grow
+		*reserved = size;
+		ptr = mmap (NULL, *reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (ptr == MAP_FAILED)
+		{
+			return (NULL);
+		}
+	}
+
+	if (mprotect (ptr, size, PROT_READ | PROT_WRITE) != 0)
+	{
+		munmap (ptr, *reserved);
+		return (NULL);
+	}
+
+	#if DATA_HUGEPAGE_MIN_SIZE
+	if (size >= DATA_HUGEPAGE_MIN_SIZE)
+	{
+		// big data segment: ask for transparent huge pages, fails silently if not available
+		madvise (ptr, size, MADV_HUGEPAGE);
+		data_huge_type = HUGE_TRANSPARENT;
+	}
+	#endif
+
+	if (huge_pages == 1)
+	{
+		madvise (ptr, size, MADV_HUGEPAGE);
+		data_huge_type = HUGE_TRANSPARENT;
+	}
+#else
+	*reserved = size;
+	ptr = (U1 *) calloc (size, sizeof (U1));
+#endif
+	return (ptr);
+}
+
+void free_data_mem (U1 *ptr, S8 reserved ALIGN)
+{
+#if __linux__ && DATA_MMAP
+	munmap (ptr, reserved);
+#else
+	free (ptr);
+#endif
+}
+
+S8 grow_data_mem (S8 size ALIGN, U1 type)
+{
+	// add a new variable of size bytes at the end of the data segment
+	// returns the address of the new variable, or -1 on error
+	S8 offset ALIGN;
+	S8 type_size ALIGN;
+
+#if __linux__ && DATA_MMAP
+	S8 page_size ALIGN;
+	S8 page_start ALIGN;
+	S8 page_end ALIGN;
+
+	switch (type)
+	{
+		case BYTE:
+			type_size = sizeof (U1);
+			break;
+
+		case WORD:
+			type_size = sizeof (S2);
+			break;
+
+		case DOUBLEWORD:
+			type_size = sizeof (S4);
+			break;
+
+		case QUADWORD:
+		case DOUBLEFLOAT:
+			type_size = sizeof (S8);
+			break;
+
+		default:
+			printf ("grow_data_mem: ERROR: unknown data type: %i!\n", type);
+			return (-1);
+	}
+
+	if (size <= 0 || size % type_size != 0)
+	{
+		printf ("grow_data_mem: ERROR: size %lli not a multiple of type size!\n", size);
+		return (-1);
+	}
+
+	if (data_info_ind >= MAXDATAINFO - 1)
+	{
+		printf ("grow_data_mem: ERROR: data info list full!\n");
+		return (-1);
+	}
+
+	// 64 bit alignment
+	offset = (data_mem_size + 7) & ~7LL;
+	if (offset + size > data_mem_reserved)
+	{
+		printf ("grow_data_mem: ERROR: out of data memory, size: %lli, max: %lli!\n", size, data_mem_reserved);
+		return (-1);
+	}
+
+	page_size = sysconf (_SC_PAGESIZE);
+	page_start = offset & ~(page_size - 1);
+	page_end = (offset + size + page_size - 1) & ~(page_size - 1);
+
+	if (mprotect (data + page_start, page_end - page_start, PROT_READ | PROT_WRITE) != 0)
+	{
+		printf ("grow_data_mem: ERROR: can't map %lli bytes!\n", size);
+		return (-1);
+	}
+
+	#if DATA_HUGEPAGE_MIN_SIZE
+	if (size >= DATA_HUGEPAGE_MIN_SIZE)
+	{
+		madvise (data + page_start, page_end - page_start, MADV_HUGEPAGE);
+	}
+	#endif
+
+	if (huge_pages == 1)
+	{
+		madvise (data + page_start, page_end - page_start, MADV_HUGEPAGE);
+	}
+
+	// new variable for memory_bounds ()
+	data_info[data_info_ind + 1].name[0] = '\0';
+	data_info[data_info_ind + 1].type = type;
+	data_info[data_info_ind + 1].type_size = type_size;
+	data_info[data_info_ind + 1].offset = offset;
+	data_info[data_info_ind + 1].size = size;
+	data_info[data_info_ind + 1].end = offset + size - 1;
+	data_info_ind++;
+
+	data_mem_size = offset + size;
+	return (offset);
+#else
+	printf ("grow_data_mem: ERROR: data segment can't grow on this system!\n");
+	return (-1);
+#endif
+}
+
 S2 conv_word (S2 val)
 {
 	S2 ret;
@@ -164,8 +488,10 @@ S2 load_object (U1 *name)
 	S8 i ALIGN;
 	S8 j ALIGN;
 	S8 k ALIGN;
+	S8 l ALIGN;
 
 	U1 *bptr;
+	U1 load_block[DATA_LOAD_BLOCK];
 
 	// bzip compressed file flag
 	U1 bzip2 = 0;
@@ -344,7 +670,7 @@ S2 load_object (U1 *name)
 		return (1);
 	}
 
-	code = (U1 *) calloc (code_size, sizeof (U1));
+	code = alloc_code_mem (code_size, &code_mem_reserved);
 	if (code == NULL)
 	{
 		printf ("ERROR: can't allocate %lli bytes for code!\n", code_size);
@@ -700,7 +1026,10 @@ S2 load_object (U1 *name)
 		return (1);
 	}
 
-	data = (U1 *) calloc (data_mem_size, sizeof (U1));
+	data_info_ind_loaded = data_info_ind;
+	data_mem_size_loaded = data_mem_size;
+
+	data = alloc_data_mem (data_mem_size, &data_mem_reserved);
 	if (data == NULL)
 	{
 		printf ("ERROR: can't allocate %lli bytes for data!\n", data_mem_size);
@@ -725,10 +1054,16 @@ S2 load_object (U1 *name)
 
 				// printf ("load_object: BYTE: size: %lli\n", data_info[j].size);
 
-				for (k = 1; k <= data_info[j].size; k++)
+				// read byte data in blocks, blocks of zeroes are not copied: the data memory is zero already
+				for (k = 0; k < data_info[j].size; k = k + readsize)
 				{
-					readsize = fread (&byte, sizeof (U1), 1, fptr);
-					if (readsize != 1)
+					readsize = data_info[j].size - k;
+					if (readsize > DATA_LOAD_BLOCK)
+					{
+						readsize = DATA_LOAD_BLOCK;
+					}
+
+					if (fread (load_block, sizeof (U1), readsize, fptr) != readsize)
 					{
 						printf ("error: can't load data: BYTE!\n");
 						fclose (fptr);
@@ -739,8 +1074,15 @@ S2 load_object (U1 *name)
 						return (1);
 					}
 
-					data[i] = byte;
-					i++;
+					for (l = 0; l < readsize; l++)
+					{
+						if (load_block[l] != 0)
+						{
+							memcpy (&data[i], load_block, readsize);
+							break;
+						}
+					}
+					i = i + readsize;
 				}
 				data_info[j].end = i - 1;
 				data_info[j].type_size = sizeof (U1);
@@ -764,6 +1106,11 @@ S2 load_object (U1 *name)
 					}
 
 					word = conv_word (word);
+					if (word == 0)
+					{
+						i = i + sizeof (S2);
+						continue;
+					}
 
 					bptr = (U1 *) &word;
 
@@ -794,6 +1141,11 @@ S2 load_object (U1 *name)
 					}
 
 					doubleword = conv_doubleword (doubleword);
+					if (doubleword == 0)
+					{
+						i = i + sizeof (S4);
+						continue;
+					}
 
 					bptr = (U1* ) &doubleword;
 
@@ -828,6 +1180,11 @@ S2 load_object (U1 *name)
 					}
 
 					quadword = conv_quadword (quadword);
+					if (quadword == 0)
+					{
+						i = i + sizeof (S8);
+						continue;
+					}
 
 					//printf ("load_object: QUADWORD: %lli\n", quadword);
 
@@ -862,3 +1219,302 @@ S2 load_object (U1 *name)
 	}
 	return (0);
 }
+
+S2 load_data_names (U1 *name)
+{
+	// read the data variable names from the .data section of the assembly file next to the object
+	FILE *fptr;
+	U1 asmname[512];
+	U1 rbuf[MAXLINELEN + 1];
+	S8 data_ind ALIGN = -1;
+	S8 i ALIGN;
+	S8 j ALIGN;
+	U1 comma;
+	U1 data_block = 0;
+
+	if (strlen_safe ((const char *) name, MAXLINELEN) > 505)
+	{
+		return (1);
+	}
+
+	strcpy ((char *) asmname, (const char *) name);
+	strcat ((char *) asmname, ".l1asm");
+
+	fptr = fopen ((const char *) asmname, "r");
+	if (fptr == NULL)
+	{
+		return (1);
+	}
+
+	while (fgets ((char *) rbuf, MAXLINELEN, fptr) != NULL)
+	{
+		i = 0;
+		while (rbuf[i] == ' ' || rbuf[i] == '\t')
+		{
+			i++;
+		}
+
+		if (strncmp ((const char *) &rbuf[i], ".data", 5) == 0)
+		{
+			data_block = 1;
+			continue;
+		}
+		if (strncmp ((const char *) &rbuf[i], ".dend", 5) == 0)
+		{
+			break;
+		}
+		if (data_block == 0)
+		{
+			continue;
+		}
+
+		// variable definition: "Q, 1, name"
+		if ((rbuf[i] == 'B' || rbuf[i] == 'W' || rbuf[i] == 'D' || rbuf[i] == 'Q' || rbuf[i] == 'F') && rbuf[i + 1] == ',')
+		{
+			data_ind++;
+			if (data_ind > data_info_ind)
+			{
+				break;
+			}
+
+			// skip to name after second comma
+			comma = 0;
+			while (rbuf[i] != '\0' && comma < 2)
+			{
+				if (rbuf[i] == ',')
+				{
+					comma++;
+				}
+				i++;
+			}
+			while (rbuf[i] == ' ' || rbuf[i] == '\t')
+			{
+				i++;
+			}
+
+			j = 0;
+			while (rbuf[i] != '\0' && rbuf[i] != ' ' && rbuf[i] != '\t' && rbuf[i] != ',' && rbuf[i] != '\n' && rbuf[i] != '\r' && j < MAXLINELEN - 1)
+			{
+				data_info[data_ind].name[j] = rbuf[i];
+				i++; j++;
+			}
+			data_info[data_ind].name[j] = '\0';
+		}
+	}
+	fclose (fptr);
+	return (0);
+}
+
+S2 reload_object (U1 *name)
+{
+	// hot code reload: load the new object, keep the running data segment if the data layout is compatible
+	U1 *old_code = code;
+	U1 *old_data = data;
+	S8 old_code_size ALIGN = code_size;
+	S8 old_code_mem_reserved ALIGN = code_mem_reserved;
+	S8 old_data_size ALIGN = data_size;
+	S8 old_data_mem_size ALIGN = data_mem_size;
+	S8 old_data_mem_reserved ALIGN = data_mem_reserved;
+	S8 old_data_info_ind ALIGN = data_info_ind;
+	S8 old_data_info_ind_loaded ALIGN = data_info_ind_loaded;
+	S8 old_data_mem_size_loaded ALIGN = data_mem_size_loaded;
+	struct data_info *old_data_info;
+	S8 i ALIGN;
+	U1 compatible = 1;
+
+	old_data_info = (struct data_info *) calloc (old_data_info_ind + 1, sizeof (struct data_info));
+	if (old_data_info == NULL)
+	{
+		printf ("reload_object: ERROR: can't allocate data info backup!\n");
+		return (1);
+	}
+	memcpy (old_data_info, data_info, (old_data_info_ind + 1) * sizeof (struct data_info));
+
+	data_info_ind = -1;
+	for (i = 0; i <= old_data_info_ind; i++)
+	{
+		data_info[i].name[0] = '\0';
+	}
+
+	if (load_object (name) != 0)
+	{
+		compatible = 0;
+		code = NULL;
+		data = NULL;
+	}
+	else
+	{
+		load_data_names (name);
+
+		// only the object file entries must match, the grown entries are kept
+		if (data_info_ind != old_data_info_ind_loaded || data_mem_size != old_data_mem_size_loaded)
+		{
+			printf ("reload_object: ERROR: data segment size changed!\n");
+			compatible = 0;
+		}
+
+		for (i = 0; compatible == 1 && i <= data_info_ind; i++)
+		{
+			if (data_info[i].type != old_data_info[i].type || data_info[i].size != old_data_info[i].size)
+			{
+				printf ("reload_object: ERROR: data variable %lli type or size changed!\n", i);
+				compatible = 0;
+			}
+
+			// names are only known if the .l1asm file was found both times
+			if (data_info[i].name[0] != '\0' && old_data_info[i].name[0] != '\0')
+			{
+				if (strcmp ((const char *) data_info[i].name, (const char *) old_data_info[i].name) != 0)
+				{
+					printf ("reload_object: ERROR: data variable '%s' renamed to '%s'!\n", old_data_info[i].name, data_info[i].name);
+					compatible = 0;
+				}
+			}
+		}
+	}
+
+	if (compatible == 0)
+	{
+		// keep running the old object
+		if (code) free_code_mem (code, code_mem_reserved);
+		if (data) free_data_mem (data, data_mem_reserved);
+
+		code = old_code;
+		data = old_data;
+		code_size = old_code_size;
+		code_mem_reserved = old_code_mem_reserved;
+		data_size = old_data_size;
+		data_mem_size = old_data_mem_size;
+		data_mem_reserved = old_data_mem_reserved;
+		data_info_ind = old_data_info_ind;
+		data_info_ind_loaded = old_data_info_ind_loaded;
+		data_mem_size_loaded = old_data_mem_size_loaded;
+		memcpy (data_info, old_data_info, (old_data_info_ind + 1) * sizeof (struct data_info));
+		free (old_data_info);
+		return (1);
+	}
+
+	// new code, old data: keep the entries added by grow_data_mem
+	for (i = data_info_ind + 1; i <= old_data_info_ind; i++)
+	{
+		data_info[i] = old_data_info[i];
+	}
+	data_info_ind = old_data_info_ind;
+	data_mem_size = old_data_mem_size;
+
+	free_data_mem (data, data_mem_reserved);
+	data_mem_reserved = old_data_mem_reserved;
+	data = old_data;
+	data_size = old_data_size;
+	free_code_mem (old_code, old_code_mem_reserved);
+	free (old_data_info);
+	return (0);
+}
+
+#if AOT_LOAD && __linux__
+void free_aot (void)
+{
+	if (aot_entry) free (aot_entry);
+	aot_entry = NULL;
+
+	if (aot_lib) dlclose (aot_lib);
+	aot_lib = NULL;
+}
+
+S2 load_aot (U1 *name)
+{
+	// load native code made by l1aot: name.l1aot.so
+	// returns 0 if there is none or if it doesn't match the object: the code is interpreted then
+	FILE *fptr;
+	U1 soname[512];
+	const S8 *aot_code_size;
+	const S8 *aot_code_hash;
+	const S8 *aot_checks;
+	const S8 *aot_entries;
+	const S8 *aot_entry_epos;
+	Func *aot_entry_func;
+	S8 i ALIGN;
+
+	free_aot ();
+
+	if (strlen_safe ((const char *) name, MAXLINELEN) > 500)
+	{
+		return (0);
+	}
+
+	// dlopen needs a path, not only a file name
+	if (strchr ((const char *) name, '/') == NULL)
+	{
+		strcpy ((char *) soname, "./");
+		strcat ((char *) soname, (const char *) name);
+	}
+	else
+	{
+		strcpy ((char *) soname, (const char *) name);
+	}
+	strcat ((char *) soname, ".l1aot.so");
+
+	fptr = fopen ((const char *) soname, "r");
+	if (fptr == NULL)
+	{
+		return (0);
+	}
+	fclose (fptr);
+
+	aot_lib = dlopen ((const char *) soname, RTLD_NOW);
+	if (aot_lib == NULL)
+	{
+		printf ("load_aot: ERROR: can't load '%s': %s\n", soname, dlerror ());
+		return (0);
+	}
+
+	aot_code_size = dlsym (aot_lib, "l1aot_code_size");
+	aot_code_hash = dlsym (aot_lib, "l1aot_code_hash");
+	aot_checks = dlsym (aot_lib, "l1aot_checks");
+	aot_entries = dlsym (aot_lib, "l1aot_entries");
+	aot_entry_epos = dlsym (aot_lib, "l1aot_entry_epos");
+	aot_entry_func = dlsym (aot_lib, "l1aot_entry_func");
+	if (aot_code_size == NULL || aot_code_hash == NULL || aot_checks == NULL || aot_entries == NULL || aot_entry_epos == NULL || aot_entry_func == NULL)
+	{
+		printf ("load_aot: ERROR: '%s' is not made by l1aot!\n", soname);
+		free_aot ();
+		return (0);
+	}
+
+	if (*aot_code_size != code_size || *aot_code_hash != code_hash (code, 16, code_size))
+	{
+		printf ("load_aot: '%s' doesn't match the object file, not used!\n", soname);
+		free_aot ();
+		return (0);
+	}
+
+	if (*aot_checks != CHECK_FLAGS)
+	{
+		printf ("load_aot: '%s' is made with other BOUNDSCHECK, DIVISIONCHECK or MATH_LIMITS settings, not used!\n", soname);
+		free_aot ();
+		return (0);
+	}
+
+	aot_entry = (Func *) calloc (code_size, sizeof (Func));
+	if (aot_entry == NULL)
+	{
+		printf ("load_aot: ERROR: can't allocate entry table!\n");
+		free_aot ();
+		return (1);
+	}
+
+	for (i = 0; i < *aot_entries; i++)
+	{
+		if (aot_entry_epos[i] >= 16 && aot_entry_epos[i] < code_size)
+		{
+			aot_entry[aot_entry_epos[i]] = aot_entry_func[i];
+		}
+	}
+
+	if (silent_run == 0)
+	{
+		printf ("AOT: %lli native functions loaded from '%s'\n", *aot_entries, soname);
+	}
+	return (0);
+}
+#endif
@@ -24,6 +24,13 @@
 #include "jit.h"
 #include "../include/global.h"
 
+#if __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#endif
+
 // show host system type on compile time ======================================
 #if __linux__
 	#pragma message ("Linux host detected!")
@@ -60,21 +67,132 @@ struct tm *tm;
 S8 JIT_code_ind ALIGN = -1;
 struct JIT_code *JIT_code;
 
-int jit_compiler (S8 init_code, U1 *code, U1 *data, S8 *jumpoffs, S8 *regi, F8 *regd, U1 *sp, U1 *sp_top, U1 *sp_bottom, S8 start, S8 end, struct JIT_code *JIT_code, S8 JIT_code_ind, S8 code_size);
-int run_jit (S8 code, struct JIT_code *JIT_code, S8 JIT_code_ind);
-int free_jit_code (struct JIT_code *JIT_code, S8 JIT_code_ind);
+// the JIT compiler has its own mutex: the program can hold data_mutex by intr1 2
+pthread_mutex_t jit_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#if JIT_HOT_LOOPS
+S4 *jit_hot_count = NULL;			// number of backward jumps to epos
+S4 *jit_hot_entry = NULL;			// JIT code index of loop starting at epos
+#endif
+
+S2 jit_compiler (U1 *code, S8 code_size, S8 start, S8 end, S8 exit_ep, struct JIT_code *JIT_code);
+S8 run_jit (S8 code, struct JIT_code *JIT_code, S8 JIT_code_ind, struct jit_context *ctx);
+void free_jit_code (struct JIT_code *JIT_code, S8 JIT_code_ind);
 void get_jit_compiler_type (void);
+S2 jit_native_opcode (U1 op);
 char *fgets_uni (char *str, int len, FILE *fptr);
 size_t strlen_safe (const char * str, int maxlen);
 #endif
 
-#define EXE_NEXT(); ep = ep + eoffs; goto *jumpt[code[ep]];
+#if PROFILE && __linux__
+// sampling profiler: "-P" flag
+extern U1 profile_run;
+
+S2 profile_start (void);
+volatile S8 *profile_thread_start (S8 cpu_core, S8 startpos, S8 *jumpstack, volatile S8 *jumpstack_ind);
+void profile_write (U1 *name);
+#endif
+
+#if PERF_MAP && PROFILE && __linux__
+// Linux perf support: "-m" and "-j" flags
+extern U1 perf_run;
+extern U1 perf_jitdump;
+
+S2 perf_start (U1 *name);
+void perf_end (U1 *name);
+#endif
+
+void debug_info_free (void);
+
+#if TRACE && __linux__
+// thread trace: "-t" flag
+extern U1 trace_run;
+
+S2 trace_init (void);
+S8 trace_time (void);
+void trace_thread_start (S8 cpu_core, S8 startpos);
+void trace_thread_exit (S8 retcode);
+void trace_spawn (S8 new_cpu, S8 startpos);
+void trace_join (S8 start);
+void trace_mutex_locked (S8 start);
+void trace_mutex_unlock (void);
+void trace_module (void *func, S8 ind, S8 func_ind, S8 start);
+void trace_write (U1 *name);
+#endif
+
+#if MODULE_STATS && __linux__
+// module call statistics: "-s" flag
+extern U1 module_stats_run;
+
+S2 module_stats_start (U1 *name);
+void module_stats_set (S8 ind, S8 func_ind, U1 *module_name, U1 *func_name);
+S8 module_stats_begin (S8 ind, S8 func_ind);
+void module_stats_end (S8 start);
+void module_stats_print (FILE *fptr);
+void module_stats_write (void);
+void module_stats_free (void);
+#endif
+
+#if OPCODE_COUNT
+// opcode counters
+extern struct opcode_count *opcode_count;
+
+S2 opcode_count_init (U1 *name);
+void opcode_count_write (void);
+void opcode_count_free (void);
+#endif
+
+#if AOT_LOAD && __linux__
+// native code made by l1aot
+Func *aot_entry = NULL;				// native function of label at epos
+void *aot_lib = NULL;
+
+S2 load_aot (U1 *name);
+void free_aot (void);
+#endif
+
+#if OPCODE_COUNT
+// count the opcode and the pair with the opcode before
+#define OPCODE_COUNT_NEXT(); opcount->op[code[ep]]++; opcount->pair[last_op][code[ep]]++; last_op = code[ep];
+#else
+#define OPCODE_COUNT_NEXT();
+#endif
+
+#if PROFILE && __linux__
+// sampling profiler: the SIGPROF handler reads the epos of the running opcode
+#define EXE_NEXT(); ep = ep + eoffs; *profile_ep = ep; OPCODE_COUNT_NEXT(); goto *jumpt[code[ep]];
+#else
+#define EXE_NEXT(); ep = ep + eoffs; OPCODE_COUNT_NEXT(); goto *jumpt[code[ep]];
+#endif
 #define PRINT_EPOS(); printf ("epos: %lli\n\n", ep);
 
+#if AOT_LOAD && __linux__
+// jump to target: run native code made by l1aot, if there is a function for it
+#define AOT_BRANCH(target); if (aot_entry != NULL && aot_entry[target] != NULL) { ep = target; goto aot_run; }
+// same for the next opcode after an opcode which is not translated by l1aot
+#define AOT_NEXT(); if (aot_entry != NULL && aot_entry[ep + eoffs] != NULL) { ep = ep + eoffs; goto aot_run; }
+#else
+#define AOT_BRANCH(target);
+#define AOT_NEXT();
+#endif
+
+#if JIT_COMPILER && JIT_HOT_LOOPS
+// backward jump to target: run the loop as JIT code if it is hot, next is the epos after the jump opcode
+#define JIT_HOT_BRANCH(target, next); if (target < ep && __atomic_load_n (&jit_hot_entry[target], __ATOMIC_RELAXED) != JIT_HOT_FAILED) { jit_ret = jit_hot_loop (target, ep, next, &jit_context); if (jit_ret == JIT_EXIT_ERROR) { if (jit_context.error_ep >= 0) ep = jit_context.error_ep; PRINT_EPOS(); free (jumpoffs); pthread_exit ((void *) 1); } if (jit_ret >= 0) { eoffs = 0; ep = jit_ret; EXE_NEXT(); } }
+#else
+#define JIT_HOT_BRANCH(target, next);
+#endif
+
 //#define EXE_NEXT(); ep = ep + eoffs; printf ("next opcode: %i\n", code[ep]); goto *jumpt[code[ep]];
 
 // protos
 S2 load_object (U1 *name);
+S2 load_data_names (U1 *name);
+S2 reload_object (U1 *name);
+void free_data_mem (U1 *ptr, S8 reserved);
+S8 grow_data_mem (S8 size, U1 type);
+void free_code_mem (U1 *ptr, S8 reserved);
+void show_huge_pages (void);
 void free_modules (void);
 size_t strlen_safe (const char * str, int maxlen);
 
@@ -89,6 +207,8 @@ S8 max_code_size ALIGN = MAX_CODE_SIZE;
 S8 max_data_size ALIGN = MAX_DATA_SIZE;
 
 S8 data_mem_size ALIGN;
+S8 code_mem_reserved ALIGN = 0;		// code segment mapping size, 0 = heap memory
+S8 data_mem_reserved ALIGN = 0;	// data segment address space, data_mem_size can grow up to this
 S8 stack_size ALIGN = STACKSIZE;		// stack size added to data size when dumped to object file
 
 // code
@@ -107,6 +227,7 @@ S8 cpu_ind ALIGN = 0;
 S8 max_cpu ALIGN = MAXCPUCORES;    // number of threads that can be runned
 
 U1 silent_run = 0;				// switch startup and status messages of: "-q" flag on shell
+U1 huge_pages = 0;				// "-H" flag: use huge pages for code and data
 
 typedef U1* (*dll_func)(U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data);
 
@@ -132,6 +253,7 @@ S8 data_info_ind ALIGN = -1;
 
 // pthreads data mutex
 pthread_mutex_t data_mutex;
+S8 data_mutex_owner ALIGN = -1;		// CPU core which holds data_mutex by intr1 2, -1 = none
 
 // return code of main thread
 S8 retcode ALIGN = 0;
@@ -142,18 +264,39 @@ S4 shell_args_ind = -1;
 
 struct threaddata *threaddata;
 
+// pre-fork server mode: "-F" = requests on stdin, "-U socket" = requests on Unix socket
+#define SERVER_OFF				0
+#define SERVER_STDIN			1
+#define SERVER_SOCKET			2
+
+U1 server_mode = SERVER_OFF;
+U1 server_socket_path[MAXLINELEN];
+
+// hot code reload: SIGHUP sets reload_pending, the reload is done at the next intr0 27 safe point
+U1 object_name[512];
+U1 reload_enabled = 0;
+volatile sig_atomic_t reload_pending = 0;
+volatile sig_atomic_t reload_deferred = 0;	// "reload deferred" printed, until the next SIGHUP
+S8 reload_count ALIGN = 0;
+
 
 // memory bounds checking function
 
-S2 memory_bounds (S8 start, S8 offset_access)
+// range and alignment check without side effects, used by the JIT compiler too
+// returns 0 = ok, or one of the MEMORY_BOUNDS_ error codes
+#define MEMORY_BOUNDS_BELOW_ZERO		1
+#define MEMORY_BOUNDS_WORD				2
+#define MEMORY_BOUNDS_DOUBLEWORD		3
+#define MEMORY_BOUNDS_QUADWORD			4
+#define MEMORY_BOUNDS_NOT_FOUND			5
+
+S2 memory_bounds_check (S8 start, S8 offset_access)
 {
 	S8 i ALIGN;
 
 	if (start + offset_access < 0)
 	{
-		// access ERROR!
-		printf ("memory_bounds: FATAL ERROR: address: %lli, offset: %lli below zero!\n", start, offset_access);
-		return (1);
+		return (MEMORY_BOUNDS_BELOW_ZERO);
 	}
 
 	for (i = 0; i <= data_info_ind; i++)
@@ -178,8 +321,7 @@ S2 memory_bounds (S8 start, S8 offset_access)
 					case WORD:
 						if (offset_access % sizeof (S2) != 0)
 						{
-							printf ("memory_bounds: FATAL ERROR: variable access not on word bound, address: %lli, offset: %lli!\n", start, offset_access);
-							return (1);
+							return (MEMORY_BOUNDS_WORD);
 						}
 						return (0);
 						break;
@@ -187,8 +329,7 @@ S2 memory_bounds (S8 start, S8 offset_access)
 					case DOUBLEWORD:
 						if (offset_access % sizeof (S4) != 0)
 						{
-							printf ("memory_bounds: FATAL ERROR: variable access not on double word bound, address: %lli, offset: %lli!\n", start, offset_access);
-							return (1);
+							return (MEMORY_BOUNDS_DOUBLEWORD);
 						}
 						return (0);
 						break;
@@ -197,8 +338,7 @@ S2 memory_bounds (S8 start, S8 offset_access)
 					case DOUBLEFLOAT:
 						if (offset_access % sizeof (S8) != 0)
 						{
-							printf ("memory_bounds: FATAL ERROR: variable access not on quad word/double float bound, address: %lli, offset: %lli!\n", start, offset_access);
-							return (1);
+							return (MEMORY_BOUNDS_QUADWORD);
 						}
 						return (0);
 						break;
@@ -206,7 +346,38 @@ S2 memory_bounds (S8 start, S8 offset_access)
 			}
 		}
 	}
-	printf ("memory_bounds: FATAL ERROR: variable not found overflow address: %lli, offset: %lli!\n", start, offset_access);
+	return (MEMORY_BOUNDS_NOT_FOUND);
+}
+
+S2 memory_bounds (S8 start, S8 offset_access)
+{
+	switch (memory_bounds_check (start, offset_access))
+	{
+		case 0:
+			// all ok, return 0
+			return (0);
+
+		case MEMORY_BOUNDS_BELOW_ZERO:
+			// access ERROR!
+			printf ("memory_bounds: FATAL ERROR: address: %lli, offset: %lli below zero!\n", start, offset_access);
+			break;
+
+		case MEMORY_BOUNDS_WORD:
+			printf ("memory_bounds: FATAL ERROR: variable access not on word bound, address: %lli, offset: %lli!\n", start, offset_access);
+			break;
+
+		case MEMORY_BOUNDS_DOUBLEWORD:
+			printf ("memory_bounds: FATAL ERROR: variable access not on double word bound, address: %lli, offset: %lli!\n", start, offset_access);
+			break;
+
+		case MEMORY_BOUNDS_QUADWORD:
+			printf ("memory_bounds: FATAL ERROR: variable access not on quad word/double float bound, address: %lli, offset: %lli!\n", start, offset_access);
+			break;
+
+		default:
+			printf ("memory_bounds: FATAL ERROR: variable not found overflow address: %lli, offset: %lli!\n", start, offset_access);
+			break;
+	}
 	return (1);
 }
 
@@ -221,6 +392,102 @@ S2 alloc_jit_code ()
 	}
 	return (0);
 }
+
+#if JIT_HOT_LOOPS
+S2 alloc_jit_hot (void)
+{
+	// (re)allocate the hot loop tables for the current code
+	S8 i ALIGN;
+
+	if (jit_hot_count) free (jit_hot_count);
+	if (jit_hot_entry) free (jit_hot_entry);
+
+	jit_hot_count = (S4 *) calloc (code_size, sizeof (S4));
+	jit_hot_entry = (S4 *) calloc (code_size, sizeof (S4));
+	if (jit_hot_count == NULL || jit_hot_entry == NULL)
+	{
+		printf ("FATAL ERROR: can't allocate JIT hot loop tables!\n");
+		return (1);
+	}
+
+	for (i = 0; i < code_size; i++)
+	{
+		jit_hot_entry[i] = JIT_HOT_NONE;
+	}
+	return (0);
+}
+
+S8 jit_hot_loop (S8 target, S8 branch_ep, S8 next_ep, struct jit_context *ctx)
+{
+	// called on a backward jump from branch_ep to target
+	// returns the epos to continue at after running the JIT code,
+	// or JIT_HOT_INTERPRET if the loop is not compiled (yet)
+	// other threads read the tables without the jit_mutex: the entry is stored with release
+	// after its JIT code is set, and loaded with acquire
+	S4 entry;
+
+	entry = __atomic_load_n (&jit_hot_entry[target], __ATOMIC_ACQUIRE);
+	if (entry >= 0)
+	{
+		// JIT_code_ind can change in an other thread: the entry is the last index needed
+		return (run_jit (entry, JIT_code, entry, ctx));
+	}
+
+	if (__atomic_add_fetch (&jit_hot_count[target], 1, __ATOMIC_RELAXED) < JIT_HOT_THRESHOLD)
+	{
+		return (JIT_HOT_INTERPRET);
+	}
+
+	pthread_mutex_lock (&jit_mutex);
+	// another thread can have compiled it already
+	if (jit_hot_entry[target] == JIT_HOT_NONE)
+	{
+		if (jit_native_opcode (code[target]) == 0 || JIT_code_ind >= MAXJITCODE - 1)
+		{
+			// first opcode would exit at once, or no space left
+			__atomic_store_n (&jit_hot_entry[target], JIT_HOT_FAILED, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			// end of loop: continue after the jump opcode
+			if (jit_compiler (code, code_size, target, branch_ep, next_ep, &JIT_code[JIT_code_ind + 1]) == 0)
+			{
+				JIT_code_ind++;
+				__atomic_store_n (&jit_hot_entry[target], JIT_code_ind, __ATOMIC_RELEASE);
+				#if DEBUG
+				printf ("JIT: hot loop compiled: %lli - %lli\n", target, branch_ep);
+				#endif
+			}
+			else
+			{
+				__atomic_store_n (&jit_hot_entry[target], JIT_HOT_FAILED, __ATOMIC_RELAXED);
+			}
+		}
+	}
+	pthread_mutex_unlock (&jit_mutex);
+	return (JIT_HOT_INTERPRET);
+}
+#endif
+#endif
+
+#if AOT_LOAD && __linux__
+S8 run_aot (S8 epos, struct jit_context *ctx)
+{
+	// run native functions as long as the next epos has one
+	S8 last_epos ALIGN;
+
+	while (epos >= 0 && epos < code_size && aot_entry[epos] != NULL)
+	{
+		last_epos = epos;
+		epos = (*aot_entry[epos])(ctx);
+		if (epos == last_epos)
+		{
+			// opcode can't run native
+			break;
+		}
+	}
+	return (epos);
+}
 #endif
 
 S2 load_module (U1 *name, S8 ind ALIGN)
@@ -281,6 +548,9 @@ S2 set_module_func (S8 ind ALIGN, S8 func_ind ALIGN, U1 *func_name)
 		printf ("%s\n", dlsym_error);
         return (1);
     }
+	#if MODULE_STATS
+	module_stats_set (ind, func_ind, modules[ind].name, func_name);
+	#endif
     return (0);
 #endif
 
@@ -297,22 +567,168 @@ S2 set_module_func (S8 ind ALIGN, S8 func_ind ALIGN, U1 *func_name)
 
 U1 *call_module_func (S8 ind ALIGN, S8 func_ind ALIGN, U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
-    return (*modules[ind].func[func_ind])(sp, sp_top, sp_bottom, data);
+	#if MODULE_STATS && __linux__
+	S8 start ALIGN = 0;
+	#endif
+	#if TRACE && __linux__
+	S8 trace_start ALIGN = 0;
+	#endif
+
+	#if MODULE_STATS && __linux__
+	if (module_stats_run) start = module_stats_begin (ind, func_ind);
+	#endif
+	#if TRACE && __linux__
+	if (trace_run) trace_start = trace_time ();
+	#endif
+
+    sp = (*modules[ind].func[func_ind])(sp, sp_top, sp_bottom, data);
+
+	#if TRACE && __linux__
+	if (trace_run) trace_module ((void *) modules[ind].func[func_ind], ind, func_ind, trace_start);
+	#endif
+	#if MODULE_STATS && __linux__
+	if (module_stats_run) module_stats_end (start);
+	#endif
+	return (sp);
+}
+
+#if __linux__
+void reload_handler (int sig)
+{
+	reload_pending = 1;
+	reload_deferred = 0;
+}
+#endif
+
+// data_mutex for the VM interrupts: the calling thread may hold it already by intr1 2
+// returns 1 if locked here, 0 if the thread holds it
+U1 lock_data_mutex (S8 cpu_core ALIGN)
+{
+	// only this thread sets data_mutex_owner to its core
+	if (__atomic_load_n (&data_mutex_owner, __ATOMIC_RELAXED) == cpu_core)
+	{
+		return (0);
+	}
+	pthread_mutex_lock (&data_mutex);
+	return (1);
+}
+
+void unlock_data_mutex (U1 locked)
+{
+	if (locked)
+	{
+		pthread_mutex_unlock (&data_mutex);
+	}
+}
+
+S2 reload_code (S8 cpu_core ALIGN)
+{
+	// called from intr0 27: only possible if no other thread runs the old code
+	S8 i ALIGN;
+	U1 locked;
+
+	locked = lock_data_mutex (cpu_core);
+	for (i = 0; i < max_cpu; i++)
+	{
+		if (i != cpu_core && threaddata[i].status == RUNNING)
+		{
+			unlock_data_mutex (locked);
+			if (reload_deferred == 0)
+			{
+				// only once, intr0 27 is called again and again
+				printf ("reload: other threads running, reload deferred.\n");
+				reload_deferred = 1;
+			}
+			return (1);
+		}
+	}
+
+	if (reload_object (object_name) != 0)
+	{
+		unlock_data_mutex (locked);
+		reload_pending = 0;
+		printf ("reload: ERROR: can't load new object '%s', running old code!\n", object_name);
+		return (1);
+	}
+
+	#if JIT_COMPILER
+		// compiled code belongs to the old object
+		pthread_mutex_lock (&jit_mutex);
+		free_jit_code (JIT_code, JIT_code_ind);
+		JIT_code_ind = -1;
+		#if JIT_HOT_LOOPS
+		if (alloc_jit_hot () != 0)
+		{
+			pthread_mutex_unlock (&jit_mutex);
+			unlock_data_mutex (locked);
+			reload_pending = 0;
+			return (1);
+		}
+		#endif
+		pthread_mutex_unlock (&jit_mutex);
+	#endif
+
+	#if AOT_LOAD && __linux__
+		// native code of the new object, if there is one
+		load_aot (object_name);
+	#endif
+
+	reload_pending = 0;
+	reload_deferred = 0;
+	reload_count++;
+	unlock_data_mutex (locked);
+
+	if (silent_run == 0)
+	{
+		printf ("reload: new code loaded: %lli\n", reload_count);
+	}
+	return (0);
 }
 
 void cleanup (void)
 {
+	#if PERF_MAP && PROFILE && __linux__
+		perf_end (object_name);
+	#endif
+
+	#if PROFILE && __linux__
+		profile_write (object_name);
+	#endif
+	debug_info_free ();
+
+	#if OPCODE_COUNT
+		opcode_count_write ();
+		opcode_count_free ();
+	#endif
+
+	#if MODULE_STATS && __linux__
+		module_stats_write ();
+		module_stats_free ();
+	#endif
+
+	#if TRACE && __linux__
+		trace_write (object_name);
+	#endif
+
+	#if AOT_LOAD && __linux__
+		free_aot ();
+	#endif
+
 	#if JIT_COMPILER
 		free_jit_code (JIT_code, JIT_code_ind);
 	#endif
 
     free_modules ();
-	if (data) free (data);
-    if (code) free (code);
+	if (data) free_data_mem (data, data_mem_reserved);
+    if (code) free_code_mem (code, code_mem_reserved);
 	if (threaddata) free (threaddata);
 
 	#if JIT_COMPILER
 		if (JIT_code) free (JIT_code);
+		#if JIT_HOT_LOOPS
+			if (jit_hot_count) free (jit_hot_count);
+			if (jit_hot_entry) free (jit_hot_entry);
+		#endif
 	#endif
 }
 
@@ -329,152 +745,74 @@ U1 double_state (F8 num)
 	return (flag);
 }
 
-S2 run (void *arg)
+S2 set_jumpoffsets (S8 *jumpoffs)
 {
-	S8 cpu_core ALIGN = (S8) arg;
+	// get the jump targets of all branch opcodes
 	S8 i ALIGN;
-	U1 eoffs;                  	// offset to next opcode
-	S8 regi[MAXREG];   		  	// integer registers
-	F8 regd[MAXREG];			// double registers
 	S8 arg1 ALIGN;
-	S8 arg2 ALIGN;
-	S8 arg3 ALIGN;
-	S8 arg4 ALIGN;				// opcode arguments
-
-	S8 ep ALIGN = 0; 			// execution pointer in code segment
-	S8 startpos ALIGN;
+	S8 offset ALIGN;
+	U1 *bptr;
 
-	U1 overflow = 0;			// MATH_LIMITS calculation overflow flag
+	for (i = 16; i < code_size; i = i + offset)
+	{
+		//printf ("opcode: %i\n", code[i]);
+		offset = 0;
+		if (code[i] <= LSEQD)
+		{
+			offset = 4;
+		}
+		if (code[i] == JMP)
+		{
+			bptr = (U1 *) &arg1;
 
-	U1 *sp;  					// stack pointer
-	U1 *sp_top;    				// stack pointer start address
-	U1 *sp_bottom;				// stack bottom
-	U1 *srcptr, *dstptr;
+			*bptr = code[i + 1];
+			bptr++;
+			*bptr = code[i + 2];
+			bptr++;
+			*bptr = code[i + 3];
+			bptr++;
+			*bptr = code[i + 4];
+			bptr++;
+			*bptr = code[i + 5];
+			bptr++;
+			*bptr = code[i + 6];
+			bptr++;
+			*bptr = code[i + 7];
+			bptr++;
+			*bptr = code[i + 8];
 
-	U1 *bptr;
+			jumpoffs[i] = arg1;
+			offset = 9;
+		}
 
-	// jump call stack for jsr, jsra
-	S8 jumpstack[MAXSUBJUMPS];
-	S8 jumpstack_ind ALIGN = -1;		// empty
+		if (code[i] == JMPI)
+		{
+			bptr = (U1 *) &arg1;
 
-	// threads
-	S8 new_cpu ALIGN;
-	S8 cpus_free ALIGN;
+			*bptr = code[i + 2];
+			bptr++;
+			*bptr = code[i + 3];
+			bptr++;
+			*bptr = code[i + 4];
+			bptr++;
+			*bptr = code[i + 5];
+			bptr++;
+			*bptr = code[i + 6];
+			bptr++;
+			*bptr = code[i + 7];
+			bptr++;
+			*bptr = code[i + 8];
+			bptr++;
+			*bptr = code[i + 9];
 
-    // thread attach to CPU core
-	#if CPU_SET_AFFINITY
-	cpu_set_t cpuset;
-	#endif
+			jumpoffs[i] = arg1;
+			offset = 10;
+		}
 
-	// for data input
-	U1 input_str[MAXINPUT];
+		if (code[i] == INCLSIJMPI || code[i] == DECGRIJMPI)
+		{
+			bptr = (U1 *) &arg1;
 
-	// for time functions
-	time_t secs;
-
-	// jumpoffsets
-	S8 *jumpoffs ALIGN;
-	S8 offset ALIGN;
-	jumpoffs = (S8 *) calloc (code_size, sizeof (S8));
-	if (jumpoffs == NULL)
-	{
-		printf ("ERROR: can't allocate %lli bytes for jumpoffsets!\n", code_size);
-		pthread_exit ((void *) 1);
-	}
-
-	sp_top = threaddata[cpu_core].sp_top_thread;
-	sp_bottom = threaddata[cpu_core].sp_bottom_thread;
-	sp = threaddata[cpu_core].sp_thread;
-
-	if (silent_run == 0)
-	{
-		printf ("%lli stack size: %lli\n", cpu_core, stack_size);
-		printf ("%lli sp top: %lli\n", cpu_core, (S8) sp_top);
-		printf ("%lli sp bottom: %lli\n", cpu_core, (S8) sp_bottom);
-		printf ("%lli sp: %lli\n", cpu_core, (S8) sp);
-
-		printf ("%lli sp caller top: %lli\n", cpu_core, (S8) threaddata[cpu_core].sp_top);
-		printf ("%lli sp caller bottom: %lli\n", cpu_core, (S8) threaddata[cpu_core].sp_bottom);
-	}
-
-	startpos = threaddata[cpu_core].ep_startpos;
-	if (threaddata[cpu_core].sp != threaddata[cpu_core].sp_top)
-	{
-		// something on mother thread stack, copy it
-
-		srcptr = threaddata[cpu_core].sp_top;
-		dstptr = threaddata[cpu_core].sp_top_thread;
-
-		while (srcptr >= threaddata[cpu_core].sp)
-		{
-			// printf ("dstptr stack: %lli\n", (S8) dstptr);
-			*dstptr-- = *srcptr--;
-		}
-	}
-
-	cpu_ind = cpu_core;
-
-	// jumptable for indirect threading execution
-	static void *jumpt[] =
-	{
-		&&pushb, &&pushw, &&pushdw, &&pushqw, &&pushd,
-		&&pullb, &&pullw, &&pulldw, &&pullqw, &&pulld,
-		&&addi, &&subi, &&muli, &&divi,
-		&&addd, &&subd, &&muld, &&divd,
-		&&smuli, &&sdivi,
-		&&andi, &&ori, &&bandi, &&bori, &&bxori, &&modi,
-		&&eqi, &&neqi, &&gri, &&lsi, &&greqi, &&lseqi,
-		&&eqd, &&neqd, &&grd, &&lsd, &&greqd, &&lseqd,
-		&&jmp, &&jmpi,
-		&&stpushb, &&stpopb, &&stpushi, &&stpopi, &&stpushd, &&stpopd,
-		&&loada, &&loadd,
-		&&intr0, &&intr1, &&inclsijmpi, &&decgrijmpi,
-		&&movi, &&movd, &&loadl, &&jmpa,
-		&&jsr, &&jsra, &&rts, &&load,
-        &&noti
-	};
-
-	//printf ("setting jump offset table...\n");
-
-	// setup jump offset table
-	for (i = 16; i < code_size; i = i + offset)
-	{
-		//printf ("opcode: %i\n", code[i]);
-		offset = 0;
-		if (code[i] <= LSEQD)
-		{
-			offset = 4;
-		}
-		if (code[i] == JMP)
-		{
-			bptr = (U1 *) &arg1;
-
-			*bptr = code[i + 1];
-			bptr++;
-			*bptr = code[i + 2];
-			bptr++;
-			*bptr = code[i + 3];
-			bptr++;
-			*bptr = code[i + 4];
-			bptr++;
-			*bptr = code[i + 5];
-			bptr++;
-			*bptr = code[i + 6];
-			bptr++;
-			*bptr = code[i + 7];
-			bptr++;
-			*bptr = code[i + 8];
-
-			jumpoffs[i] = arg1;
-			offset = 9;
-		}
-
-		if (code[i] == JMPI)
-		{
-			bptr = (U1 *) &arg1;
-
-			*bptr = code[i + 2];
-			bptr++;
 			*bptr = code[i + 3];
 			bptr++;
 			*bptr = code[i + 4];
@@ -488,13 +826,16 @@ S2 run (void *arg)
 			*bptr = code[i + 8];
 			bptr++;
 			*bptr = code[i + 9];
+			bptr++;
+			*bptr = code[i + 10];
 
 			jumpoffs[i] = arg1;
-			offset = 10;
+			offset = 11;
 		}
 
-		if (code[i] == INCLSIJMPI || code[i] == DECGRIJMPI)
+		if (code[i] == JMPT)
 		{
+			// default target, the table entries are jmp opcodes
 			bptr = (U1 *) &arg1;
 
 			*bptr = code[i + 3];
@@ -594,17 +935,200 @@ S2 run (void *arg)
                 case NOTI:
                     offset = 3;
                     break;
+
+				case PUSHWS:
+				case PUSHDWS:
+				case PUSHQWS:
+				case PUSHDS:
+				case PULLWS:
+				case PULLDWS:
+				case PULLQWS:
+				case PULLDS:
+					offset = 4;
+					break;
+
+				case STPUSHIR:
+				case STPOPIR:
+				case STPUSHDR:
+				case STPOPDR:
+					offset = 3;
+					break;
+
+				case SHLI:
+					offset = 4;
+					break;
 			}
 		}
 		if (offset == 0)
 		{
 			printf ("FATAL error: setting jump offset failed! opcode: %i\n", code[i]);
-			free (jumpoffs);
-			pthread_exit ((void *) 1);
+			return (1);
 		}
 
 		if (i >= code_size) break;
 	}
+	return (0);
+}
+
+S2 run (void *arg)
+{
+	S8 cpu_core ALIGN = (S8) arg;
+	S8 i ALIGN;
+	U1 eoffs;                  	// offset to next opcode
+	S8 regi[MAXREG];   		  	// integer registers
+	F8 regd[MAXREG];			// double registers
+	S8 arg1 ALIGN;
+	S8 arg2 ALIGN;
+	S8 arg3 ALIGN;
+	S8 arg4 ALIGN;				// opcode arguments
+
+	S8 ep ALIGN = 0; 			// execution pointer in code segment
+	S8 startpos ALIGN;
+
+	U1 overflow = 0;			// MATH_LIMITS calculation overflow flag
+	U1 locked;					// data_mutex locked by lock_data_mutex
+
+	U1 *sp;  					// stack pointer
+	U1 *sp_top;    				// stack pointer start address
+	U1 *sp_bottom;				// stack bottom
+	U1 *srcptr, *dstptr;
+
+	U1 *bptr;
+
+	// jump call stack for jsr, jsra
+	S8 jumpstack[MAXSUBJUMPS];
+	volatile S8 jumpstack_ind ALIGN = -1;		// empty, volatile: read by the profiler
+
+	#if PROFILE && __linux__
+	volatile S8 *profile_ep;
+	#endif
+
+	#if OPCODE_COUNT
+	struct opcode_count *opcount;
+	U1 last_op = MAXOPCODES;
+	#endif
+
+	#if TRACE && __linux__
+	S8 trace_start ALIGN;
+	#endif
+
+	// threads
+	S8 new_cpu ALIGN;
+	S8 cpus_free ALIGN;
+
+    // thread attach to CPU core
+	#if CPU_SET_AFFINITY
+	cpu_set_t cpuset;
+	#endif
+
+	// for data input
+	U1 input_str[MAXINPUT];
+
+	// for time functions
+	time_t secs;
+
+	// JIT and AOT code state
+	#if JIT_COMPILER || (AOT_LOAD && __linux__)
+	struct jit_context jit_context;
+	#endif
+	#if JIT_COMPILER
+	S8 jit_ret ALIGN;
+	#endif
+
+	#if JIT_COMPILER || (AOT_LOAD && __linux__)
+	jit_context.regi = regi;
+	jit_context.regd = regd;
+	jit_context.data = data;
+	jit_context.memory_bounds = memory_bounds;
+	jit_context.error_ep = 0;
+	#endif
+
+	// jumpoffsets
+	S8 *jumpoffs ALIGN;
+	jumpoffs = (S8 *) calloc (code_size, sizeof (S8));
+	if (jumpoffs == NULL)
+	{
+		printf ("ERROR: can't allocate %lli bytes for jumpoffsets!\n", code_size);
+		pthread_exit ((void *) 1);
+	}
+
+	sp_top = threaddata[cpu_core].sp_top_thread;
+	sp_bottom = threaddata[cpu_core].sp_bottom_thread;
+	sp = threaddata[cpu_core].sp_thread;
+
+	if (silent_run == 0)
+	{
+		printf ("%lli stack size: %lli\n", cpu_core, stack_size);
+		printf ("%lli sp top: %lli\n", cpu_core, (S8) sp_top);
+		printf ("%lli sp bottom: %lli\n", cpu_core, (S8) sp_bottom);
+		printf ("%lli sp: %lli\n", cpu_core, (S8) sp);
+
+		printf ("%lli sp caller top: %lli\n", cpu_core, (S8) threaddata[cpu_core].sp_top);
+		printf ("%lli sp caller bottom: %lli\n", cpu_core, (S8) threaddata[cpu_core].sp_bottom);
+	}
+
+	startpos = threaddata[cpu_core].ep_startpos;
+
+	#if PROFILE && __linux__
+	profile_ep = profile_thread_start (cpu_core, startpos, jumpstack, &jumpstack_ind);
+	#endif
+
+	#if OPCODE_COUNT
+	opcount = &opcode_count[cpu_core];
+	#endif
+
+	#if TRACE && __linux__
+	trace_thread_start (cpu_core, startpos);
+	#endif
+
+	if (threaddata[cpu_core].sp != threaddata[cpu_core].sp_top)
+	{
+		// something on mother thread stack, copy it
+
+		srcptr = threaddata[cpu_core].sp_top;
+		dstptr = threaddata[cpu_core].sp_top_thread;
+
+		while (srcptr >= threaddata[cpu_core].sp)
+		{
+			// printf ("dstptr stack: %lli\n", (S8) dstptr);
+			*dstptr-- = *srcptr--;
+		}
+	}
+
+	cpu_ind = cpu_core;
+
+	// jumptable for indirect threading execution
+	static void *jumpt[] =
+	{
+		&&pushb, &&pushw, &&pushdw, &&pushqw, &&pushd,
+		&&pullb, &&pullw, &&pulldw, &&pullqw, &&pulld,
+		&&addi, &&subi, &&muli, &&divi,
+		&&addd, &&subd, &&muld, &&divd,
+		&&smuli, &&sdivi,
+		&&andi, &&ori, &&bandi, &&bori, &&bxori, &&modi,
+		&&eqi, &&neqi, &&gri, &&lsi, &&greqi, &&lseqi,
+		&&eqd, &&neqd, &&grd, &&lsd, &&greqd, &&lseqd,
+		&&jmp, &&jmpi,
+		&&stpushb, &&stpopb, &&stpushi, &&stpopi, &&stpushd, &&stpopd,
+		&&loada, &&loadd,
+		&&intr0, &&intr1, &&inclsijmpi, &&decgrijmpi,
+		&&movi, &&movd, &&loadl, &&jmpa,
+		&&jsr, &&jsra, &&rts, &&load,
+        &&noti, &&jmpt,
+		&&pushws, &&pushdws, &&pushqws, &&pushds,
+		&&pullws, &&pulldws, &&pullqws, &&pullds,
+		&&stpushir, &&stpopir, &&stpushdr, &&stpopdr,
+		&&shli
+	};
+
+	//printf ("setting jump offset table...\n");
+
+	// setup jump offset table
+	if (set_jumpoffsets (jumpoffs) != 0)
+	{
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
 
 	// debug
 #if DEBUG
@@ -635,6 +1159,7 @@ S2 run (void *arg)
 
 	ep = startpos; eoffs = 0;
 
+	AOT_BRANCH(ep);
 	EXE_NEXT();
 
 	// arg2 = data offset
@@ -1495,6 +2020,8 @@ S2 run (void *arg)
 	printf ("%lli JMP\n", cpu_core);
 	#endif
 	arg1 = jumpoffs[ep];
+	AOT_BRANCH(arg1);
+	JIT_HOT_BRANCH(arg1, ep + 9);
 
 	eoffs = 0;
 	ep = arg1;
@@ -1511,6 +2038,8 @@ S2 run (void *arg)
 
 	if (regi[arg1] != 0)
 	{
+		AOT_BRANCH(arg2);
+		JIT_HOT_BRANCH(arg2, ep + 10);
 		eoffs = 0;
 		ep = arg2;
 		#if DEBUG
@@ -1547,6 +2076,7 @@ S2 run (void *arg)
 	}
 	eoffs = 2;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	stpopb:
@@ -1575,6 +2105,7 @@ S2 run (void *arg)
 	sp++;
 	eoffs = 2;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	stpushi:
@@ -1617,6 +2148,7 @@ S2 run (void *arg)
 
 	eoffs = 2;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	stpopi:
@@ -1656,6 +2188,7 @@ S2 run (void *arg)
 
 	eoffs = 2;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	stpushd:
@@ -1696,6 +2229,7 @@ S2 run (void *arg)
 	}
 	eoffs = 2;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	stpopd:
@@ -1735,6 +2269,7 @@ S2 run (void *arg)
 
 	eoffs = 2;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	loada:
@@ -1893,6 +2428,9 @@ S2 run (void *arg)
 	intr0:
 
 	arg1 = code[ep + 1];
+	#if OPCODE_COUNT
+	opcount->intr0[arg1]++;
+	#endif
 	#if DEBUG
 	printf ("%lli INTR0: %lli\n", cpu_core, arg1);
 	#endif
@@ -2239,13 +2777,70 @@ S2 run (void *arg)
 			}
 			break;
 
-		case 251:
-			// set overflow on double reg
+		case 27:
+			// hot code reload safe point: reload if forced by register or requested by SIGHUP
+			// on success, execution restarts at the entry of the new code, the data segment is kept
 			arg2 = code[ep + 2];
-			overflow = 0;
-			if (double_state (regd[arg2]) == 1)
+			eoffs = 5;
+			if (regi[arg2] != 0 || reload_pending)
 			{
-				overflow = 1;
+				if (reload_code (cpu_core) == 0)
+				{
+					free (jumpoffs);
+					jumpoffs = (S8 *) calloc (code_size, sizeof (S8));
+					if (jumpoffs == NULL)
+					{
+						printf ("ERROR: can't allocate %lli bytes for jumpoffsets!\n", code_size);
+						pthread_exit ((void *) 1);
+					}
+					if (set_jumpoffsets (jumpoffs) != 0)
+					{
+						free (jumpoffs);
+						pthread_exit ((void *) 1);
+					}
+
+					jumpstack_ind = -1;
+					sp = sp_top;
+					ep = 16; eoffs = 0;
+				}
+			}
+			break;
+
+		case 28:
+			// return number of hot code reloads done
+			arg2 = code[ep + 2];
+			regi[arg2] = reload_count;
+			eoffs = 5;
+			break;
+
+		case 29:
+			// grow data segment: new variable of size bytes and data type, returns address or -1
+			arg2 = code[ep + 2];
+			arg3 = code[ep + 3];
+			arg4 = code[ep + 4];
+			locked = lock_data_mutex (cpu_core);
+			regi[arg4] = grow_data_mem (regi[arg2], regi[arg3]);
+			unlock_data_mutex (locked);
+			eoffs = 5;
+			break;
+
+		case 30:
+			// print module call statistics
+			#if MODULE_STATS && __linux__
+			module_stats_print (stdout);
+			#else
+			printf ("module stats: not in this VM build!\n");
+			#endif
+			eoffs = 5;
+			break;
+
+		case 251:
+			// set overflow on double reg
+			arg2 = code[ep + 2];
+			overflow = 0;
+			if (double_state (regd[arg2]) == 1)
+			{
+				overflow = 1;
 			}
 			break;
 
@@ -2262,13 +2857,26 @@ S2 run (void *arg)
             arg2 = code[ep + 2];
             arg3 = code[ep + 3];
 
-			if (jit_compiler (20210105, (U1 *) code, (U1 *) data, (S8 *) jumpoffs, (S8 *) &regi, (F8 *) &regd, (U1 *) sp, sp_top, sp_bottom, regi[arg2], regi[arg3], JIT_code, JIT_code_ind, code_size) != 0)
+			pthread_mutex_lock (&jit_mutex);
+			if (JIT_code_ind >= MAXJITCODE - 1)
+			{
+				pthread_mutex_unlock (&jit_mutex);
+				printf ("FATAL ERROR: JIT compiler: code list full!\n");
+				PRINT_EPOS();
+				free (jumpoffs);
+				pthread_exit ((void *) 1);
+			}
+
+			if (jit_compiler (code, code_size, regi[arg2], regi[arg3], JIT_EXIT_END, &JIT_code[JIT_code_ind + 1]) != 0)
             {
+				pthread_mutex_unlock (&jit_mutex);
                 printf ("FATAL ERROR: JIT compiler: can't compile!\n");
 				PRINT_EPOS();
                 free (jumpoffs);
             	pthread_exit ((void *) 1);
             }
+			JIT_code_ind++;
+			pthread_mutex_unlock (&jit_mutex);
 
             eoffs = 5;
             break;
@@ -2276,7 +2884,23 @@ S2 run (void *arg)
         case 254:
             arg2 = code[ep + 2];
             // printf ("intr0: 254: RUN JIT CODE: %i\n", arg2);
-			run_jit (regi[arg2], JIT_code, JIT_code_ind);
+			jit_context.data = data;
+			jit_ret = run_jit (regi[arg2], JIT_code, JIT_code_ind, &jit_context);
+			if (jit_ret == JIT_EXIT_ERROR)
+			{
+				if (jit_context.error_ep >= 0) ep = jit_context.error_ep;
+				PRINT_EPOS();
+				free (jumpoffs);
+				pthread_exit ((void *) 1);
+			}
+
+			if (jit_ret >= 0)
+			{
+				// left JIT code: continue here
+				ep = jit_ret;
+				eoffs = 0;
+				break;
+			}
 
             eoffs = 5;
             break;
@@ -2304,6 +2928,9 @@ S2 run (void *arg)
 			}
 			arg2 = code[ep + 2];
 			retcode = regi[arg2];
+			#if TRACE && __linux__
+			trace_thread_exit (retcode);
+			#endif
 			free (jumpoffs);
 			pthread_mutex_lock (&data_mutex);
 			threaddata[cpu_core].status = STOP;
@@ -2317,6 +2944,7 @@ S2 run (void *arg)
 			free (jumpoffs);
 			pthread_exit ((void *) 1);
 	}
+	AOT_NEXT();
 	EXE_NEXT();
 
 	intr1:
@@ -2325,6 +2953,9 @@ S2 run (void *arg)
 	#endif
 	// special interrupt
 	arg1 = code[ep + 1];
+	#if OPCODE_COUNT
+	opcount->intr1[arg1]++;
+	#endif
 
 	switch (arg1)
 	{
@@ -2380,6 +3011,9 @@ S2 run (void *arg)
 				free (jumpoffs);
 				pthread_exit ((void *) 1);
 			}
+			#if TRACE && __linux__
+			trace_spawn (new_cpu, arg2);
+			#endif
 
 
             #if CPU_SET_AFFINITY
@@ -2405,6 +3039,9 @@ S2 run (void *arg)
 			// join threads
 			printf ("JOINING THREADS...\n");
 			U1 wait = 1, running;
+			#if TRACE && __linux__
+			trace_start = trace_time ();
+			#endif
 			while (wait == 1)
 			{
 				running = 0;
@@ -2426,18 +3063,32 @@ S2 run (void *arg)
 
 				usleep (200);
 			}
+			#if TRACE && __linux__
+			trace_join (trace_start);
+			#endif
 
 			eoffs = 5;
 			break;
 
 		case 2:
 			// lock data_mutex
+			#if TRACE && __linux__
+			trace_start = trace_time ();
+			#endif
 			pthread_mutex_lock (&data_mutex);
+			__atomic_store_n (&data_mutex_owner, cpu_core, __ATOMIC_RELAXED);
+			#if TRACE && __linux__
+			trace_mutex_locked (trace_start);
+			#endif
 			eoffs = 5;
 			break;
 
 		case 3:
 			// unlock data_mutex
+			#if TRACE && __linux__
+			trace_mutex_unlock ();
+			#endif
+			__atomic_store_n (&data_mutex_owner, -1, __ATOMIC_RELAXED);
 			pthread_mutex_unlock (&data_mutex);
 			eoffs = 5;
 			break;
@@ -2476,6 +3127,9 @@ S2 run (void *arg)
 			printf ("thread EXIT\n");
 			arg2 = code[ep + 2];
 			retcode = regi[arg2];
+			#if TRACE && __linux__
+			trace_thread_exit (retcode);
+			#endif
 			pthread_mutex_lock (&data_mutex);
 			threaddata[cpu_core].status = STOP;
 			pthread_mutex_unlock (&data_mutex);
@@ -2488,6 +3142,7 @@ S2 run (void *arg)
 			free (jumpoffs);
 			pthread_exit ((void *) 1);
 	}
+	AOT_NEXT();
 	EXE_NEXT();
 
 	//  superopcodes for counter loops
@@ -2505,6 +3160,8 @@ S2 run (void *arg)
 	regi[arg1]++;
 	if (regi[arg1] < regi[arg2])
 	{
+		AOT_BRANCH(arg3);
+		JIT_HOT_BRANCH(arg3, ep + 11);
 		eoffs = 0;
 		ep = arg3;
 		EXE_NEXT();
@@ -2526,6 +3183,8 @@ S2 run (void *arg)
 	regi[arg1]--;
 	if (regi[arg1] > regi[arg2])
 	{
+		AOT_BRANCH(arg3);
+		JIT_HOT_BRANCH(arg3, ep + 11);
 		eoffs = 0;
 		ep = arg3;
 		EXE_NEXT();
@@ -2621,6 +3280,7 @@ S2 run (void *arg)
 	eoffs = 0;
 	ep = arg1;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	jsra:
@@ -2648,6 +3308,7 @@ S2 run (void *arg)
 	eoffs = 0;
 	ep = regi[arg1];
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	rts:
@@ -2659,6 +3320,7 @@ S2 run (void *arg)
 	eoffs = 0;
 	jumpstack_ind--;
 
+	AOT_NEXT();
 	EXE_NEXT();
 
 	load:
@@ -2707,25 +3369,481 @@ S2 run (void *arg)
 
 	//printf ("arg2: %li\n", arg2);
 
-	arg3 = code[ep + 17];
+	arg3 = code[ep + 17];
+
+	regi[arg3] = arg1 + arg2;
+
+	eoffs = 18;
+	EXE_NEXT();
+
+
+    noti:
+	#if DEBUG
+	printf ("%lli NOTI\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = code[ep + 2];
+
+	regi[arg2] = ! regi[arg1];
+
+	eoffs = 3;
+	EXE_NEXT();
+
+	jmpt:
+	#if DEBUG
+	printf ("%lli JMPT\n", cpu_core);
+	#endif
+	// jump table: index register, number of entries, default target
+	// the entries are the jmp opcodes after jmpt, the index is not in range: jump to default
+	arg1 = code[ep + 1];
+	arg2 = code[ep + 2];
+
+	if (regi[arg1] >= 0 && regi[arg1] < arg2)
+	{
+		arg3 = jumpoffs[ep + 11 + (regi[arg1] * 9)];
+	}
+	else
+	{
+		arg3 = jumpoffs[ep];
+	}
+	AOT_BRANCH(arg3);
+
+	eoffs = 0;
+	ep = arg3;
+	#if DEBUG
+	printf ("%lli JUMP TO %lli\n", cpu_core, ep);
+	#endif
+	EXE_NEXT();
+
+	// push/pull with scaled index: the index register is multiplied by the element size
+	pushws:
+	#if DEBUG
+	printf ("%lli PUSHWS\n", cpu_core);
+	#endif
+	arg1 = regi[code[ep + 1]];
+	arg2 = regi[code[ep + 2]] * sizeof (S2);
+	arg3 = code[ep + 3];
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg1, arg2) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	regi[arg3] = 0;		// set to zero, before loading data
+	bptr = (U1 *) &regi[arg3];
+
+	*bptr = data[arg1 + arg2];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 1];
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	pushdws:
+	#if DEBUG
+	printf ("%lli PUSHDWS\n", cpu_core);
+	#endif
+	arg1 = regi[code[ep + 1]];
+	arg2 = regi[code[ep + 2]] * sizeof (S4);
+	arg3 = code[ep + 3];
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg1, arg2) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	regi[arg3] = 0;		// set to zero, before loading data
+	bptr = (U1 *) &regi[arg3];
+
+	*bptr = data[arg1 + arg2];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 1];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 2];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 3];
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	pushqws:
+	#if DEBUG
+	printf ("%lli PUSHQWS\n", cpu_core);
+	#endif
+	arg1 = regi[code[ep + 1]];
+	arg2 = regi[code[ep + 2]] * sizeof (S8);
+	arg3 = code[ep + 3];
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg1, arg2) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	bptr = (U1 *) &regi[arg3];
+
+	*bptr = data[arg1 + arg2];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 1];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 2];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 3];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 4];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 5];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 6];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 7];
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	pushds:
+	#if DEBUG
+	printf ("%lli PUSHDS\n", cpu_core);
+	#endif
+	arg1 = regi[code[ep + 1]];
+	arg2 = regi[code[ep + 2]] * sizeof (F8);
+	arg3 = code[ep + 3];
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg1, arg2) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	bptr = (U1 *) &regd[arg3];
+
+	*bptr = data[arg1 + arg2];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 1];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 2];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 3];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 4];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 5];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 6];
+	bptr++;
+	*bptr = data[arg1 + arg2 + 7];
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	pullws:
+	#if DEBUG
+	printf ("%lli PULLWS\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = regi[code[ep + 2]];
+	arg3 = regi[code[ep + 3]] * sizeof (S2);
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg2, arg3) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	bptr = (U1 *) &regi[arg1];
+
+	data[arg2 + arg3] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 1] = *bptr;
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	pulldws:
+	#if DEBUG
+	printf ("%lli PULLDWS\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = regi[code[ep + 2]];
+	arg3 = regi[code[ep + 3]] * sizeof (S4);
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg2, arg3) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	bptr = (U1 *) &regi[arg1];
+
+	data[arg2 + arg3] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 1] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 2] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 3] = *bptr;
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	pullqws:
+	#if DEBUG
+	printf ("%lli PULLQWS\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = regi[code[ep + 2]];
+	arg3 = regi[code[ep + 3]] * sizeof (S8);
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg2, arg3) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	bptr = (U1 *) &regi[arg1];
+
+	data[arg2 + arg3] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 1] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 2] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 3] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 4] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 5] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 6] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 7] = *bptr;
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	pullds:
+	#if DEBUG
+	printf ("%lli PULLDS\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = regi[code[ep + 2]];
+	arg3 = regi[code[ep + 3]] * sizeof (F8);
+
+	#if BOUNDSCHECK
+	if (memory_bounds (arg2, arg3) != 0)
+	{
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	#endif
+
+	bptr = (U1 *) &regd[arg1];
+
+	data[arg2 + arg3] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 1] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 2] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 3] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 4] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 5] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 6] = *bptr;
+	bptr++;
+	data[arg2 + arg3 + 7] = *bptr;
+
+	eoffs = 4;
+	EXE_NEXT();
+
+	// stack push/pop of a register range: one bounds check, the same stack layout as stpushi/stpopi
+	// stpushi/stpopi store the bytes reversed on every host, so the range is copied with one bswap per register
+	stpushir:
+	#if DEBUG
+	printf("%lli STPUSHIR\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = code[ep + 2];
+
+	if (sp < sp_bottom + ((arg2 - arg1 + 1) * 8))
+	{
+		printf ("FATAL ERROR: stack pointer can't go below address 0!\n");
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+
+	for (arg3 = arg1; arg3 <= arg2; arg3++)
+	{
+		// byte order reversed, as by stpushi
+		memcpy (&arg4, &regi[arg3], sizeof (S8));
+		arg4 = __builtin_bswap64 (arg4);
+		sp -= 8;
+		memcpy (sp, &arg4, sizeof (S8));
+	}
+
+	eoffs = 3;
+
+	AOT_NEXT();
+	EXE_NEXT();
+
+	stpopir:
+	#if DEBUG
+	printf("%lli STPOPIR\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = code[ep + 2];
+
+	if (sp + ((arg2 - arg1 + 1) * 8) > sp_top)
+	{
+		// nothing on stack!! can't pop!!
+
+		printf ("FATAL ERROR: stack pointer can't pop empty stack!\n");
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+
+	for (arg3 = arg2; arg3 >= arg1; arg3--)
+	{
+		memcpy (&arg4, sp, sizeof (S8));
+		arg4 = __builtin_bswap64 (arg4);
+		memcpy (&regi[arg3], &arg4, sizeof (S8));
+		sp += 8;
+	}
+
+	eoffs = 3;
+
+	AOT_NEXT();
+	EXE_NEXT();
+
+	stpushdr:
+	#if DEBUG
+	printf("%lli STPUSHDR\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = code[ep + 2];
+
+	if (sp < sp_bottom + ((arg2 - arg1 + 1) * 8))
+	{
+		printf ("FATAL ERROR: stack pointer can't go below address 0!\n");
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+
+	for (arg3 = arg1; arg3 <= arg2; arg3++)
+	{
+		// byte order reversed, as by stpushd
+		memcpy (&arg4, &regd[arg3], sizeof (S8));
+		arg4 = __builtin_bswap64 (arg4);
+		sp -= 8;
+		memcpy (sp, &arg4, sizeof (S8));
+	}
+
+	eoffs = 3;
+
+	AOT_NEXT();
+	EXE_NEXT();
+
+	stpopdr:
+	#if DEBUG
+	printf("%lli STPOPDR\n", cpu_core);
+	#endif
+	arg1 = code[ep + 1];
+	arg2 = code[ep + 2];
+
+	if (sp + ((arg2 - arg1 + 1) * 8) > sp_top)
+	{
+		// nothing on stack!! can't pop!!
+
+		printf ("FATAL ERROR: stack pointer can't pop empty stack!\n");
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+
+	for (arg3 = arg2; arg3 >= arg1; arg3--)
+	{
+		memcpy (&arg4, sp, sizeof (S8));
+		arg4 = __builtin_bswap64 (arg4);
+		memcpy (&regd[arg3], &arg4, sizeof (S8));
+		sp += 8;
+	}
 
-	regi[arg3] = arg1 + arg2;
+	eoffs = 3;
 
-	eoffs = 18;
+	AOT_NEXT();
 	EXE_NEXT();
 
-
-    noti:
+	shli:
 	#if DEBUG
-	printf ("%lli NOTI\n", cpu_core);
+	printf ("%lli SHLI\n", cpu_core);
 	#endif
+	// shift left by the number of bits in arg2: multiply by power of two
 	arg1 = code[ep + 1];
-	arg2 = code[ep + 2];
+	arg2 = code[ep + 2] & 63;
+	arg3 = code[ep + 3];
 
-	regi[arg2] = ! regi[arg1];
+	#if MATH_LIMITS
+		if (__builtin_smulll_overflow (regi[arg1], 1LL << arg2, &regi[arg3]))
+		{
+			overflow = 1;
+ 			printf ("ERROR: overflow at shli!\n");
+			PRINT_EPOS();
+		}
+		else
+		{
+			 overflow = 0;
+		}
+	#else
+		regi[arg3] = regi[arg1] << arg2;
+	#endif
 
-	eoffs = 3;
+	eoffs = 4;
+	EXE_NEXT();
+
+#if AOT_LOAD && __linux__
+	aot_run:
+	// run native code made by l1aot at ep
+	jit_context.data = data;
+	ep = run_aot (ep, &jit_context);
+	if (ep == JIT_EXIT_ERROR)
+	{
+		ep = jit_context.error_ep;
+		PRINT_EPOS();
+		free (jumpoffs);
+		pthread_exit ((void *) 1);
+	}
+	eoffs = 0;
 	EXE_NEXT();
+#endif
 }
 
 void break_handler (void)
@@ -2777,16 +3895,263 @@ void free_modules (void)
 
 void show_info (void)
 {
-	printf ("l1vm <program> [-C cpu_cores] [-S stacksize] [-q] <-args> <cmd args>\n");
+	printf ("l1vm <program> [-C cpu_cores] [-S stacksize] [-q] [-H] [-R] [-P] [-s] [-t] [-m] [-j] [-F] [-U socket] <-args> <cmd args>\n");
 	printf ("-C cores : set maximum of threads that can be run\n");
 	printf ("-S stacksize : set the stack size\n");
-	printf ("-q : quiet run, don't show welcome messages\n\n");
+	printf ("-q : quiet run, don't show welcome messages\n");
+	printf ("-H : use huge pages for code and data, if available\n");
+	printf ("-R : hot code reload of the object file on SIGHUP, done at intr0 27\n");
+	printf ("-P : profile, write prog.l1prof and prog.l1folded at exit\n");
+	printf ("-s : module call statistics, write prog.l1modstat at exit and on SIGUSR2\n");
+	printf ("-t : thread trace, write prog.trace.json in Chrome trace event format at exit\n");
+	printf ("-m : perf support, write /tmp/perf-PID.map for JIT code and the epos log /tmp/perf-PID.l1ep\n");
+	printf ("-j : perf support, write /tmp/jit-PID.dump for 'perf inject --jit'\n");
+	printf ("-F : pre-fork server, read one request (program arguments) per line from stdin\n");
+	printf ("-U socket : pre-fork server, read one request per connection on Unix socket\n\n");
 	printf ("program arguments for the program must be set by '-args':\n");
 	printf ("l1vm programname -args foo bar\n");
 	printf ("%s", VM_VERSION_STR);
 	printf ("%s\n", COPYRIGHT_STR);
 }
 
+S8 run_main_thread (void)
+{
+	// start program on CPU 0 and wait for it
+	pthread_t id;
+	S8 new_cpu ALIGN = 0;
+
+	threaddata[new_cpu].sp = (U1 *) data + (data_mem_size - ((max_cpu - 1) * stack_size) - 1);
+	threaddata[new_cpu].sp_top = threaddata[new_cpu].sp;
+	threaddata[new_cpu].sp_bottom = threaddata[new_cpu].sp_top - stack_size + 1;
+
+	threaddata[new_cpu].sp_thread = threaddata[new_cpu].sp + (new_cpu * stack_size);
+	threaddata[new_cpu].sp_top_thread = threaddata[new_cpu].sp_top + (new_cpu * stack_size);
+	threaddata[new_cpu].sp_bottom_thread = threaddata[new_cpu].sp_bottom + (new_cpu * stack_size);
+	threaddata[new_cpu].ep_startpos = 16;
+
+    if (pthread_create (&id, NULL, (void *) run, (void *) new_cpu) != 0)
+	{
+		printf ("ERROR: can't start main thread!\n");
+		return (1);
+	}
+    pthread_join (id, NULL);
+	return (retcode);
+}
+
+#if __linux__
+S2 set_shell_args (U1 *line)
+{
+	// split request line into shell arguments, like the ones following "-args"
+	S8 i ALIGN = 0;
+	S8 j ALIGN;
+
+	shell_args_ind = -1;
+	while (line[i] != '\0')
+	{
+		while (line[i] == ' ' || line[i] == '\t')
+		{
+			i++;
+		}
+		if (line[i] == '\0' || line[i] == '\n' || line[i] == '\r')
+		{
+			break;
+		}
+
+		if (shell_args_ind == MAXSHELLARGS - 1)
+		{
+			printf ("ERROR: server: too many shell arguments!\n");
+			return (1);
+		}
+		shell_args_ind++;
+
+		j = 0;
+		while (line[i] != '\0' && line[i] != ' ' && line[i] != '\t' && line[i] != '\n' && line[i] != '\r')
+		{
+			if (j == MAXSHELLARGLEN - 1)
+			{
+				printf ("ERROR: server: shell argument too long!\n");
+				return (1);
+			}
+			shell_args[shell_args_ind][j] = line[i];
+			i++; j++;
+		}
+		shell_args[shell_args_ind][j] = '\0';
+	}
+	return (0);
+}
+
+S2 run_server_stdin (void)
+{
+	// object and modules are loaded once, every request line runs in a forked copy-on-write child
+	U1 line[MAXLINELEN];
+	pid_t pid;
+	int status;
+	int devnull;
+	S8 ret ALIGN;
+
+	while (fgets ((char *) line, MAXLINELEN, stdin) != NULL)
+	{
+		fflush (stdout);
+		pid = fork ();
+		if (pid == -1)
+		{
+			printf ("ERROR: server: can't fork!\n");
+			return (1);
+		}
+
+		if (pid == 0)
+		{
+			// child: stdin belongs to the request stream
+			devnull = open ("/dev/null", O_RDONLY);
+			if (devnull != -1)
+			{
+				dup2 (devnull, STDIN_FILENO);
+				close (devnull);
+			}
+
+			if (set_shell_args (line) != 0)
+			{
+				fflush (stdout);
+				_exit (1);
+			}
+			ret = run_main_thread ();
+			cleanup ();
+			fflush (stdout);
+			_exit (ret);
+		}
+
+		if (waitpid (pid, &status, 0) == -1)
+		{
+			printf ("ERROR: server: waitpid failed!\n");
+			return (1);
+		}
+
+		ret = 1;
+		if (WIFEXITED (status))
+		{
+			ret = WEXITSTATUS (status);
+		}
+		// end of request marker
+		printf ("exit: %lli\n", ret);
+		fflush (stdout);
+	}
+	return (0);
+}
+
+S2 run_server_socket (U1 *path)
+{
+	// every connection gets a forked child: the first line is the request, then socket is stdin/stdout
+	struct sockaddr_un addr;
+	int server_fd;
+	int client_fd;
+	pid_t pid;
+	U1 line[MAXLINELEN];
+	S8 i ALIGN;
+	S8 ret ALIGN;
+	char ch;
+
+	if (strlen_safe ((const char *) path, MAXLINELEN) >= sizeof (addr.sun_path))
+	{
+		printf ("ERROR: server: socket path too long!\n");
+		return (1);
+	}
+
+	server_fd = socket (AF_UNIX, SOCK_STREAM, 0);
+	if (server_fd == -1)
+	{
+		printf ("ERROR: server: can't create socket!\n");
+		return (1);
+	}
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	strcpy (addr.sun_path, (const char *) path);
+	unlink ((const char *) path);
+
+	if (bind (server_fd, (struct sockaddr *) &addr, sizeof (addr)) == -1)
+	{
+		printf ("ERROR: server: can't bind socket '%s'!\n", path);
+		close (server_fd);
+		return (1);
+	}
+
+	if (listen (server_fd, SOMAXCONN) == -1)
+	{
+		printf ("ERROR: server: can't listen on socket '%s'!\n", path);
+		close (server_fd);
+		return (1);
+	}
+
+	// children are reaped automatically
+	signal (SIGCHLD, SIG_IGN);
+
+	if (silent_run == 0)
+	{
+		printf ("server: listening on '%s'\n", path);
+	}
+	fflush (stdout);
+
+	while (1)
+	{
+		client_fd = accept (server_fd, NULL, NULL);
+		if (client_fd == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			printf ("ERROR: server: accept failed!\n");
+			close (server_fd);
+			return (1);
+		}
+
+		pid = fork ();
+		if (pid == -1)
+		{
+			printf ("ERROR: server: can't fork!\n");
+			close (client_fd);
+			continue;
+		}
+
+		if (pid == 0)
+		{
+			close (server_fd);
+			signal (SIGCHLD, SIG_DFL);
+
+			// read request line byte by byte, so no program input gets lost in a buffer
+			i = 0;
+			while (i < MAXLINELEN - 1)
+			{
+				if (read (client_fd, &ch, 1) != 1 || ch == '\n')
+				{
+					break;
+				}
+				line[i] = ch;
+				i++;
+			}
+			line[i] = '\0';
+
+			dup2 (client_fd, STDIN_FILENO);
+			dup2 (client_fd, STDOUT_FILENO);
+			close (client_fd);
+
+			if (set_shell_args (line) != 0)
+			{
+				fflush (stdout);
+				_exit (1);
+			}
+			ret = run_main_thread ();
+			cleanup ();
+			fflush (stdout);
+			_exit (ret);
+		}
+
+		close (client_fd);
+	}
+	return (0);
+}
+#endif
+
 int main (int ac, char *av[])
 {
 	S8 i ALIGN;
@@ -2796,9 +4161,6 @@ int main (int ac, char *av[])
 	U1 cmd_args = 0;		// switched to one, if arguments follow
 
 	U1 av_found = 0;
-	pthread_t id;
-
-	S8 new_cpu ALIGN;
 
 	// do compilation time sense check on integer 64 bit and double 64 bit type!!
 	S8 size_int64 ALIGN;
@@ -2819,6 +4181,9 @@ int main (int ac, char *av[])
 		exit (1);
 	}
 
+	// clear module table before "-M" modules get loaded
+	init_modules ();
+
 	// printf ("DEBUG: ac: %i\n", ac);
 
     if (ac > 1)
@@ -2893,6 +4258,77 @@ int main (int ac, char *av[])
 								av_found = 1;
 							}
 
+							if (strcmp (av[i], "-F") == 0)
+							{
+								// pre-fork server, requests on stdin
+								server_mode = SERVER_STDIN;
+								av_found = 1;
+							}
+
+							if (av[i][0] == '-' && av[i][1] == 'U')
+							{
+								// pre-fork server, requests on Unix socket
+								if (i + 1 >= ac || strlen_safe (av[i + 1], MAXLINELEN) >= MAXLINELEN - 1)
+								{
+									printf ("ERROR: server socket name missing or too long!\n");
+									cleanup ();
+									exit (1);
+								}
+								strcpy ((char *) server_socket_path, av[i + 1]);
+								server_mode = SERVER_SOCKET;
+								av_found = 1;
+							}
+
+							if (av[i][0] == '-' && av[i][1] == 'H')
+							{
+								// huge pages for code and data segments
+								huge_pages = 1;
+							}
+
+							if (av[i][0] == '-' && av[i][1] == 'R')
+							{
+								// hot code reload on SIGHUP
+								reload_enabled = 1;
+							}
+
+							#if PROFILE && __linux__
+							if (av[i][0] == '-' && av[i][1] == 'P')
+							{
+								// sampling profiler
+								profile_run = 1;
+							}
+							#endif
+
+							#if TRACE && __linux__
+							if (av[i][0] == '-' && av[i][1] == 't')
+							{
+								// thread trace
+								trace_run = 1;
+							}
+							#endif
+
+							#if MODULE_STATS && __linux__
+							if (av[i][0] == '-' && av[i][1] == 's')
+							{
+								// module call statistics
+								module_stats_run = 1;
+							}
+							#endif
+
+							#if PERF_MAP && PROFILE && __linux__
+							if (av[i][0] == '-' && av[i][1] == 'm')
+							{
+								// perf map and epos log
+								perf_run = 1;
+							}
+
+							if (av[i][0] == '-' && av[i][1] == 'j')
+							{
+								// perf jitdump
+								perf_jitdump = 1;
+							}
+							#endif
+
 							if (av[i][0] == '-' && av[i][1] == '?')
 							{
 								// user needs help, show arguments info and exit
@@ -3001,7 +4437,7 @@ int main (int ac, char *av[])
 		printf ("build on: %s\n", __DATE__);
 
 		#if JIT_COMPILER
-	    	printf ("JIT-compiler inside: lib asmjit.\n");
+	    	get_jit_compiler_type ();
 		#endif
 
 		#if MATH_LIMITS
@@ -3030,9 +4466,83 @@ int main (int ac, char *av[])
         exit (1);
     }
 
-    init_modules ();
+	#if JIT_COMPILER && JIT_HOT_LOOPS
+	if (alloc_jit_hot () != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+	#endif
+
+	#if AOT_LOAD && __linux__
+	if (load_aot ((U1 *) av[1]) != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+	#endif
+
+	if (huge_pages == 1)
+	{
+		show_huge_pages ();
+	}
+
+	if (strlen_safe (av[1], MAXLINELEN) < 512)
+	{
+		strcpy ((char *) object_name, av[1]);
+	}
+
+	if (reload_enabled == 1)
+	{
+		// variable names are needed to check the data layout of the new object
+		load_data_names (object_name);
+#if __linux__
+		signal (SIGHUP, reload_handler);
+#endif
+	}
+
 	signal (SIGINT, (void *) break_handler);
 
+#if OPCODE_COUNT
+	if (opcode_count_init (object_name) != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+#endif
+
+#if PROFILE && __linux__
+	if (profile_run == 1 && profile_start () != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+#endif
+
+#if TRACE && __linux__
+	if (trace_run == 1 && trace_init () != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+#endif
+
+#if MODULE_STATS && __linux__
+	if (module_stats_run == 1 && module_stats_start (object_name) != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+#endif
+
+#if PERF_MAP && PROFILE && __linux__
+	if (perf_start (object_name) != 0)
+	{
+		cleanup ();
+		exit (1);
+	}
+#endif
+
 	// set all higher threads as STOPPED = unused
 	for (i = 1; i < max_cpu; i++)
 	{
@@ -3040,24 +4550,23 @@ int main (int ac, char *av[])
 	}
 	threaddata[0].status = RUNNING;		// main thread will run
 
-	new_cpu = 0;
-
-	threaddata[new_cpu].sp = (U1 *) &data + (data_mem_size - ((max_cpu - 1) * stack_size) - 1);
-	threaddata[new_cpu].sp_top = threaddata[new_cpu].sp;
-	threaddata[new_cpu].sp_bottom = threaddata[new_cpu].sp_top - stack_size + 1;
-
-	threaddata[new_cpu].sp_thread = threaddata[new_cpu].sp + (new_cpu * stack_size);
-	threaddata[new_cpu].sp_top_thread = threaddata[new_cpu].sp_top + (new_cpu * stack_size);
-	threaddata[new_cpu].sp_bottom_thread = threaddata[new_cpu].sp_bottom + (new_cpu * stack_size);
-	threaddata[new_cpu].ep_startpos = 16;
+#if __linux__
+	if (server_mode == SERVER_STDIN)
+	{
+		retcode = run_server_stdin ();
+		cleanup ();
+		exit (retcode);
+	}
 
-    if (pthread_create (&id, NULL, (void *) run, (void *) new_cpu) != 0)
+	if (server_mode == SERVER_SOCKET)
 	{
-		printf ("ERROR: can't start main thread!\n");
+		retcode = run_server_socket (server_socket_path);
 		cleanup ();
-		exit (1);
+		exit (retcode);
 	}
-    pthread_join (id, NULL);
+#endif
+
+	retcode = run_main_thread ();
 	cleanup ();
 	exit (retcode);
 }
@@ -1,6 +1,6 @@
 #!/bin/sh
 # set vm/main.c JIT_COMPILER to 0 and compile using this script
-if clang -Wall main.c load-object.c ../lib-func/string.c ../lib-func/code_datasize.c -o l1vm-cli -lm -ldl -lpthread -O2 -g -march=native -fomit-frame-pointer -Wl,--export-dynamic; then
+if clang -Wall main.c load-object.c profile.c opcount.c perf.c debug-info.c modstats.c trace.c ../lib-func/string.c ../lib-func/code_datasize.c ../lib-func/code_hash.c -o l1vm-cli -lm -ldl -lpthread -O2 -g -march=native -fomit-frame-pointer -Wl,--export-dynamic; then
 	exit 0
 else
 	exit 1
@@ -1,3 +1,3 @@
 #!/bin/sh
 
-clang main.c load-object.c ../lib-func/string.c ../lib-func/code_datasize.c -o l1vm -lpthread -Os -fomit-frame-pointer -funit-at-a-time -s -Wl,--export-all-symbols -mwindows -mconsole
+clang main.c load-object.c profile.c opcount.c perf.c debug-info.c modstats.c trace.c ../lib-func/string.c ../lib-func/code_datasize.c ../lib-func/code_hash.c -o l1vm -lpthread -Os -fomit-frame-pointer -funit-at-a-time -s -Wl,--export-all-symbols -mwindows -mconsole
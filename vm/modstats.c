@@ -0,0 +1,272 @@
+/*
+ * This file modstats.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1vm RISC VM
+//
+//  module call statistics: "-s" flag
+//
+//  call_module_func () counts the calls, the total and the maximal wall time of every
+//  module function. A module function can add the bytes it did move by:
+//
+//  extern void module_stats_bytes (S8 bytes) __attribute__ ((weak));
+//  if (module_stats_bytes) module_stats_bytes (len);
+//
+//  The report is written to prog.l1modstat at exit and on SIGUSR2, intr0 30 prints it.
+
+#include "../include/global.h"
+
+#if MODULE_STATS && __linux__
+#include <signal.h>
+#include <time.h>
+
+#define MODULE_STATS_NAMELEN	64
+
+struct module_stat
+{
+	S8 calls ALIGN;
+	S8 time ALIGN;			// nanoseconds
+	S8 time_max ALIGN;
+	S8 bytes ALIGN;
+	U1 module[MODULE_STATS_NAMELEN];
+	U1 func[MODULE_STATS_NAMELEN];
+};
+
+U1 module_stats_run = 0;					// "-s" flag
+
+static struct module_stat *module_stat[MODULES];
+static __thread struct module_stat *module_stat_cur = NULL;		// function called by this thread
+static U1 *module_stats_name = NULL;
+static pthread_mutex_t module_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static S8 module_stats_time (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((S8) ts.tv_sec * 1000000000LL + ts.tv_nsec);
+}
+
+// called by set_module_func (): name the statistics entry of the function
+void module_stats_set (S8 ind, S8 func_ind, U1 *module_name, U1 *func_name)
+{
+	struct module_stat *stat;
+	U1 *name;
+
+	if (module_stats_run == 0 || ind < 0 || ind >= MODULES || func_ind < 0 || func_ind >= MODULES_MAXFUNC)
+	{
+		return;
+	}
+
+	pthread_mutex_lock (&module_stats_mutex);
+	if (module_stat[ind] == NULL)
+	{
+		module_stat[ind] = (struct module_stat *) calloc (MODULES_MAXFUNC, sizeof (struct module_stat));
+		if (module_stat[ind] == NULL)
+		{
+			pthread_mutex_unlock (&module_stats_mutex);
+			printf ("module stats: ERROR: can't allocate memory!\n");
+			return;
+		}
+	}
+
+	// only the file name of the module
+	name = (U1 *) strrchr ((const char *) module_name, '/');
+	name = name ? name + 1 : module_name;
+
+	stat = &module_stat[ind][func_ind];
+	if (strncmp ((const char *) stat->module, (const char *) name, MODULE_STATS_NAMELEN - 1) != 0 || strncmp ((const char *) stat->func, (const char *) func_name, MODULE_STATS_NAMELEN - 1) != 0)
+	{
+		// new function at this place
+		memset (stat, 0, sizeof (struct module_stat));
+		strncpy ((char *) stat->module, (const char *) name, MODULE_STATS_NAMELEN - 1);
+		strncpy ((char *) stat->func, (const char *) func_name, MODULE_STATS_NAMELEN - 1);
+	}
+	pthread_mutex_unlock (&module_stats_mutex);
+}
+
+S8 module_stats_begin (S8 ind, S8 func_ind)
+{
+	if (ind >= 0 && ind < MODULES && func_ind >= 0 && func_ind < MODULES_MAXFUNC && module_stat[ind] != NULL)
+	{
+		module_stat_cur = &module_stat[ind][func_ind];
+	}
+	else
+	{
+		module_stat_cur = NULL;
+	}
+	return (module_stats_time ());
+}
+
+void module_stats_end (S8 start)
+{
+	struct module_stat *stat = module_stat_cur;
+	S8 time ALIGN;
+	S8 max ALIGN;
+
+	if (stat == NULL)
+	{
+		return;
+	}
+	module_stat_cur = NULL;
+
+	time = module_stats_time () - start;
+	__sync_fetch_and_add (&stat->calls, 1);
+	__sync_fetch_and_add (&stat->time, time);
+	max = stat->time_max;
+	while (time > max && ! __sync_bool_compare_and_swap (&stat->time_max, max, time))
+	{
+		max = stat->time_max;
+	}
+}
+
+// called by module functions: bytes read, written or copied by the running call
+void module_stats_bytes (S8 bytes)
+{
+	if (module_stat_cur)
+	{
+		__sync_fetch_and_add (&module_stat_cur->bytes, bytes);
+	}
+}
+
+static int compare_time (const void *a, const void *b)
+{
+	const struct module_stat *sa = *(const struct module_stat **) a;
+	const struct module_stat *sb = *(const struct module_stat **) b;
+
+	if (sa->time < sb->time) return (1);
+	if (sa->time > sb->time) return (-1);
+	return (0);
+}
+
+void module_stats_print (FILE *fptr)
+{
+	struct module_stat **list;
+	S8 n ALIGN = 0;
+	S8 i ALIGN;
+	S8 j ALIGN;
+
+	if (module_stats_run == 0)
+	{
+		fprintf (fptr, "module stats: not enabled, run the VM with '-s'\n");
+		return;
+	}
+
+	list = (struct module_stat **) malloc (MODULES * MODULES_MAXFUNC * sizeof (struct module_stat *));
+	if (list == NULL)
+	{
+		fprintf (fptr, "module stats: ERROR: can't allocate memory!\n");
+		return;
+	}
+
+	pthread_mutex_lock (&module_stats_mutex);
+	for (i = 0; i < MODULES; i++)
+	{
+		if (module_stat[i] == NULL) continue;
+		for (j = 0; j < MODULES_MAXFUNC; j++)
+		{
+			if (module_stat[i][j].calls > 0)
+			{
+				list[n] = &module_stat[i][j];
+				n++;
+			}
+		}
+	}
+	qsort (list, n, sizeof (struct module_stat *), compare_time);
+
+	fprintf (fptr, "module calls: sorted by total time\n");
+	fprintf (fptr, "       calls    total ms      avg us      max us           bytes  module function\n");
+	for (i = 0; i < n; i++)
+	{
+		fprintf (fptr, "%12lli  %10.3f  %10.3f  %10.3f  %14lli  %s %s\n", list[i]->calls, (F8) list[i]->time / 1000000.0,
+			(F8) list[i]->time / (F8) list[i]->calls / 1000.0, (F8) list[i]->time_max / 1000.0, list[i]->bytes, list[i]->module, list[i]->func);
+	}
+	pthread_mutex_unlock (&module_stats_mutex);
+	free (list);
+}
+
+void module_stats_write (void)
+{
+	FILE *fptr;
+	U1 file_name[512];
+
+	if (module_stats_run == 0 || module_stats_name == NULL)
+	{
+		return;
+	}
+
+	snprintf ((char *) file_name, 512, "%s.l1modstat", module_stats_name);
+	fptr = fopen ((const char *) file_name, "w");
+	if (fptr == NULL)
+	{
+		printf ("module stats: ERROR: can't write '%s'!\n", file_name);
+		return;
+	}
+	module_stats_print (fptr);
+	fclose (fptr);
+	printf ("module stats: written to %s\n", file_name);
+}
+
+static void *module_stats_signal (void *arg)
+{
+	sigset_t set;
+	int sig;
+
+	sigemptyset (&set);
+	sigaddset (&set, SIGUSR2);
+	while (1)
+	{
+		if (sigwait (&set, &sig) == 0)
+		{
+			module_stats_write ();
+		}
+	}
+	return (NULL);
+}
+
+S2 module_stats_start (U1 *name)
+{
+	pthread_t id;
+	sigset_t set;
+
+	module_stats_name = name;
+
+	// SIGUSR2 is only taken by the report thread: block it before the VM threads are started
+	sigemptyset (&set);
+	sigaddset (&set, SIGUSR2);
+	pthread_sigmask (SIG_BLOCK, &set, NULL);
+	if (pthread_create (&id, NULL, module_stats_signal, NULL) != 0)
+	{
+		printf ("module stats: ERROR: can't start signal thread!\n");
+		return (1);
+	}
+	pthread_detach (id);
+	return (0);
+}
+
+void module_stats_free (void)
+{
+	S8 i ALIGN;
+
+	for (i = 0; i < MODULES; i++)
+	{
+		if (module_stat[i]) free (module_stat[i]);
+		module_stat[i] = NULL;
+	}
+}
+#endif
@@ -386,7 +386,7 @@ U1 *open_server_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 
 U1 *open_accept_server (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
-    S2 handle;
+    S8 handle ALIGN;
     S2 connection;
     struct sockaddr_storage client;
     socklen_t addr_size;
@@ -543,7 +543,8 @@ U1 *open_client_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
     U1 port_string[256];
     U1 *hostname;
     S8 hostname_addr ALIGN;
-    S2 handle = -1, port;
+    S2 handle = -1;
+    S8 port ALIGN;
 
     struct addrinfo hints;
     struct addrinfo *servinfo;
@@ -636,7 +637,7 @@ U1 *open_client_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
         return (sp);
     }
 
-    snprintf ((char *) port_string, 256, "%d", port);
+    snprintf ((char *) port_string, 256, "%lli", port);
     // convert integer port number to a string
 
     if ((status = getaddrinfo ((const char *) hostname, (const char *) port_string, &hints, &servinfo)) != 0)
@@ -726,7 +727,7 @@ U1 *open_client_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 
 U1 *close_server_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
-    S2 handle;
+    S8 handle ALIGN;
 
     if (sp == sp_top)
     {
@@ -812,7 +813,7 @@ U1 *close_server_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 
 U1 *close_accept_server (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
-    S2 handle;
+    S8 handle ALIGN;
 
     if (sp == sp_top)
     {
@@ -896,7 +897,7 @@ U1 *close_accept_server (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 
 U1 *close_client_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
-    S2 handle;
+    S8 handle ALIGN;
 
     if (sp == sp_top)
     {
@@ -978,7 +979,7 @@ U1 *close_client_socket (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 
 U1 *get_clientaddr (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
-    S2 handle;
+    S8 handle ALIGN;
     S2 client_len;
     S8 ret_addr ALIGN;
     S8 i ALIGN;
@@ -1471,7 +1472,7 @@ U1 exe_swrite (S4 slist_ind, S4 len)
 U1 *socket_read_byte (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     U1 ret;
-    S2 handle;
+    S8 handle ALIGN;
 
     if (sp == sp_top)
     {
@@ -1534,7 +1535,7 @@ U1 *socket_read_byte (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_read_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
     S8 n ALIGN;
     U1 *ptr;
     S8 value ALIGN;
@@ -1608,7 +1609,7 @@ U1 *socket_read_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_read_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
     F8 n ALIGN;
     U1 *ptr;
     F8 value ALIGN;
@@ -1685,7 +1686,7 @@ U1 *socket_read_string (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 
     S8 ret ALIGN;
     S8 ret_addr ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
     U1 ch;
     S8 slen ALIGN;
     U1 end = FALSE;
@@ -1787,7 +1788,7 @@ U1 *socket_write_byte (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 send_byte ALIGN;
     U1 ret;
-    S2 handle;
+    S8 handle ALIGN;
 
     if (sp == sp_top)
     {
@@ -1829,7 +1830,7 @@ U1 *socket_write_byte (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_write_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
     U1 *ptr;
     S8 n ALIGN;
     S8 send_int64 ALIGN;
@@ -1882,7 +1883,7 @@ U1 *socket_write_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_write_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
     U1 *ptr;
     F8 n ALIGN;
     F8 send_double ALIGN;
@@ -1937,7 +1938,7 @@ U1 *socket_write_string (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 
     S8 ret ALIGN;
     S8 send_addr ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
     U1 end = FALSE;
     S8 i ALIGN = -1;
 
@@ -2198,7 +2199,7 @@ U1 *socket_send_file (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 	S8 i ALIGN;
 	S8 nameaddr ALIGN;;
 	S8 mimetype_addr ALIGN;
-	S2 handle;
+	S8 handle ALIGN;
 
 	FILE *file;
 	U1 file_name[256];
@@ -2745,7 +2746,7 @@ U1 *socket_get_file (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 	S8 j ALIGN;
 	S8 n ALIGN;
 	S8 requestaddr ALIGN;
-	S2 handle;
+	S8 handle ALIGN;
 
 	FILE *file;
 	U1 file_name[256];
@@ -2962,7 +2963,7 @@ U1 *socket_get_file (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_store_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
 	S8 value ALIGN;
 
@@ -3100,7 +3101,7 @@ U1 *socket_store_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_store_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
 	F8 value ALIGN;
 
@@ -3239,7 +3240,7 @@ U1 *socket_store_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_store_string (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
 	S8 value_addr ALIGN;
 
@@ -3366,7 +3367,7 @@ U1 *socket_get_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
 	S8 value ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
 
 	U1 comm[] = "GET INT64";
@@ -3516,7 +3517,7 @@ U1 *socket_get_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
 	F8 value ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
 
 	U1 comm[] = "GET DOUBLE";
@@ -3666,7 +3667,7 @@ U1 *socket_get_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_get_string (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
     S8 return_str_addr ALIGN;
 
@@ -3816,7 +3817,7 @@ U1 *socket_remove_int64 (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
 	S8 value ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
 
 	U1 comm[] = "REMOVE INT64";
@@ -3966,7 +3967,7 @@ U1 *socket_remove_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
 	F8 value ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
 
 	U1 comm[] = "REMOVE DOUBLE";
@@ -4116,7 +4117,7 @@ U1 *socket_remove_double (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_remove_string (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
     S8 return_str_addr ALIGN;
 
@@ -4263,7 +4264,7 @@ U1 *socket_remove_string (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 U1 *socket_get_info (U1 *sp, U1 *sp_top, U1 *sp_bottom, U1 *data)
 {
     S8 ret ALIGN;
-    S2 handle;
+    S8 handle ALIGN;
 	S8 name_addr ALIGN;
     S8 return_var_addr ALIGN;
 	S8 return_type_addr ALIGN;
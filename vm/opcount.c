@@ -0,0 +1,255 @@
+/*
+ * This file opcount.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1vm RISC VM
+//
+//  opcode counters: build with OPCODE_COUNT set to 1 in include/global.h
+//
+//  run() counts every executed opcode, every intr0/intr1 function and every
+//  pair of opcodes which run one after the other, for each VM thread.
+//  The report is written to prog.l1opcount at exit and on SIGUSR1.
+
+#include "../include/global.h"
+
+#if OPCODE_COUNT
+#include <signal.h>
+
+#define OPCODE_COUNT_PAIRS		100		// number of opcode pairs in report
+
+extern struct opcode opcode[];
+extern S8 max_cpu ALIGN;
+
+struct opcode_count *opcode_count = NULL;
+static U1 *opcode_count_name = NULL;
+static pthread_mutex_t opcode_count_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct opcode_count_sort
+{
+	S8 count ALIGN;
+	S2 a;
+	S2 b;
+};
+
+static int compare_count (const void *a, const void *b)
+{
+	const struct opcode_count_sort *ca = (const struct opcode_count_sort *) a;
+	const struct opcode_count_sort *cb = (const struct opcode_count_sort *) b;
+
+	if (ca->count < cb->count) return (1);
+	if (ca->count > cb->count) return (-1);
+	if (ca->a != cb->a) return (ca->a - cb->a);
+	return (ca->b - cb->b);
+}
+
+static void write_count (FILE *fptr, struct opcode_count *count)
+{
+	struct opcode_count_sort *list;
+	S8 n ALIGN = 0;
+	S8 total ALIGN = 0;
+	S8 i ALIGN;
+	S2 a, b;
+
+	list = (struct opcode_count_sort *) calloc ((MAXOPCODES + 1) * MAXOPCODES, sizeof (struct opcode_count_sort));
+	if (list == NULL)
+	{
+		fprintf (fptr, "ERROR: can't allocate memory for report!\n");
+		return;
+	}
+
+	for (a = 0; a < MAXOPCODES; a++)
+	{
+		total = total + count->op[a];
+		if (count->op[a] > 0)
+		{
+			list[n].count = count->op[a];
+			list[n].a = a;
+			n++;
+		}
+	}
+	qsort (list, n, sizeof (struct opcode_count_sort), compare_count);
+
+	fprintf (fptr, "opcodes: %lli\n", total);
+	for (i = 0; i < n; i++)
+	{
+		fprintf (fptr, "%14lli  %6.2f%%  %s\n", list[i].count, (F8) list[i].count * 100.0 / (F8) total, opcode[list[i].a].op);
+	}
+
+	n = 0;
+	for (a = 0; a < 256; a++)
+	{
+		if (count->intr0[a] > 0)
+		{
+			list[n].count = count->intr0[a];
+			list[n].a = 0;
+			list[n].b = a;
+			n++;
+		}
+		if (count->intr1[a] > 0)
+		{
+			list[n].count = count->intr1[a];
+			list[n].a = 1;
+			list[n].b = a;
+			n++;
+		}
+	}
+	qsort (list, n, sizeof (struct opcode_count_sort), compare_count);
+
+	fprintf (fptr, "\ninterrupts:\n");
+	for (i = 0; i < n; i++)
+	{
+		fprintf (fptr, "%14lli  intr%i %i\n", list[i].count, list[i].a, list[i].b);
+	}
+
+	n = 0;
+	for (a = 0; a < MAXOPCODES; a++)
+	{
+		for (b = 0; b < MAXOPCODES; b++)
+		{
+			if (count->pair[a][b] > 0)
+			{
+				list[n].count = count->pair[a][b];
+				list[n].a = a;
+				list[n].b = b;
+				n++;
+			}
+		}
+	}
+	qsort (list, n, sizeof (struct opcode_count_sort), compare_count);
+
+	fprintf (fptr, "\nopcode pairs:\n");
+	for (i = 0; i < n && i < OPCODE_COUNT_PAIRS; i++)
+	{
+		fprintf (fptr, "%14lli  %6.2f%%  %s %s\n", list[i].count, (F8) list[i].count * 100.0 / (F8) total, opcode[list[i].a].op, opcode[list[i].b].op);
+	}
+	free (list);
+}
+
+void opcode_count_write (void)
+{
+	struct opcode_count total;
+	FILE *fptr;
+	U1 file_name[512];
+	S8 cpu ALIGN;
+	S8 ops ALIGN;
+	S2 i, j;
+
+	if (opcode_count == NULL || opcode_count_name == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock (&opcode_count_mutex);
+	snprintf ((char *) file_name, 512, "%s.l1opcount", opcode_count_name);
+	fptr = fopen ((const char *) file_name, "w");
+	if (fptr == NULL)
+	{
+		printf ("opcode count: ERROR: can't write '%s'!\n", file_name);
+		pthread_mutex_unlock (&opcode_count_mutex);
+		return;
+	}
+
+	// the counters of running threads are read without lock: the numbers are not exact
+	memset (&total, 0, sizeof (struct opcode_count));
+	for (cpu = 0; cpu < max_cpu; cpu++)
+	{
+		ops = 0;
+		for (i = 0; i < MAXOPCODES; i++)
+		{
+			ops = ops + opcode_count[cpu].op[i];
+			total.op[i] = total.op[i] + opcode_count[cpu].op[i];
+			for (j = 0; j < MAXOPCODES; j++)
+			{
+				total.pair[i][j] = total.pair[i][j] + opcode_count[cpu].pair[i][j];
+			}
+		}
+		for (i = 0; i < 256; i++)
+		{
+			total.intr0[i] = total.intr0[i] + opcode_count[cpu].intr0[i];
+			total.intr1[i] = total.intr1[i] + opcode_count[cpu].intr1[i];
+		}
+
+		if (ops > 0 && max_cpu > 1)
+		{
+			fprintf (fptr, "thread %lli\n", cpu);
+			write_count (fptr, &opcode_count[cpu]);
+			fprintf (fptr, "\n\n");
+		}
+	}
+
+	fprintf (fptr, "all threads\n");
+	write_count (fptr, &total);
+	fclose (fptr);
+
+	printf ("opcode count: written to %s\n", file_name);
+	pthread_mutex_unlock (&opcode_count_mutex);
+}
+
+#if __linux__
+static void *opcode_count_signal (void *arg)
+{
+	sigset_t set;
+	int sig;
+
+	sigemptyset (&set);
+	sigaddset (&set, SIGUSR1);
+	while (1)
+	{
+		if (sigwait (&set, &sig) == 0)
+		{
+			opcode_count_write ();
+		}
+	}
+	return (NULL);
+}
+#endif
+
+S2 opcode_count_init (U1 *name)
+{
+	#if __linux__
+	pthread_t id;
+	sigset_t set;
+	#endif
+
+	opcode_count = (struct opcode_count *) calloc (max_cpu, sizeof (struct opcode_count));
+	if (opcode_count == NULL)
+	{
+		printf ("opcode count: ERROR: can't allocate counters!\n");
+		return (1);
+	}
+	opcode_count_name = name;
+
+	#if __linux__
+	// SIGUSR1 is only taken by the report thread: block it before the VM threads are started
+	sigemptyset (&set);
+	sigaddset (&set, SIGUSR1);
+	pthread_sigmask (SIG_BLOCK, &set, NULL);
+	if (pthread_create (&id, NULL, opcode_count_signal, NULL) == 0)
+	{
+		pthread_detach (id);
+	}
+	#endif
+	return (0);
+}
+
+void opcode_count_free (void)
+{
+	if (opcode_count) free (opcode_count);
+	opcode_count = NULL;
+}
+#endif
@@ -0,0 +1,57 @@
+#!/bin/bash
+# perf-l1vm.sh: map the perf samples of the interpreter to the labels of the L1VM program
+#
+# $ perf record -k 1 l1vm prog/foo -m
+# $ perf script -F tid,time,ip,sym | vm/perf-l1vm.sh /tmp/perf-PID.l1ep
+#
+# "-k 1" sets the perf clock to CLOCK_MONOTONIC, as used by the epos log of the VM.
+# A sample in run () gets the label of the epos the VM thread was at, as "vm:label".
+# Samples in JIT code already have the names of /tmp/perf-PID.map, other samples keep their symbol.
+# Option "-l" shows the labels with the line of the .l1asm file: "vm:label:line".
+
+if [ $# -lt 1 ] || [ ! -f "$1" ]; then
+	echo "usage: perf script -F tid,time,ip,sym | perf-l1vm.sh /tmp/perf-PID.l1ep [-l]"
+	exit 1
+fi
+
+lines=0
+if [ "$2" = "-l" ]; then
+	lines=1
+fi
+
+awk -v lines=$lines '
+# epos log: time tid epos line label
+FILENAME != "-" {
+	if ($1 ~ /^#/) next
+	n = ++epn[$2]
+	eptime[$2, n] = $1 + 0
+	eplabel[$2, n] = (lines == 1) ? $5 ":" $4 : $5
+	next
+}
+
+# perf script: tid time: [ip] sym
+$2 ~ /:$/ {
+	tid = $1
+	t = substr ($2, 1, length ($2) - 1) + 0
+	sym = $3
+	if (NF >= 4 && $3 ~ /^[0-9a-f]+$/) sym = $4
+	sub (/\+0x.*/, "", sym)
+
+	if (sym ~ /^run(\.|$)/ && epn[tid] > 0) {
+		# last epos of the thread before the sample, the samples are in time order
+		p = ptr[tid]
+		if (p == 0) p = 1
+		while (p < epn[tid] && eptime[tid, p + 1] <= t) p++
+		ptr[tid] = p
+		if (eptime[tid, p] <= t) sym = "vm:" eplabel[tid, p]
+	}
+	count[sym]++
+	total++
+}
+
+END {
+	for (s in count) {
+		printf ("%8i  %6.2f%%  %s\n", count[s], count[s] * 100.0 / total, s)
+	}
+}
+' "$1" - | sort -rn | (echo " samples  percent  symbol"; cat)
@@ -0,0 +1,378 @@
+/*
+ * This file perf.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1vm RISC VM
+//
+//  Linux perf support:
+//
+//  "-m" flag:
+//  /tmp/perf-PID.map		one line for every JIT compiled code range: "address size l1vm_jit:label:start-end"
+//  /tmp/perf-PID.l1ep		epos of the VM threads with CLOCK_MONOTONIC time stamps, used by
+//  						vm/perf-l1vm.sh to map the perf samples in run () to the labels of the program
+//
+//  "-j" flag:
+//  /tmp/jit-PID.dump		jitdump file with the native code, for "perf inject --jit"
+//  						format: linux tools/perf/Documentation/jitdump-specification.txt
+
+#include "../include/global.h"
+
+#if PERF_MAP && PROFILE && __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PERF_EP_BUF_SIZE	1048576		// epos log entries
+#define PERF_EP_INTERVAL	250			// epos log interval in microseconds
+
+#define JITDUMP_MAGIC		0x4A695444
+#define JITDUMP_VERSION		1
+#define JITDUMP_X86_64		62			// ELF EM_X86_64
+#define JIT_CODE_LOAD		0
+#define JIT_CODE_CLOSE		3
+
+struct jitdump_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t total_size;
+	uint32_t elf_mach;
+	uint32_t pad1;
+	uint32_t pid;
+	uint64_t timestamp;
+	uint64_t flags;
+};
+
+struct jitdump_record
+{
+	uint32_t id;
+	uint32_t total_size;
+	uint64_t timestamp;
+};
+
+// followed by the name and the native code
+struct jitdump_code_load
+{
+	struct jitdump_record head;
+	uint32_t pid;
+	uint32_t tid;
+	uint64_t vma;
+	uint64_t code_addr;
+	uint64_t code_size;
+	uint64_t code_index;
+};
+
+struct perf_ep
+{
+	S8 time ALIGN;			// CLOCK_MONOTONIC, nanoseconds
+	S8 tid ALIGN;
+	S8 ep ALIGN;
+};
+
+extern S8 max_cpu ALIGN;
+extern struct profile_thread *profile_thread;
+
+S2 profile_thread_alloc (void);
+S2 debug_info_load (U1 *name);
+S8 debug_info_line (S8 epos);
+void debug_info_label (S8 epos, U1 *name, S8 len);
+
+U1 perf_run = 0;							// "-m" flag
+U1 perf_jitdump = 0;						// "-j" flag
+
+static FILE *perf_map_file = NULL;
+static FILE *jitdump_file = NULL;
+static void *jitdump_mem = NULL;
+static S8 jitdump_mem_size ALIGN = 0;
+static uint64_t jitdump_index = 0;
+static pthread_mutex_t perf_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct perf_ep *perf_ep = NULL;
+static S8 perf_ep_ind ALIGN = 0;
+static S8 perf_ep_dropped ALIGN = 0;
+static volatile U1 perf_ep_stop = 0;
+static U1 perf_ep_running = 0;
+static pthread_t perf_ep_thread;
+
+static S8 perf_time (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((S8) ts.tv_sec * 1000000000LL + ts.tv_nsec);
+}
+
+// read the published epos of the VM threads, only changes are logged
+static void *perf_ep_sampler (void *arg)
+{
+	struct timespec interval;
+	S8 *last_ep;
+	S8 *last_tid;
+	S8 now ALIGN;
+	S8 ep ALIGN;
+	S8 tid ALIGN;
+	S8 cpu ALIGN;
+
+	last_ep = (S8 *) calloc (max_cpu, sizeof (S8));
+	last_tid = (S8 *) calloc (max_cpu, sizeof (S8));
+	if (last_ep == NULL || last_tid == NULL)
+	{
+		printf ("perf: ERROR: can't allocate epos log!\n");
+		if (last_ep) free (last_ep);
+		if (last_tid) free (last_tid);
+		return (NULL);
+	}
+
+	interval.tv_sec = 0;
+	interval.tv_nsec = PERF_EP_INTERVAL * 1000;
+	while (perf_ep_stop == 0)
+	{
+		nanosleep (&interval, NULL);
+		now = perf_time ();
+		for (cpu = 0; cpu < max_cpu; cpu++)
+		{
+			tid = profile_thread[cpu].tid;
+			ep = profile_thread[cpu].ep;
+			if (tid == 0 || (tid == last_tid[cpu] && ep == last_ep[cpu]))
+			{
+				continue;
+			}
+			if (perf_ep_ind >= PERF_EP_BUF_SIZE)
+			{
+				perf_ep_dropped++;
+				continue;
+			}
+			perf_ep[perf_ep_ind].time = now;
+			perf_ep[perf_ep_ind].tid = tid;
+			perf_ep[perf_ep_ind].ep = ep;
+			perf_ep_ind++;
+			last_tid[cpu] = tid;
+			last_ep[cpu] = ep;
+		}
+	}
+	free (last_ep);
+	free (last_tid);
+	return (NULL);
+}
+
+static S2 jitdump_open (void)
+{
+	struct jitdump_header header;
+	U1 name[256];
+	int fd;
+
+	snprintf ((char *) name, 256, "/tmp/jit-%i.dump", (int) getpid ());
+	fd = open ((const char *) name, O_CREAT | O_TRUNC | O_RDWR, 0666);
+	if (fd < 0)
+	{
+		printf ("perf: ERROR: can't open '%s'!\n", name);
+		return (1);
+	}
+
+	// perf finds the jitdump file by this executable mapping of it
+	jitdump_mem_size = sysconf (_SC_PAGESIZE);
+	jitdump_mem = mmap (NULL, jitdump_mem_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+	if (jitdump_mem == MAP_FAILED)
+	{
+		printf ("perf: ERROR: can't map '%s'!\n", name);
+		jitdump_mem = NULL;
+		close (fd);
+		return (1);
+	}
+
+	jitdump_file = fdopen (fd, "w");
+	if (jitdump_file == NULL)
+	{
+		printf ("perf: ERROR: can't open '%s'!\n", name);
+		close (fd);
+		return (1);
+	}
+
+	memset (&header, 0, sizeof (header));
+	header.magic = JITDUMP_MAGIC;
+	header.version = JITDUMP_VERSION;
+	header.total_size = sizeof (header);
+	header.elf_mach = JITDUMP_X86_64;
+	header.pid = getpid ();
+	header.timestamp = perf_time ();
+	fwrite (&header, sizeof (header), 1, jitdump_file);
+	fflush (jitdump_file);
+	return (0);
+}
+
+S2 perf_start (U1 *name)
+{
+	U1 file_name[256];
+
+	if (perf_run == 0 && perf_jitdump == 0)
+	{
+		return (0);
+	}
+
+	// labels for the JIT code names and the epos log
+	debug_info_load (name);
+
+	if (perf_jitdump == 1 && jitdump_open () != 0)
+	{
+		return (1);
+	}
+
+	if (perf_run == 0)
+	{
+		return (0);
+	}
+
+	snprintf ((char *) file_name, 256, "/tmp/perf-%i.map", (int) getpid ());
+	perf_map_file = fopen ((const char *) file_name, "w");
+	if (perf_map_file == NULL)
+	{
+		printf ("perf: ERROR: can't open '%s'!\n", file_name);
+		return (1);
+	}
+
+	perf_ep = (struct perf_ep *) calloc (PERF_EP_BUF_SIZE, sizeof (struct perf_ep));
+	if (perf_ep == NULL || profile_thread_alloc () != 0)
+	{
+		printf ("perf: ERROR: can't allocate epos log!\n");
+		return (1);
+	}
+
+	if (pthread_create (&perf_ep_thread, NULL, perf_ep_sampler, NULL) != 0)
+	{
+		printf ("perf: ERROR: can't start epos log thread!\n");
+		return (1);
+	}
+	perf_ep_running = 1;
+	return (0);
+}
+
+// called by the JIT compiler for every new code range
+void perf_jit_code (U1 *fn, S8 size, S8 start, S8 end)
+{
+	struct jitdump_code_load load;
+	U1 label[256];
+	U1 name[512];
+
+	if (perf_map_file == NULL && jitdump_file == NULL)
+	{
+		return;
+	}
+
+	debug_info_label (start, label, 256);
+	snprintf ((char *) name, 512, "l1vm_jit:%s:%lli-%lli", label, start, end);
+
+	pthread_mutex_lock (&perf_mutex);
+	if (perf_map_file)
+	{
+		fprintf (perf_map_file, "%llx %llx %s\n", (unsigned long long) fn, (unsigned long long) size, name);
+		fflush (perf_map_file);
+	}
+
+	if (jitdump_file)
+	{
+		memset (&load, 0, sizeof (load));
+		load.head.id = JIT_CODE_LOAD;
+		load.head.total_size = sizeof (load) + strlen ((const char *) name) + 1 + size;
+		load.head.timestamp = perf_time ();
+		load.pid = getpid ();
+		load.tid = syscall (SYS_gettid);
+		load.vma = (uint64_t) fn;
+		load.code_addr = (uint64_t) fn;
+		load.code_size = size;
+		load.code_index = jitdump_index++;
+		fwrite (&load, sizeof (load), 1, jitdump_file);
+		fwrite (name, strlen ((const char *) name) + 1, 1, jitdump_file);
+		fwrite (fn, size, 1, jitdump_file);
+		fflush (jitdump_file);
+	}
+	pthread_mutex_unlock (&perf_mutex);
+}
+
+static void perf_write_ep (U1 *name)
+{
+	FILE *fptr;
+	U1 file_name[256];
+	U1 label[256];
+	U1 cwd[512];
+	S8 i ALIGN;
+
+	snprintf ((char *) file_name, 256, "/tmp/perf-%i.l1ep", (int) getpid ());
+	fptr = fopen ((const char *) file_name, "w");
+	if (fptr == NULL)
+	{
+		printf ("perf: ERROR: can't write '%s'!\n", file_name);
+		return;
+	}
+
+	if (getcwd ((char *) cwd, 512) == NULL)
+	{
+		strcpy ((char *) cwd, ".");
+	}
+	fprintf (fptr, "# l1vm epos log: %s/%s, %lli entries, %lli dropped\n", cwd, name, perf_ep_ind, perf_ep_dropped);
+	fprintf (fptr, "# time tid epos line label\n");
+	for (i = 0; i < perf_ep_ind; i++)
+	{
+		debug_info_label (perf_ep[i].ep, label, 256);
+		fprintf (fptr, "%lli.%06lli %lli %lli %lli %s\n", perf_ep[i].time / 1000000000LL, (perf_ep[i].time % 1000000000LL) / 1000, perf_ep[i].tid, perf_ep[i].ep, debug_info_line (perf_ep[i].ep), label);
+	}
+	fclose (fptr);
+	printf ("perf: %lli epos entries written to %s\n", perf_ep_ind, file_name);
+}
+
+void perf_end (U1 *name)
+{
+	struct jitdump_record close_rec;
+
+	if (perf_ep_running)
+	{
+		perf_ep_stop = 1;
+		pthread_join (perf_ep_thread, NULL);
+		perf_ep_running = 0;
+		perf_write_ep (name);
+	}
+	if (perf_ep) free (perf_ep);
+	perf_ep = NULL;
+
+	pthread_mutex_lock (&perf_mutex);
+	if (perf_map_file)
+	{
+		// the map file stays for "perf report"
+		fclose (perf_map_file);
+		perf_map_file = NULL;
+	}
+
+	if (jitdump_file)
+	{
+		memset (&close_rec, 0, sizeof (close_rec));
+		close_rec.id = JIT_CODE_CLOSE;
+		close_rec.total_size = sizeof (close_rec);
+		close_rec.timestamp = perf_time ();
+		fwrite (&close_rec, sizeof (close_rec), 1, jitdump_file);
+		fclose (jitdump_file);
+		jitdump_file = NULL;
+	}
+	if (jitdump_mem)
+	{
+		munmap (jitdump_mem, jitdump_mem_size);
+		jitdump_mem = NULL;
+	}
+	pthread_mutex_unlock (&perf_mutex);
+}
+#endif
@@ -0,0 +1,417 @@
+/*
+ * This file profile.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1vm RISC VM
+//
+//  sampling profiler: "-P" flag
+//
+//  A SIGPROF timer (PROFILE_INTERVAL of CPU time) samples the epos and the jsr jumpstack
+//  of the running VM thread. At exit the samples are mapped to labels and assembly lines
+//  by the .l1dbg and .l1asm files of the program and written to:
+//  prog.l1prof		flat profile: samples per thread, per label and per line
+//  prog.l1folded	folded stacks for flamegraph tools: "thread 0;main;func;loop 123"
+
+#include "../include/global.h"
+
+#if PROFILE && __linux__
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PROFILE_BUF_SIZE		4194304		// sample buffer in S8 words
+#define PROFILE_MAXDEPTH		64			// saved jumpstack entries per sample
+
+// sample: cpu, depth, epos, jumpstack[0] ... jumpstack[depth - 1]
+#define PROFILE_SAMPLE_HEAD		3
+
+extern U1 *code;
+extern S8 code_size ALIGN;
+extern S8 max_cpu ALIGN;
+
+S2 debug_info_load (U1 *name);
+S8 debug_info_line (S8 epos);
+U1 *debug_info_asm_line (S8 line);
+void debug_info_label (S8 epos, U1 *name, S8 len);
+
+U1 profile_run = 0;							// "-P" flag
+
+#if PERF_MAP
+extern U1 perf_run;							// "-m" flag: epos log for perf
+#endif
+
+struct profile_thread *profile_thread = NULL;
+static __thread S8 profile_cpu = -1;		// VM thread of the running pthread
+
+static S8 *profile_buf = NULL;
+static volatile S8 profile_buf_ind ALIGN = 0;
+static volatile S8 profile_dropped ALIGN = 0;
+
+struct profile_count
+{
+	U1 *name;
+	S8 count ALIGN;
+};
+
+static void profile_handler (int sig)
+{
+	struct profile_thread *thread;
+	S8 depth ALIGN;
+	S8 pos ALIGN;
+	S8 i ALIGN;
+
+	if (profile_cpu < 0 || profile_buf == NULL)
+	{
+		return;
+	}
+	thread = &profile_thread[profile_cpu];
+
+	depth = *thread->jumpstack_ind + 1;
+	if (depth < 0) depth = 0;
+	if (depth > PROFILE_MAXDEPTH) depth = PROFILE_MAXDEPTH;
+
+	pos = __sync_fetch_and_add (&profile_buf_ind, depth + PROFILE_SAMPLE_HEAD);
+	if (pos + depth + PROFILE_SAMPLE_HEAD > PROFILE_BUF_SIZE)
+	{
+		__sync_fetch_and_add (&profile_dropped, 1);
+		return;
+	}
+
+	profile_buf[pos] = profile_cpu;
+	profile_buf[pos + 1] = depth;
+	for (i = 0; i < depth; i++)
+	{
+		profile_buf[pos + PROFILE_SAMPLE_HEAD + i] = thread->jumpstack[i];
+	}
+	// written last: an epos of 0 marks the end of the samples
+	profile_buf[pos + 2] = thread->ep;
+}
+
+// VM thread states, used by the profiler and the perf epos log
+S2 profile_thread_alloc (void)
+{
+	if (profile_thread == NULL)
+	{
+		profile_thread = (struct profile_thread *) calloc (max_cpu, sizeof (struct profile_thread));
+	}
+	return (profile_thread == NULL);
+}
+
+S2 profile_start (void)
+{
+	struct sigaction sa;
+	struct itimerval timer;
+
+	profile_buf = (S8 *) calloc (PROFILE_BUF_SIZE, sizeof (S8));
+	if (profile_buf == NULL || profile_thread_alloc () != 0)
+	{
+		printf ("profile: ERROR: can't allocate sample buffer!\n");
+		return (1);
+	}
+
+	memset (&sa, 0, sizeof (sa));
+	sa.sa_handler = profile_handler;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset (&sa.sa_mask);
+	if (sigaction (SIGPROF, &sa, NULL) != 0)
+	{
+		printf ("profile: ERROR: can't set SIGPROF handler!\n");
+		return (1);
+	}
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = PROFILE_INTERVAL;
+	timer.it_value = timer.it_interval;
+	if (setitimer (ITIMER_PROF, &timer, NULL) != 0)
+	{
+		printf ("profile: ERROR: can't start profile timer!\n");
+		return (1);
+	}
+	return (0);
+}
+
+// called by run () on thread start, returns the place for the epos
+volatile S8 *profile_thread_start (S8 cpu_core, S8 startpos, S8 *jumpstack, volatile S8 *jumpstack_ind)
+{
+	static volatile S8 profile_ep_none ALIGN;
+
+	#if PERF_MAP
+	if ((profile_run == 0 && perf_run == 0) || profile_thread == NULL)
+	#else
+	if (profile_run == 0 || profile_thread == NULL)
+	#endif
+	{
+		return (&profile_ep_none);
+	}
+
+	profile_thread[cpu_core].ep = startpos;
+	profile_thread[cpu_core].startpos = startpos;
+	profile_thread[cpu_core].jumpstack = jumpstack;
+	profile_thread[cpu_core].jumpstack_ind = jumpstack_ind;
+	profile_thread[cpu_core].tid = syscall (SYS_gettid);
+	profile_cpu = cpu_core;
+	return (&profile_thread[cpu_core].ep);
+}
+
+static void profile_stop (void)
+{
+	struct itimerval timer;
+
+	memset (&timer, 0, sizeof (timer));
+	setitimer (ITIMER_PROF, &timer, NULL);
+	signal (SIGPROF, SIG_IGN);
+}
+
+// function of a jumpstack entry: target of the jsr before the return address
+static void get_call_name (S8 ret, U1 *name, S8 len)
+{
+	S8 target ALIGN;
+
+	if (ret - 9 >= 16 && ret - 9 < code_size && code[ret - 9] == JSR)
+	{
+		memcpy (&target, &code[ret - 8], sizeof (S8));
+		debug_info_label (target, name, len);
+		return;
+	}
+	// jsra: target is not known any more
+	debug_info_label (ret - 2, name, len);
+	strncat ((char *) name, "_jsra", len - strlen ((const char *) name) - 1);
+}
+
+static int compare_count (const void *a, const void *b)
+{
+	const struct profile_count *ca = (const struct profile_count *) a;
+	const struct profile_count *cb = (const struct profile_count *) b;
+
+	if (ca->count < cb->count) return (1);
+	if (ca->count > cb->count) return (-1);
+	return (strcmp ((const char *) ca->name, (const char *) cb->name));
+}
+
+static int compare_name (const void *a, const void *b)
+{
+	return (strcmp ((const char *) ((const struct profile_count *) a)->name, (const char *) ((const struct profile_count *) b)->name));
+}
+
+// sort names and count the same names: returns the number of different names
+static S8 count_names (struct profile_count *list, S8 n)
+{
+	S8 i ALIGN;
+	S8 j ALIGN = -1;
+
+	qsort (list, n, sizeof (struct profile_count), compare_name);
+	for (i = 0; i < n; i++)
+	{
+		if (j >= 0 && strcmp ((const char *) list[j].name, (const char *) list[i].name) == 0)
+		{
+			list[j].count = list[j].count + list[i].count;
+			free (list[i].name);
+			continue;
+		}
+		j++;
+		list[j] = list[i];
+	}
+	qsort (list, j + 1, sizeof (struct profile_count), compare_count);
+	return (j + 1);
+}
+
+static void free_names (struct profile_count *list, S8 n)
+{
+	S8 i ALIGN;
+
+	for (i = 0; i < n; i++)
+	{
+		free (list[i].name);
+	}
+	free (list);
+}
+
+void profile_write (U1 *name)
+{
+	FILE *fptr;
+	U1 file_name[512];
+	U1 label[256];
+	U1 stack[4096];
+	struct profile_count *labels;
+	struct profile_count *lines;
+	struct profile_count *stacks;
+	S8 *thread_samples;
+	S8 samples ALIGN = 0;
+	S8 labels_n ALIGN;
+	S8 lines_n ALIGN;
+	S8 stacks_n ALIGN;
+	S8 pos ALIGN;
+	S8 cpu ALIGN;
+	S8 depth ALIGN;
+	S8 epos ALIGN;
+	S8 line ALIGN;
+	S8 i ALIGN;
+
+	if (profile_run == 0 || profile_buf == NULL)
+	{
+		return;
+	}
+	profile_run = 0;
+	profile_stop ();
+
+	// count the samples
+	for (pos = 0; pos + PROFILE_SAMPLE_HEAD <= PROFILE_BUF_SIZE && profile_buf[pos + 2] != 0; pos = pos + PROFILE_SAMPLE_HEAD + profile_buf[pos + 1])
+	{
+		samples++;
+	}
+
+	labels = (struct profile_count *) calloc (samples + 1, sizeof (struct profile_count));
+	lines = (struct profile_count *) calloc (samples + 1, sizeof (struct profile_count));
+	stacks = (struct profile_count *) calloc (samples + 1, sizeof (struct profile_count));
+	thread_samples = (S8 *) calloc (max_cpu, sizeof (S8));
+	if (labels == NULL || lines == NULL || stacks == NULL || thread_samples == NULL)
+	{
+		printf ("profile: ERROR: can't allocate memory for the profile!\n");
+		free (labels);
+		free (lines);
+		free (stacks);
+		free (thread_samples);
+		free (profile_buf);
+		profile_buf = NULL;
+		return;
+	}
+
+	debug_info_load (name);
+
+	for (pos = 0, i = 0; i < samples; pos = pos + PROFILE_SAMPLE_HEAD + profile_buf[pos + 1], i++)
+	{
+		cpu = profile_buf[pos];
+		depth = profile_buf[pos + 1];
+		epos = profile_buf[pos + 2];
+		thread_samples[cpu]++;
+
+		// sampled at a jsr which already set its return address: the jsr belongs to the caller
+		if (depth > 0 && depth < PROFILE_MAXDEPTH && (profile_buf[pos + PROFILE_SAMPLE_HEAD + depth - 1] - 9 == epos || profile_buf[pos + PROFILE_SAMPLE_HEAD + depth - 1] - 2 == epos))
+		{
+			depth--;
+		}
+
+		debug_info_label (epos, label, 256);
+		labels[i].name = (U1 *) strdup ((const char *) label);
+		labels[i].count = 1;
+
+		line = debug_info_line (epos);
+		snprintf ((char *) stack, 4096, "%8lli  %6lli  %s", epos, line, debug_info_asm_line (line));
+		lines[i].name = (U1 *) strdup ((const char *) stack);
+		lines[i].count = 1;
+
+		// folded stack: thread;start function;called functions;label of epos
+		snprintf ((char *) stack, 4096, "thread %lli;", cpu);
+		debug_info_label (profile_thread[cpu].startpos, label, 256);
+		strncat ((char *) stack, (const char *) label, 4095 - strlen ((const char *) stack));
+		for (line = 0; line < depth; line++)
+		{
+			get_call_name (profile_buf[pos + PROFILE_SAMPLE_HEAD + line], label, 256);
+			strncat ((char *) stack, ";", 4095 - strlen ((const char *) stack));
+			strncat ((char *) stack, (const char *) label, 4095 - strlen ((const char *) stack));
+		}
+		debug_info_label (epos, label, 256);
+		if (strlen ((const char *) stack) < strlen ((const char *) label) || strcmp ((const char *) stack + strlen ((const char *) stack) - strlen ((const char *) label), (const char *) label) != 0)
+		{
+			strncat ((char *) stack, ";", 4095 - strlen ((const char *) stack));
+			strncat ((char *) stack, (const char *) label, 4095 - strlen ((const char *) stack));
+		}
+		stacks[i].name = (U1 *) strdup ((const char *) stack);
+		stacks[i].count = 1;
+
+		if (labels[i].name == NULL || lines[i].name == NULL || stacks[i].name == NULL)
+		{
+			// drop this sample: write the samples before it
+			printf ("profile: ERROR: can't allocate memory for the profile!\n");
+			free (labels[i].name);
+			free (lines[i].name);
+			free (stacks[i].name);
+			thread_samples[cpu]--;
+			samples = i;
+			break;
+		}
+	}
+
+	labels_n = count_names (labels, samples);
+	lines_n = count_names (lines, samples);
+	stacks_n = count_names (stacks, samples);
+
+	// flat profile
+	snprintf ((char *) file_name, 512, "%s.l1prof", name);
+	fptr = fopen ((const char *) file_name, "w");
+	if (fptr == NULL)
+	{
+		printf ("profile: ERROR: can't write '%s'!\n", file_name);
+	}
+	else
+	{
+		fprintf (fptr, "l1vm profile: %s, %lli samples every %i us CPU time, %lli dropped\n", name, samples, PROFILE_INTERVAL, profile_dropped);
+		fprintf (fptr, "JIT and AOT code time counts at the opcode which started it.\n\n");
+
+		fprintf (fptr, "samples per thread\n");
+		for (cpu = 0; cpu < max_cpu; cpu++)
+		{
+			if (thread_samples[cpu] > 0)
+			{
+				fprintf (fptr, "thread %lli: %lli\n", cpu, thread_samples[cpu]);
+			}
+		}
+
+		fprintf (fptr, "\nsamples per label\n");
+		fprintf (fptr, " samples  percent  label\n");
+		for (i = 0; i < labels_n; i++)
+		{
+			fprintf (fptr, "%8lli  %6.2f%%  %s\n", labels[i].count, (F8) labels[i].count * 100.0 / (F8) samples, labels[i].name);
+		}
+
+		fprintf (fptr, "\nsamples per line\n");
+		fprintf (fptr, " samples  percent      epos    line  code\n");
+		for (i = 0; i < lines_n; i++)
+		{
+			fprintf (fptr, "%8lli  %6.2f%%  %s\n", lines[i].count, (F8) lines[i].count * 100.0 / (F8) samples, lines[i].name);
+		}
+		fclose (fptr);
+	}
+
+	// folded stacks
+	snprintf ((char *) file_name, 512, "%s.l1folded", name);
+	fptr = fopen ((const char *) file_name, "w");
+	if (fptr == NULL)
+	{
+		printf ("profile: ERROR: can't write '%s'!\n", file_name);
+	}
+	else
+	{
+		for (i = 0; i < stacks_n; i++)
+		{
+			fprintf (fptr, "%s %lli\n", stacks[i].name, stacks[i].count);
+		}
+		fclose (fptr);
+	}
+
+	printf ("profile: %lli samples written to %s.l1prof and %s.l1folded\n", samples, name, name);
+
+	free_names (labels, labels_n);
+	free_names (lines, lines_n);
+	free_names (stacks, stacks_n);
+	free (thread_samples);
+	free (profile_buf);
+	profile_buf = NULL;
+}
+#endif
@@ -0,0 +1,296 @@
+/*
+ * This file trace.c is part of L1vm.
+ *
+ * (c) Copyright Stefan Pietzonke (jay-t@gmx.net), 2021
+ *
+ * L1vm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * L1vm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with L1vm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  l1vm RISC VM
+//
+//  thread trace: "-t" flag
+//
+//  Records the VM thread start and exit, thread spawn (intr1 0), join wait (intr1 1),
+//  data_mutex wait and hold time (intr1 2/3) and module calls (intr0 3) of every VM thread.
+//  At exit the events are written to prog.trace.json in the Chrome trace event format,
+//  to be loaded in chrome://tracing or https://ui.perfetto.dev
+
+#include "../include/global.h"
+
+#if TRACE && __linux__
+#include <dlfcn.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TRACE_BUF_SIZE		1048576		// events
+
+#define TRACE_THREAD_START	0
+#define TRACE_THREAD_EXIT	1
+#define TRACE_SPAWN			2
+#define TRACE_JOIN			3
+#define TRACE_MUTEX_WAIT	4
+#define TRACE_MUTEX_HOLD	5
+#define TRACE_MODULE		6
+
+struct trace_event
+{
+	S8 ts ALIGN;			// nanoseconds since trace start
+	S8 dur ALIGN;			// nanoseconds
+	S8 arg ALIGN;
+	S8 arg2 ALIGN;
+	void *func;				// module function
+	S8 cpu ALIGN;
+	U1 type;
+};
+
+extern S8 max_cpu ALIGN;
+
+U1 trace_run = 0;							// "-t" flag
+
+static struct trace_event *trace_buf = NULL;
+static volatile S8 trace_buf_ind ALIGN = 0;
+static volatile S8 trace_dropped ALIGN = 0;
+static S8 trace_start_time ALIGN = 0;
+static __thread S8 trace_cpu = 0;			// VM thread of the running pthread
+static __thread S8 trace_hold_start = -1;	// data_mutex locked at
+
+static S8 trace_clock (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((S8) ts.tv_sec * 1000000000LL + ts.tv_nsec);
+}
+
+// time for the start of an event, 0 if not tracing
+S8 trace_time (void)
+{
+	if (trace_run == 0)
+	{
+		return (0);
+	}
+	return (trace_clock () - trace_start_time);
+}
+
+static void trace_add (U1 type, S8 ts, S8 dur, S8 arg, S8 arg2, void *func)
+{
+	S8 ind ALIGN;
+
+	if (trace_buf == NULL)
+	{
+		return;
+	}
+
+	ind = __sync_fetch_and_add (&trace_buf_ind, 1);
+	if (ind >= TRACE_BUF_SIZE)
+	{
+		__sync_fetch_and_add (&trace_dropped, 1);
+		return;
+	}
+	trace_buf[ind].type = type;
+	trace_buf[ind].ts = ts;
+	trace_buf[ind].dur = dur;
+	trace_buf[ind].arg = arg;
+	trace_buf[ind].arg2 = arg2;
+	trace_buf[ind].func = func;
+	trace_buf[ind].cpu = trace_cpu;
+}
+
+S2 trace_init (void)
+{
+	trace_buf = (struct trace_event *) calloc (TRACE_BUF_SIZE, sizeof (struct trace_event));
+	if (trace_buf == NULL)
+	{
+		printf ("trace: ERROR: can't allocate event buffer!\n");
+		return (1);
+	}
+	trace_start_time = trace_clock ();
+	return (0);
+}
+
+// called by run () on thread start
+void trace_thread_start (S8 cpu_core, S8 startpos)
+{
+	if (trace_run == 0)
+	{
+		return;
+	}
+	trace_cpu = cpu_core;
+	trace_hold_start = -1;
+	trace_add (TRACE_THREAD_START, trace_time (), 0, startpos, 0, NULL);
+}
+
+void trace_thread_exit (S8 retcode)
+{
+	if (trace_run == 0)
+	{
+		return;
+	}
+	trace_add (TRACE_THREAD_EXIT, trace_time (), 0, retcode, 0, NULL);
+}
+
+void trace_spawn (S8 new_cpu, S8 startpos)
+{
+	if (trace_run == 0)
+	{
+		return;
+	}
+	trace_add (TRACE_SPAWN, trace_time (), 0, new_cpu, startpos, NULL);
+}
+
+void trace_join (S8 start)
+{
+	if (trace_run == 0)
+	{
+		return;
+	}
+	trace_add (TRACE_JOIN, start, trace_time () - start, 0, 0, NULL);
+}
+
+void trace_mutex_locked (S8 start)
+{
+	if (trace_run == 0)
+	{
+		return;
+	}
+	trace_hold_start = trace_time ();
+	trace_add (TRACE_MUTEX_WAIT, start, trace_hold_start - start, 0, 0, NULL);
+}
+
+void trace_mutex_unlock (void)
+{
+	if (trace_run == 0 || trace_hold_start < 0)
+	{
+		return;
+	}
+	trace_add (TRACE_MUTEX_HOLD, trace_hold_start, trace_time () - trace_hold_start, 0, 0, NULL);
+	trace_hold_start = -1;
+}
+
+void trace_module (void *func, S8 ind, S8 func_ind, S8 start)
+{
+	if (trace_run == 0)
+	{
+		return;
+	}
+	trace_add (TRACE_MODULE, start, trace_time () - start, ind, func_ind, func);
+}
+
+static void write_event (FILE *fptr, struct trace_event *event, int pid)
+{
+	Dl_info info;
+	const char *module;
+	const char *name;
+
+	// time in microseconds
+	switch (event->type)
+	{
+		case TRACE_THREAD_START:
+			fprintf (fptr, "{\"name\":\"thread %lli\",\"cat\":\"thread\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":%i,\"tid\":%lli,\"args\":{\"epos\":%lli}}", event->cpu, event->ts / 1000.0, pid, event->cpu, event->arg);
+			break;
+
+		case TRACE_THREAD_EXIT:
+			fprintf (fptr, "{\"name\":\"thread %lli\",\"cat\":\"thread\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":%i,\"tid\":%lli,\"args\":{\"retcode\":%lli}}", event->cpu, event->ts / 1000.0, pid, event->cpu, event->arg);
+			break;
+
+		case TRACE_SPAWN:
+			fprintf (fptr, "{\"name\":\"spawn thread %lli\",\"cat\":\"thread\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%i,\"tid\":%lli,\"args\":{\"thread\":%lli,\"epos\":%lli}}", event->arg, event->ts / 1000.0, pid, event->cpu, event->arg, event->arg2);
+			break;
+
+		case TRACE_JOIN:
+			fprintf (fptr, "{\"name\":\"join wait\",\"cat\":\"thread\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%i,\"tid\":%lli}", event->ts / 1000.0, event->dur / 1000.0, pid, event->cpu);
+			break;
+
+		case TRACE_MUTEX_WAIT:
+			fprintf (fptr, "{\"name\":\"mutex wait\",\"cat\":\"mutex\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%i,\"tid\":%lli}", event->ts / 1000.0, event->dur / 1000.0, pid, event->cpu);
+			break;
+
+		case TRACE_MUTEX_HOLD:
+			fprintf (fptr, "{\"name\":\"mutex hold\",\"cat\":\"mutex\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%i,\"tid\":%lli}", event->ts / 1000.0, event->dur / 1000.0, pid, event->cpu);
+			break;
+
+		case TRACE_MODULE:
+			// the names of modules which are still loaded
+			module = "module";
+			name = "function";
+			if (dladdr (event->func, &info) != 0)
+			{
+				if (info.dli_fname)
+				{
+					module = strrchr (info.dli_fname, '/') ? strrchr (info.dli_fname, '/') + 1 : info.dli_fname;
+				}
+				if (info.dli_sname)
+				{
+					name = info.dli_sname;
+				}
+			}
+			fprintf (fptr, "{\"name\":\"%s\",\"cat\":\"module\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%i,\"tid\":%lli,\"args\":{\"module\":\"%s\",\"index\":%lli,\"function\":%lli}}", name, event->ts / 1000.0, event->dur / 1000.0, pid, event->cpu, module, event->arg, event->arg2);
+			break;
+	}
+}
+
+void trace_write (U1 *name)
+{
+	FILE *fptr;
+	U1 file_name[512];
+	U1 *threads;
+	S8 events ALIGN;
+	S8 i ALIGN;
+	int pid;
+
+	if (trace_run == 0 || trace_buf == NULL)
+	{
+		return;
+	}
+	trace_run = 0;
+
+	snprintf ((char *) file_name, 512, "%s.trace.json", name);
+	fptr = fopen ((const char *) file_name, "w");
+	threads = (U1 *) calloc (max_cpu, sizeof (U1));
+	if (fptr == NULL || threads == NULL)
+	{
+		printf ("trace: ERROR: can't write '%s'!\n", file_name);
+		if (fptr) fclose (fptr);
+		if (threads) free (threads);
+		return;
+	}
+
+	events = trace_buf_ind;
+	if (events > TRACE_BUF_SIZE)
+	{
+		events = TRACE_BUF_SIZE;
+	}
+	pid = getpid ();
+
+	fprintf (fptr, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"program\":\"%s\",\"dropped\":%lli},\"traceEvents\":[\n", name, trace_dropped);
+	fprintf (fptr, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%i,\"args\":{\"name\":\"l1vm %s\"}}", pid, name);
+	for (i = 0; i < events; i++)
+	{
+		if (trace_buf[i].cpu >= 0 && trace_buf[i].cpu < max_cpu && threads[trace_buf[i].cpu] == 0)
+		{
+			threads[trace_buf[i].cpu] = 1;
+			fprintf (fptr, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%i,\"tid\":%lli,\"args\":{\"name\":\"VM thread %lli\"}}", pid, trace_buf[i].cpu, trace_buf[i].cpu);
+		}
+		fprintf (fptr, ",\n");
+		write_event (fptr, &trace_buf[i], pid);
+	}
+	fprintf (fptr, "\n]}\n");
+	fclose (fptr);
+	free (threads);
+
+	printf ("trace: %lli events written to %s\n", events, file_name);
+	free (trace_buf);
+	trace_buf = NULL;
+}
+#endif